@@ -60,6 +60,10 @@ class AppDelegate: NSObject, NSApplicationDelegate, ObservableObject {
         CapsWriterApp.sharedAppDelegate = nil
         print("✅ 静态引用已清理")
         
+        // 落盘尚未写出的转录记录和日志
+        TranscriptHistoryStore.shared.flush()
+        LoggingService.shared.flush()
+        
         print("🛑 AppDelegate: 资源清理完成")
     }
     
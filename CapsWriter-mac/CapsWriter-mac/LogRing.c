@@ -0,0 +1,153 @@
+//
+//  LogRing.c
+//  CapsWriter-mac
+//
+//  日志环形缓冲区实现
+//
+
+#include "LogRing.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CW_LOG_RING_CAPACITY 1024           // 每个线程的环容量，必须是 2 的幂
+#define CW_LOG_MAX_RINGS 64                 // 最多同时写日志的线程数
+
+typedef struct {
+    _Atomic uint64_t head;                  // 下一个要写的位置，只有生产者线程修改
+    _Atomic uint64_t tail;                  // 下一个要读的位置，只有写入线程修改
+    _Atomic int in_use;                     // 0 空闲；1 线程使用中；2 线程已退出，取空后回收
+    cw_log_record records[CW_LOG_RING_CAPACITY];
+} cw_log_ring;
+
+static cw_log_ring *rings[CW_LOG_MAX_RINGS];
+static _Atomic size_t ring_count = 0;
+static _Atomic uint64_t dropped = 0;
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ring_key;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+
+static void release_ring(void *ring) {
+    // 线程退出：标记为待回收，写入线程取空后再交给新线程使用
+    atomic_store_explicit(&((cw_log_ring *)ring)->in_use, 2, memory_order_release);
+}
+
+static void make_key(void) {
+    pthread_key_create(&ring_key, release_ring);
+}
+
+static cw_log_ring *acquire_ring(void) {
+    // 每个线程只在第一次写日志时进入这里
+    pthread_mutex_lock(&registry_lock);
+    cw_log_ring *ring = NULL;
+    size_t count = atomic_load_explicit(&ring_count, memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&rings[i]->in_use, &expected, 1)) {
+            ring = rings[i];
+            break;
+        }
+    }
+    if (!ring && count < CW_LOG_MAX_RINGS) {
+        ring = calloc(1, sizeof(cw_log_ring));
+        if (ring) {
+            atomic_store(&ring->in_use, 1);
+            rings[count] = ring;
+            atomic_store_explicit(&ring_count, count + 1, memory_order_release);
+        }
+    }
+    pthread_mutex_unlock(&registry_lock);
+    return ring;
+}
+
+static void copy_name(char *dst, const char *src) {
+    if (!src) {
+        dst[0] = 0;
+        return;
+    }
+    const char *slash = strrchr(src, '/');
+    if (slash) {
+        src = slash + 1;
+    }
+    size_t n = strlen(src);
+    if (n >= CW_LOG_NAME_SIZE) {
+        n = CW_LOG_NAME_SIZE - 1;
+    }
+    memcpy(dst, src, n);
+    dst[n] = 0;
+}
+
+bool cw_log_push(double timestamp, uint8_t level, uint8_t category, uint32_t line,
+                 const char *file, const char *function, const char *message, size_t message_length) {
+    pthread_once(&key_once, make_key);
+    cw_log_ring *ring = pthread_getspecific(ring_key);
+    if (!ring) {
+        ring = acquire_ring();
+        if (!ring) {
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return false;
+        }
+        pthread_setspecific(ring_key, ring);
+    }
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= CW_LOG_RING_CAPACITY) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    cw_log_record *record = &ring->records[head & (CW_LOG_RING_CAPACITY - 1)];
+    record->timestamp = timestamp;
+    record->level = level;
+    record->category = category;
+    record->line = line;
+    record->is_main_thread = pthread_main_np() ? 1 : 0;
+    pthread_threadid_np(NULL, &record->thread_id);
+    copy_name(record->file, file);
+    copy_name(record->function, function);
+
+    // 截断时退回到 UTF-8 字符边界
+    size_t n = message ? message_length : 0;
+    record->truncated = 0;
+    if (n >= CW_LOG_MESSAGE_SIZE) {
+        n = CW_LOG_MESSAGE_SIZE - 1;
+        while (n > 0 && ((unsigned char)message[n] & 0xC0) == 0x80) {
+            n--;
+        }
+        record->truncated = 1;
+    }
+    memcpy(record->message, message, n);
+    record->message[n] = 0;
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+size_t cw_log_drain(cw_log_record *out, size_t max_count) {
+    size_t taken = 0;
+    size_t count = atomic_load_explicit(&ring_count, memory_order_acquire);
+    for (size_t i = 0; i < count && taken < max_count; i++) {
+        cw_log_ring *ring = rings[i];
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        while (tail < head && taken < max_count) {
+            out[taken++] = ring->records[tail & (CW_LOG_RING_CAPACITY - 1)];
+            tail++;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+        // 已退出线程的环取空后回收
+        int exited = 2;
+        if (tail == head) {
+            atomic_compare_exchange_strong(&ring->in_use, &exited, 0);
+        }
+    }
+    return taken;
+}
+
+uint64_t cw_log_take_dropped(void) {
+    return atomic_exchange_explicit(&dropped, 0, memory_order_relaxed);
+}
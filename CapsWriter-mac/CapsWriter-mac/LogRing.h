@@ -0,0 +1,48 @@
+//
+//  LogRing.h
+//  CapsWriter-mac
+//
+//  日志环形缓冲区 - 每个线程一个单生产者/单消费者无锁环
+//
+//  写日志的线程只把原始字段拷贝进自己线程的环（不格式化、不分配内存、不加锁），
+//  由唯一的写入线程批量取出后再格式化输出。环满时丢弃并计数，绝不阻塞写日志的线程，
+//  所以可以在音频回调里使用。
+//
+
+#ifndef LogRing_h
+#define LogRing_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define CW_LOG_MESSAGE_SIZE 232
+#define CW_LOG_NAME_SIZE 48
+
+/// 一条未格式化的日志记录
+typedef struct {
+    double timestamp;                       // 自 1970 年起的秒数
+    uint64_t thread_id;
+    uint32_t line;
+    uint8_t level;
+    uint8_t category;
+    uint8_t is_main_thread;
+    uint8_t truncated;                      // 消息超长被截断
+    char file[CW_LOG_NAME_SIZE];
+    char function[CW_LOG_NAME_SIZE];
+    char message[CW_LOG_MESSAGE_SIZE];
+} cw_log_record;
+
+/// 把记录写入当前线程的环，环满或线程数超限时丢弃并返回 false
+/// file 只保留最后一个路径分量，字符串按 UTF-8 截断到缓冲区大小
+bool cw_log_push(double timestamp, uint8_t level, uint8_t category, uint32_t line,
+                 const char *file, const char *function, const char *message, size_t message_length);
+
+/// 由写入线程调用：从所有线程的环中最多取出 max_count 条记录，返回实际条数
+/// 同一线程的记录保持顺序，不同线程之间按环的顺序依次取
+size_t cw_log_drain(cw_log_record *out, size_t max_count);
+
+/// 自上次调用以来被丢弃的记录数
+uint64_t cw_log_take_dropped(void);
+
+#endif /* LogRing_h */
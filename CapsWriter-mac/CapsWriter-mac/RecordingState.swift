@@ -38,8 +38,8 @@ class RecordingState: ObservableObject {
     /// 文本输入权限状态
     @Published var hasTextInputPermission: Bool = false
     
-    /// 转录历史记录
-    @Published var transcriptHistory: [TranscriptEntry] = []
+    /// 转录历史记录（最近的窗口，与 SherpaASRService 共用同一个存储）
+    var transcriptHistory: [TranscriptEntry] { historyStore.window }
     
     /// 当前部分转录文本
     @Published var partialTranscript: String = ""
@@ -49,6 +49,9 @@ class RecordingState: ObservableObject {
     // StateManager 通过 DIContainer 动态解析，避免循环依赖
     private var cancellables = Set<AnyCancellable>()
     
+    /// 转录历史存储
+    let historyStore = TranscriptHistoryStore.shared
+    
     // 用户手动停止标志（保持向后兼容）
     private let stateQueue = DispatchQueue(label: "com.capswriter.recording-state", attributes: .concurrent)
     private var _isManuallyStoppedByUser: Bool = false
@@ -72,6 +75,18 @@ class RecordingState: ObservableObject {
     
     private init() {
         setupStateBindings()
+        setupHistoryBinding()
+    }
+    
+    /// 转录历史变化时通知界面刷新
+    /// 部分结果每秒会更新多次，合并成每 100ms 最多一次刷新
+    private func setupHistoryBinding() {
+        historyStore.changes
+            .throttle(for: .milliseconds(100), scheduler: DispatchQueue.main, latest: true)
+            .sink { [weak self] _ in
+                self?.objectWillChange.send()
+            }
+            .store(in: &cancellables)
     }
     
     // MARK: - State Binding
@@ -233,21 +248,12 @@ class RecordingState: ObservableObject {
     
     /// 更新转录历史记录
     func updateTranscriptHistory(_ entries: [TranscriptEntry]) {
-        DispatchQueue.main.async {
-            self.transcriptHistory = entries
-        }
+        historyStore.replaceWindow(entries)
     }
     
     /// 添加转录条目
     func addTranscriptEntry(_ entry: TranscriptEntry) {
-        DispatchQueue.main.async {
-            self.transcriptHistory.append(entry)
-            
-            // 保持历史记录不超过100条
-            if self.transcriptHistory.count > 100 {
-                self.transcriptHistory.removeFirst(self.transcriptHistory.count - 100)
-            }
-        }
+        historyStore.append(entry)
     }
     
     /// 更新部分转录文本
@@ -259,8 +265,8 @@ class RecordingState: ObservableObject {
     
     /// 清空转录历史记录
     func clearTranscriptHistory() {
+        historyStore.clear()
         DispatchQueue.main.async {
-            self.transcriptHistory.removeAll()
             self.partialTranscript = ""
         }
     }
@@ -4,12 +4,19 @@ import Combine
 
 // MARK: - Transcript Data Models
 
-struct TranscriptEntry: Identifiable, Equatable {
-    let id = UUID()
+struct TranscriptEntry: Identifiable, Equatable, Codable {
+    let id: UUID
     let timestamp: Date
     let text: String
     let isPartial: Bool
     
+    init(id: UUID = UUID(), timestamp: Date, text: String, isPartial: Bool) {
+        self.id = id
+        self.timestamp = timestamp
+        self.text = text
+        self.isPartial = isPartial
+    }
+    
     var formattedTime: String {
         let formatter = DateFormatter()
         formatter.dateFormat = "HH:mm:ss"
@@ -126,6 +133,17 @@ func sherpaOnnxFeatureConfig(
   )
 }
 
+/// Return an instance of SherpaOnnxOnlineCtcFstDecoderConfig.
+func sherpaOnnxOnlineCtcFstDecoderConfig(
+  graph: String = "",
+  maxActive: Int = 3000
+) -> SherpaOnnxOnlineCtcFstDecoderConfig {
+  return SherpaOnnxOnlineCtcFstDecoderConfig(
+    graph: toCPointer(graph),
+    max_active: Int32(maxActive)
+  )
+}
+
 /// Return an instance of SherpaOnnxOnlineRecognizerConfig.
 func sherpaOnnxOnlineRecognizerConfig(
   featConfig: SherpaOnnxFeatureConfig = sherpaOnnxFeatureConfig(),
@@ -137,7 +155,8 @@ func sherpaOnnxOnlineRecognizerConfig(
   rule2MinTrailingSilence: Float = 1.2,
   rule3MinUtteranceLength: Float = 20.0,
   hotwordsFile: String = "",
-  hotwordsScore: Float = 1.5
+  hotwordsScore: Float = 1.5,
+  ctcFstDecoderConfig: SherpaOnnxOnlineCtcFstDecoderConfig = sherpaOnnxOnlineCtcFstDecoderConfig()
 ) -> SherpaOnnxOnlineRecognizerConfig {
   return SherpaOnnxOnlineRecognizerConfig(
     feat_config: featConfig,
@@ -150,7 +169,7 @@ func sherpaOnnxOnlineRecognizerConfig(
     rule3_min_utterance_length: rule3MinUtteranceLength,
     hotwords_file: toCPointer(hotwordsFile),
     hotwords_score: hotwordsScore,
-    ctc_fst_decoder_config: SherpaOnnxOnlineCtcFstDecoderConfig(),
+    ctc_fst_decoder_config: ctcFstDecoderConfig,
     rule_fsts: nil,
     rule_fars: nil,
     blank_penalty: 0.0,
@@ -195,9 +214,12 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
     @Published var isServiceRunning: Bool = false
     @Published var isRecognizing: Bool = false
     @Published var isInitialized: Bool = false
-    @Published var transcriptHistory: [TranscriptEntry] = []
     @Published var partialTranscript: String = ""
     
+    /// 转录历史：最近的记录窗口，完整历史在磁盘日志中，见 TranscriptHistoryStore
+    let historyStore = TranscriptHistoryStore.shared
+    var transcriptHistory: [TranscriptEntry] { historyStore.window }
+    
     // MARK: - Private Properties
     private var recognizer: OpaquePointer?
     private var stream: OpaquePointer?
@@ -205,6 +227,22 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
     private let cleanupQueue = DispatchQueue(label: "com.capswriter.sherpa-cleanup", qos: .utility)
     private static var logCounter = 0
     
+    // 领域语法解码（只在 processingQueue 上切换）
+    /// 已创建的识别器和音频流，按语法配置名索引，"" 为自由解码；recognizer/stream 指向当前使用的一组
+    private var decoders: [String: (recognizer: OpaquePointer, stream: OpaquePointer)] = [:]
+    private var activeProfileName = ""
+    /// 当前识别器的模型类型，决定收尾补的静音和解码前瞻
+    private var activeModelType = ""
+    
+    // 自适应端点检测（以下状态只在 processingQueue 上访问）
+    private var endpointController: AdaptiveEndpointController?
+    /// 当前这句、整个会话已送入的采样数
+    private var segmentSampleCount = 0
+    private var sessionSampleCount = 0
+    /// 当前这句最后一个字的时间（秒）；没有时间戳时用识别文字最后一次变化的时间
+    private var lastTokenTime: TimeInterval?
+    private var lastResultText = ""
+    
     // Mock mode flag - 设置为 false 来启用真实模型
     private let isMockMode = false
     
@@ -336,20 +374,28 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
             addLog("🔄 模拟模式：跳过Sherpa识别器重置")
         } else {
             // 只有真实模式才检查并调用Sherpa C函数
-            guard let recognizer = self.recognizer else {
+            guard self.recognizer != nil else {
                 addLog("❌ recognizer 未初始化")
                 isRecognizing = false
                 return
             }
-            guard let stream = self.stream else {
+            guard self.stream != nil else {
                 addLog("❌ stream 未初始化") 
                 isRecognizing = false
                 return
             }
             
-            // 重置音频流准备新的识别会话
-            SherpaOnnxOnlineStreamReset(recognizer, stream)
-            addLog("🔄 音频流已重置，准备新的识别会话")
+            // 切换本次会话的语法配置，重置音频流准备新的识别会话（排在上一句的收尾解码之后）
+            processingQueue.async { [weak self] in
+                guard let self = self, !self.decoders.isEmpty else { return }
+                self.applyGrammarProfile(self.configManager.recognition.activeGrammarProfile)
+                guard let recognizer = self.recognizer, let stream = self.stream else { return }
+                SherpaOnnxOnlineStreamReset(recognizer, stream)
+                self.resetSegmentState()
+                self.sessionSampleCount = 0
+                self.endpointController?.endSession()
+                self.addLog("🔄 音频流已重置，准备新的识别会话")
+            }
         }
     }
     
@@ -362,14 +408,15 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
         addLog("⏹️ 停止语音识别处理...")
         isRecognizing = false
         
-        // Get final result from sherpa-onnx
-        if let finalResult = getFinalResult() {
-            transcript = finalResult
-            addLog("📝 最终识别结果: \(finalResult)")
-            delegate?.speechRecognitionDidReceiveFinalResult(finalResult)
+        if isMockMode {
+            addLog("✅ 语音识别处理已停止")
+            return
         }
         
-        addLog("✅ 语音识别处理已停止")
+        // 收尾解码排在已收到的音频之后，并提高优先级：松开按键到出字的等待最影响体验
+        processingQueue.async(qos: .userInteractive, flags: .enforceQoS) { [weak self] in
+            self?.finalizeRecognition()
+        }
     }
     
     // MARK: - Transcript Management
@@ -383,22 +430,15 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
             isPartial: isPartial
         )
         
-        // 在主线程更新UI
-        DispatchQueue.main.async {
-            self.transcriptHistory.append(entry)
-            
-            // 保持历史记录不超过100条
-            if self.transcriptHistory.count > 100 {
-                self.transcriptHistory.removeFirst(self.transcriptHistory.count - 100)
-            }
-        }
+        // 追加到历史存储：最终结果落盘，界面通过增量通知更新
+        historyStore.append(entry)
         
         addLog("📝 添加转录条目: \(text)")
     }
     
     func clearTranscriptHistory() {
+        historyStore.clear()
         DispatchQueue.main.async {
-            self.transcriptHistory.removeAll()
             self.partialTranscript = ""
         }
         addLog("🗑️ 转录历史已清空")
@@ -513,6 +553,13 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
                 featureDim: 80
             )
             
+            // 自适应端点检测自己判断句末，识别器内置的 rule2 放宽到上限，只作兜底
+            let recognitionConfig = configManager.recognition
+            let useAdaptiveEndpoint = recognitionConfig.enableEndpoint && recognitionConfig.enableAdaptiveEndpoint
+            let rule2 = useAdaptiveEndpoint
+                ? max(recognitionConfig.rule2MinTrailingSilence, recognitionConfig.adaptiveEndpointMaxSilence)
+                : recognitionConfig.rule2MinTrailingSilence
+            
             var config = sherpaOnnxOnlineRecognizerConfig(
                 featConfig: featConfig,
                 modelConfig: modelConfig,
@@ -520,10 +567,14 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
                 maxActivePaths: configManager.recognition.maxActivePaths,
                 enableEndpoint: configManager.recognition.enableEndpoint,
                 rule1MinTrailingSilence: configManager.recognition.rule1MinTrailingSilence,
-                rule2MinTrailingSilence: configManager.recognition.rule2MinTrailingSilence,
+                rule2MinTrailingSilence: rule2,
                 rule3MinUtteranceLength: configManager.recognition.rule3MinUtteranceLength
             )
             
+            if useAdaptiveEndpoint {
+                endpointController = makeEndpointController(recognitionConfig)
+            }
+            
             addLog("⚙️ 创建识别器实例...")
             RecordingState.shared.updateInitializationProgress("正在创建识别器...")
             
@@ -576,6 +627,10 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
                 return
             }
             
+            decoders[""] = (validRecognizer, stream!)
+            activeProfileName = ""
+            activeModelType = configManager.recognition.modelType
+            
             addLog("✅ 音频流创建成功")
             RecordingState.shared.updateInitializationProgress("初始化完成")
             isInitialized = true
@@ -592,6 +647,19 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
             addLog("✅ 模拟识别器资源已清理")
         } else {
             // 真实模式：调用Sherpa C函数清理
+            // 先切回自由解码的一组，再销毁语法解码的识别器
+            if let free = decoders[""] {
+                recognizer = free.recognizer
+                stream = free.stream
+            }
+            for (name, decoder) in decoders where !name.isEmpty {
+                SherpaOnnxDestroyOnlineStream(decoder.stream)
+                SherpaOnnxDestroyOnlineRecognizer(decoder.recognizer)
+                addLog("✅ 语法解码识别器已销毁: \(name)")
+            }
+            decoders.removeAll()
+            activeProfileName = ""
+            
             if let stream = stream {
                 SherpaOnnxDestroyOnlineStream(stream)
                 self.stream = nil
@@ -684,6 +752,11 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
             return
         }
         
+        segmentSampleCount += frameLength
+        sessionSampleCount += frameLength
+        // 最后一个块还在等右侧上下文，没有解码，按模型的前瞻长度扣掉
+        let decodedTime = max(0, Double(segmentSampleCount) / sampleRate - decodeLookahead)
+        
         // 🔒 安全检查：检查识别器是否准备好解码
         let isReady = SherpaOnnxIsOnlineStreamReady(recognizer, stream)
         if isReady == 1 {
@@ -694,6 +767,7 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
             if let result = SherpaOnnxGetOnlineStreamResult(recognizer, stream) {
                 // 🔒 安全文本提取：使用安全方法提取文本
                 let resultText = getTextFromResultSafely(result)
+                updateLastTokenTime(result, text: resultText, decodedTime: decodedTime)
                 
                 if !resultText.isEmpty {
                     DispatchQueue.main.async {
@@ -709,12 +783,15 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
         }
         
         // Check for endpoint detection
-        if SherpaOnnxOnlineStreamIsEndpoint(recognizer, stream) == 1 {
-            addLog("🔚 检测到语音端点")
+        let isBuiltInEndpoint = SherpaOnnxOnlineStreamIsEndpoint(recognizer, stream) == 1
+        let isAdaptiveEndpoint = endpointController?.isEndpoint(lastTokenTime: lastTokenTime, audioTime: decodedTime) ?? false
+        if isBuiltInEndpoint || isAdaptiveEndpoint {
+            addLog(isBuiltInEndpoint ? "🔚 检测到语音端点" : "🔚 检测到语音端点（自适应，静音阈值 \(String(format: "%.2f", endpointController?.trailingSilenceThreshold ?? 0))s）")
             
             // Get final result
             if let result = SherpaOnnxGetOnlineStreamResult(recognizer, stream) {
                 let finalText = getTextFromResult(result)
+                learnPauses(from: StreamFinalizer.tokenTimes(of: result))
                 
                 if !finalText.isEmpty {
                     DispatchQueue.main.async {
@@ -734,6 +811,7 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
             
             // Reset the stream for next utterance
             SherpaOnnxOnlineStreamReset(recognizer, stream)
+            resetSegmentState()
         }
         
         // Log audio processing (less frequently)
@@ -748,6 +826,128 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
         }
     }
     
+    // MARK: - Adaptive Endpoint
+    
+    /// 模型解码需要的前瞻音频长度（秒）
+    private var decodeLookahead: TimeInterval {
+        StreamFinalizer.tailPadding(forModelType: activeModelType)
+    }
+    
+    private func makeEndpointController(_ config: RecognitionConfiguration) -> AdaptiveEndpointController {
+        var endpointConfig = AdaptiveEndpointController.Configuration()
+        endpointConfig.minimumSilence = TimeInterval(config.adaptiveEndpointMinSilence)
+        endpointConfig.maximumSilence = TimeInterval(config.adaptiveEndpointMaxSilence)
+        endpointConfig.fallbackSilence = TimeInterval(config.rule2MinTrailingSilence)
+        endpointConfig.noSpeechSilence = TimeInterval(config.rule1MinTrailingSilence)
+        endpointConfig.maximumUtteranceLength = TimeInterval(config.rule3MinUtteranceLength)
+        
+        let controller = AdaptiveEndpointController(
+            configuration: endpointConfig,
+            profile: AdaptiveEndpointController.loadProfile()
+        )
+        addLog("⏱️ 自适应端点检测已启用，当前静音阈值: \(String(format: "%.2f", controller.trailingSilenceThreshold))s")
+        return controller
+    }
+    
+    /// 记录最后一个字的时间：优先用结果中的时间戳，没有时用识别文字最后一次变化的时间
+    private func updateLastTokenTime(_ result: UnsafePointer<SherpaOnnxOnlineRecognizerResult>, text: String, decodedTime: TimeInterval) {
+        let count = Int(result.pointee.count)
+        if let timestamps = result.pointee.timestamps, count > 0 {
+            lastTokenTime = TimeInterval(timestamps[count - 1])
+        } else if !text.isEmpty && text != lastResultText {
+            lastTokenTime = decodedTime
+        }
+        lastResultText = text
+    }
+    
+    /// 用这句最终结果的时间戳更新停顿档案
+    private func learnPauses(from tokenTimes: [Float]) {
+        let segmentStart = Double(sessionSampleCount - segmentSampleCount) / sampleRate
+        endpointController?.learn(tokenTimes: tokenTimes, segmentStart: segmentStart)
+    }
+    
+    private func resetSegmentState() {
+        segmentSampleCount = 0
+        lastTokenTime = nil
+        lastResultText = ""
+    }
+    
+    // MARK: - Grammar Decoding
+    
+    /// 切换到指定的语法配置，空名或找不到配置时用自由解码（在 processingQueue 上调用）
+    ///
+    /// 语法解码的识别器第一次用到时才创建，之后一直保留，切换只是换一组识别器和音频流。
+    private func applyGrammarProfile(_ name: String) {
+        guard name != activeProfileName else { return }
+        
+        var target = ""
+        if !name.isEmpty {
+            if let profile = configManager.recognition.grammarProfiles.first(where: { $0.name == name }) {
+                if decoders[name] == nil, let decoder = createGrammarDecoder(profile) {
+                    decoders[name] = decoder
+                }
+                target = decoders[name] != nil ? name : ""
+            } else {
+                addLog("⚠️ 未找到语法配置: \(name)，使用自由解码")
+            }
+        }
+        
+        guard target != activeProfileName, let decoder = decoders[target] else { return }
+        recognizer = decoder.recognizer
+        stream = decoder.stream
+        activeProfileName = target
+        activeModelType = target.isEmpty ? configManager.recognition.modelType : "zipformer2_ctc"
+        addLog(target.isEmpty ? "🔤 切换到自由解码" : "🔤 切换到语法解码: \(target)")
+    }
+    
+    private func createGrammarDecoder(_ profile: GrammarProfile) -> (recognizer: OpaquePointer, stream: OpaquePointer)? {
+        let bundle = Bundle.main
+        let modelDir = bundle.path(forResource: profile.modelPath, ofType: nil) ?? profile.modelPath
+        let graph = bundle.path(forResource: profile.graphPath, ofType: nil) ?? profile.graphPath
+        let model = "\(modelDir)/model.onnx"
+        let tokens = "\(modelDir)/tokens.txt"
+        
+        for path in [model, tokens, graph] where !FileManager.default.fileExists(atPath: path) {
+            addLog("❌ 语法解码文件不存在: \(path)")
+            return nil
+        }
+        
+        let recognitionConfig = configManager.recognition
+        let modelConfig = sherpaOnnxOnlineModelConfig(
+            tokens: tokens,
+            zipformer2Ctc: sherpaOnnxOnlineZipformer2CtcModelConfig(model: model),
+            numThreads: recognitionConfig.numThreads,
+            provider: "cpu",
+            debug: recognitionConfig.debug
+        )
+        
+        // 端点规则与自由解码一致，自适应端点检测照常生效
+        let useAdaptiveEndpoint = recognitionConfig.enableEndpoint && recognitionConfig.enableAdaptiveEndpoint
+        var config = sherpaOnnxOnlineRecognizerConfig(
+            featConfig: sherpaOnnxFeatureConfig(sampleRate: Int(sampleRate), featureDim: 80),
+            modelConfig: modelConfig,
+            enableEndpoint: recognitionConfig.enableEndpoint,
+            rule1MinTrailingSilence: recognitionConfig.rule1MinTrailingSilence,
+            rule2MinTrailingSilence: useAdaptiveEndpoint
+                ? max(recognitionConfig.rule2MinTrailingSilence, recognitionConfig.adaptiveEndpointMaxSilence)
+                : recognitionConfig.rule2MinTrailingSilence,
+            rule3MinUtteranceLength: recognitionConfig.rule3MinUtteranceLength,
+            ctcFstDecoderConfig: sherpaOnnxOnlineCtcFstDecoderConfig(graph: graph, maxActive: profile.maxActive)
+        )
+        
+        addLog("🔤 创建语法解码识别器: \(profile.name)")
+        guard let recognizer = try? createRecognizerSafely(&config) else {
+            addLog("❌ 语法解码识别器创建失败: \(profile.name)")
+            return nil
+        }
+        guard let stream = SherpaOnnxCreateOnlineStream(recognizer) else {
+            addLog("❌ 语法解码音频流创建失败: \(profile.name)")
+            SherpaOnnxDestroyOnlineRecognizer(recognizer)
+            return nil
+        }
+        return (recognizer, stream)
+    }
+    
     // 🔒 安全修复：安全地从 C 结构体中读取文本
     private func getTextFromResult(_ result: UnsafePointer<SherpaOnnxOnlineRecognizerResult>) -> String {
         return getTextFromResultSafely(result)
@@ -884,19 +1084,51 @@ class SherpaASRService: ObservableObject, SpeechRecognitionServiceProtocol {
         return success
     }
     
-    private func getFinalResult() -> String? {
+    /// 收尾解码：结束输入、补尾部静音、解完剩余帧后发出最终结果（在 processingQueue 上调用）
+    private func finalizeRecognition() {
         guard let recognizer = recognizer,
               let stream = stream else {
-            return nil
+            return
         }
         
-        if let result = SherpaOnnxGetOnlineStreamResult(recognizer, stream) {
-            let finalText = getTextFromResult(result)
-            SherpaOnnxDestroyOnlineRecognizerResult(result)
-            return finalText.isEmpty ? nil : finalText
+        let outcome = StreamFinalizer.finalize(
+            recognizer: recognizer,
+            stream: stream,
+            sampleRate: Int(sampleRate),
+            tailPadding: StreamFinalizer.tailPadding(forModelType: activeModelType),
+            timeout: configManager.recognition.finalizeTimeout,
+            extractText: getTextFromResultSafely
+        )
+        // 原来的流已销毁，当前这组解码器改用新的流
+        self.stream = outcome.stream
+        decoders[activeProfileName] = (recognizer, outcome.stream)
+        
+        learnPauses(from: outcome.tokenTimes)
+        resetSegmentState()
+        if let controller = endpointController {
+            endpointController?.endSession()
+            let profile = controller.profile
+            cleanupQueue.async {
+                AdaptiveEndpointController.saveProfile(profile)
+            }
         }
         
-        return nil
+        let elapsedMs = Int(outcome.elapsed * 1000)
+        if outcome.timedOut {
+            addLog("⚠️ 收尾解码超时（\(elapsedMs)ms，已解码 \(outcome.decodeCount) 次），使用当前结果")
+        } else {
+            addLog("⚡ 收尾解码完成：\(outcome.decodeCount) 次解码，耗时 \(elapsedMs)ms")
+        }
+        
+        let finalText = outcome.text
+        DispatchQueue.main.async {
+            if !finalText.isEmpty {
+                self.transcript = finalText
+                self.addLog("📝 最终识别结果: \(finalText)")
+                self.delegate?.speechRecognitionDidReceiveFinalResult(finalText)
+            }
+            self.addLog("✅ 语音识别处理已停止")
+        }
     }
 }
 
@@ -11,4 +11,12 @@
 // Include the official C API header
 #include "Include/c-api.h"
 
+// 日志环形缓冲区（LogSink 使用）
+#include "LogRing.h"
+
+// 共用识别引擎（NativeEngine 使用，只有声明，不链接库时也能编译）
+#if __has_include("../../native/include/capswriter_engine.h")
+#include "../../native/include/capswriter_engine.h"
+#endif
+
 #endif /* SherpaONNX_Bridging_Header_h */
\ No newline at end of file
@@ -9,6 +9,8 @@ protocol TextInputServiceProtocol: AnyObject {
     func shouldInputText(_ text: String) -> Bool
     func formatTextForInput(_ text: String) -> String
     func inputText(_ text: String)
+    func appendText(_ text: String)
+    func applyEdits(_ keys: [TextEditKey])
     func inputTextWithAutoCorrection(_ text: String)
     func simulateKeyPress(_ keyCode: CGKeyCode, modifiers: CGEventFlags)
 }
@@ -98,6 +100,52 @@ class TextInputService: TextInputServiceProtocol {
         }
     }
     
+    /// 流式输入一段文本（边说边上屏）
+    /// 不做防抖，按调用顺序依次输入
+    /// - Parameter text: 要追加的文本
+    func appendText(_ text: String) {
+        guard !text.isEmpty else { return }
+        
+        guard checkAccessibilityPermission() else {
+            print("❌ 没有辅助功能权限，无法输入文本")
+            return
+        }
+        
+        inputQueue.async { [weak self] in
+            self?.performTextInput(text)
+        }
+    }
+    
+    /// 按顺序发送一组修正按键（由 TextReconciler 生成），修改已经输入的文字
+    /// - Parameter keys: 修正按键
+    func applyEdits(_ keys: [TextEditKey]) {
+        guard !keys.isEmpty else { return }
+        
+        guard checkAccessibilityPermission() else {
+            print("❌ 没有辅助功能权限，无法修正文本")
+            return
+        }
+        
+        inputQueue.async { [weak self] in
+            guard let self = self else { return }
+            for key in keys {
+                switch key {
+                case .type(let text):
+                    self.performTextInput(text)
+                case .backspace(let count):
+                    self.repeatKey(51, count: count) // Delete
+                case .moveLeft(let count):
+                    self.repeatKey(123, count: count) // ←
+                case .moveRight(let count):
+                    self.repeatKey(124, count: count) // →
+                case .selectLeft(let count):
+                    self.repeatKey(123, count: count, modifiers: .maskShift) // Shift+←
+                }
+            }
+            print("✅ 文本修正完成: \(keys.count) 组按键")
+        }
+    }
+    
     /// 模拟按键输入（用于特殊键，如回车、删除等）
     /// - Parameter keyCode: 虚拟按键码
     func inputKey(_ keyCode: CGKeyCode, withModifiers modifiers: CGEventFlags = []) {
@@ -194,6 +242,29 @@ class TextInputService: TextInputServiceProtocol {
         print("✅ 按键输入完成: keyCode=\(keyCode), modifiers=\(modifiers)")
     }
     
+    /// 连续发送同一个按键若干次
+    private func repeatKey(_ keyCode: CGKeyCode, count: Int, modifiers: CGEventFlags = []) {
+        let source = CGEventSource(stateID: .hidSystemState)
+        
+        for _ in 0..<count {
+            guard let keyDownEvent = CGEvent(keyboardEventSource: source, virtualKey: keyCode, keyDown: true),
+                  let keyUpEvent = CGEvent(keyboardEventSource: source, virtualKey: keyCode, keyDown: false) else {
+                print("❌ 无法创建按键事件")
+                return
+            }
+            
+            if !modifiers.isEmpty {
+                keyDownEvent.flags = modifiers
+                keyUpEvent.flags = modifiers
+            }
+            
+            keyDownEvent.post(tap: .cghidEventTap)
+            keyUpEvent.post(tap: .cghidEventTap)
+            
+            usleep(1000) // 1ms
+        }
+    }
+    
     /// 输入 Unicode 字符
     private func inputUnicodeCharacter(_ char: Character) {
         let source = CGEventSource(stateID: .hidSystemState)
@@ -195,6 +195,10 @@ class MockHotWordService: HotWordServiceProtocol, MockService, ObservableObject
         mockHotWords.removeValue(forKey: original)
     }
 
+    var maxMatchLength: Int {
+        mockHotWords.keys.map(\.count).max() ?? 0
+    }
+
     // Test helper methods
     func setMockHotWords(_ hotWords: [String: String]) {
         mockHotWords = hotWords
@@ -190,6 +190,67 @@ class EventBusTests: XCTestCase {
         XCTAssertFalse(eventReceived, "作用域外的订阅应该自动取消")
     }
 
+    // MARK: - 分发方式测试
+
+    func testSynchronousDeliveryRunsOnPublisherThread() {
+        // Given
+        var receivedOnThread: Thread?
+        var receivedEvent: TestEvent?
+
+        eventBus.subscribe(TestEvent.self, delivery: .synchronous) { event in
+            receivedOnThread = Thread.current
+            receivedEvent = event
+        }
+        .store(in: &cancellables)
+
+        // When - 在后台线程发布
+        let published = XCTestExpectation(description: "后台线程发布完成")
+        var publisherThread: Thread?
+        DispatchQueue.global().async {
+            publisherThread = Thread.current
+            self.eventBus.publish(TestEvent(message: "同步分发"))
+            published.fulfill()
+        }
+
+        // Then - publish 返回时订阅者已经处理完
+        wait(for: [published], timeout: 1.0)
+        XCTAssertEqual(receivedEvent?.message, "同步分发")
+        XCTAssertTrue(receivedOnThread === publisherThread, "同步订阅者应在发布线程上调用")
+    }
+
+    func testSubscribersReceiveInPriorityOrder() {
+        // Given
+        var order: [String] = []
+
+        eventBus.subscribe(TestEvent.self, priority: .low, delivery: .synchronous) { _ in order.append("low") }
+            .store(in: &cancellables)
+        eventBus.subscribe(TestEvent.self, priority: .critical, delivery: .synchronous) { _ in order.append("critical") }
+            .store(in: &cancellables)
+        eventBus.subscribe(TestEvent.self, priority: .normal, delivery: .synchronous) { _ in order.append("normal") }
+            .store(in: &cancellables)
+
+        // When
+        eventBus.publish(TestEvent(message: "优先级"))
+
+        // Then
+        XCTAssertEqual(order, ["critical", "normal", "low"])
+    }
+
+    func testDiagnosticsAreSampled() {
+        // Given - 默认关闭统计与历史
+        eventBus.subscribe(TestEvent.self, delivery: .synchronous) { _ in }
+            .store(in: &cancellables)
+        (0..<10).forEach { eventBus.publish(TestEvent(message: "\($0)")) }
+        XCTAssertTrue(eventBus.getRecentEvents().isEmpty, "未开启采样时不应记录历史")
+
+        // When - 每 5 次采样一次
+        eventBus.diagnosticsSampleRate = 5
+        (0..<10).forEach { eventBus.publish(TestEvent(message: "\($0)")) }
+
+        // Then
+        XCTAssertEqual(eventBus.getRecentEvents(limit: 100).count, 2)
+    }
+
     // MARK: - 异步事件处理测试
 
     func testAsyncEventHandling() {
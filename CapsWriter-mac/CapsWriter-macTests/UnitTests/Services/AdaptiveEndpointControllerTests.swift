@@ -0,0 +1,68 @@
+import XCTest
+@testable import CapsWriter_mac
+
+class AdaptiveEndpointControllerTests: XCTestCase {
+
+    private func makeController() -> AdaptiveEndpointController {
+        var config = AdaptiveEndpointController.Configuration()
+        config.minimumSilence = 0.4
+        config.maximumSilence = 2.0
+        config.fallbackSilence = 1.2
+        return AdaptiveEndpointController(configuration: config)
+    }
+
+    /// 学习若干句等间隔说出的话
+    private func learnSegments(_ controller: inout AdaptiveEndpointController, count: Int, tokenGap: Float) {
+        for i in 0..<count {
+            let times = (0..<5).map { Float($0) * tokenGap }
+            controller.learn(tokenTimes: times, segmentStart: Double(i) * 10)
+        }
+    }
+
+    // MARK: - 阈值
+
+    func testUsesFallbackWithoutSamples() {
+        let controller = makeController()
+        XCTAssertEqual(controller.trailingSilenceThreshold, 1.2, accuracy: 1e-9)
+    }
+
+    func testFastTalkerGetsShorterThreshold() {
+        var controller = makeController()
+        learnSegments(&controller, count: 20, tokenGap: 0.2)
+        // 句内停顿约 0.2 秒，乘上余量后低于下限
+        XCTAssertEqual(controller.trailingSilenceThreshold, 0.4, accuracy: 1e-9)
+    }
+
+    func testSlowTalkerGetsLongerThreshold() {
+        var controller = makeController()
+        learnSegments(&controller, count: 20, tokenGap: 0.8)
+        let threshold = controller.trailingSilenceThreshold
+        XCTAssertGreaterThan(threshold, 1.2)
+        XCTAssertLessThanOrEqual(threshold, 2.0)
+    }
+
+    // MARK: - 端点判定
+
+    func testEndpointAfterTrailingSilence() {
+        var controller = makeController()
+        learnSegments(&controller, count: 20, tokenGap: 0.2)
+
+        XCTAssertFalse(controller.isEndpoint(lastTokenTime: 1.0, audioTime: 1.3))
+        XCTAssertTrue(controller.isEndpoint(lastTokenTime: 1.0, audioTime: 1.5))
+        // 没有识别出字时按 noSpeechSilence 判断
+        XCTAssertFalse(controller.isEndpoint(lastTokenTime: nil, audioTime: 1.5))
+        XCTAssertTrue(controller.isEndpoint(lastTokenTime: nil, audioTime: 2.5))
+    }
+
+    func testProfileRoundTrip() throws {
+        var controller = makeController()
+        learnSegments(&controller, count: 3, tokenGap: 0.3)
+
+        let url = FileManager.default.temporaryDirectory
+            .appendingPathComponent("EndpointProfile-\(UUID().uuidString).json")
+        defer { try? FileManager.default.removeItem(at: url) }
+
+        AdaptiveEndpointController.saveProfile(controller.profile, to: url)
+        XCTAssertEqual(AdaptiveEndpointController.loadProfile(from: url), controller.profile)
+    }
+}
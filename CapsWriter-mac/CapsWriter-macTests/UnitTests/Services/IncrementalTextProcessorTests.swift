@@ -0,0 +1,55 @@
+import XCTest
+@testable import CapsWriter_mac
+
+class IncrementalTextProcessorTests: XCTestCase {
+
+    private let hotWords = ["大模型": "LLM", "苹果电脑": "Mac", "北京": "北京市"]
+    private var transformedLength = 0
+
+    private func transform(_ text: String) -> String {
+        transformedLength += text.count
+        var result = text
+        for (original, replacement) in hotWords {
+            result = result.replacingOccurrences(of: original, with: replacement)
+        }
+        return result
+    }
+
+    private func makeProcessor() -> IncrementalTextProcessor {
+        IncrementalTextProcessor(window: 4) { [unowned self] in self.transform($0) }
+    }
+
+    // MARK: - 结果一致
+
+    func testGrowingPartialsMatchFullProcessing() {
+        var processor = makeProcessor()
+        let sentence = "我在北京用苹果电脑跑大模型，然后把大模型的结果发回北京的同事"
+        var partial = ""
+        for char in sentence {
+            partial.append(char)
+            XCTAssertEqual(processor.process(partial), transform(partial), "前缀: \(partial)")
+        }
+    }
+
+    func testRevisionInsideFrozenRegionRollsBack() {
+        var processor = makeProcessor()
+        let first = "今天我们用苹果电脑测试一下效果怎么样"
+        _ = processor.process(first)
+
+        let revised = "今天他们用苹果电脑跑大模型"
+        XCTAssertEqual(processor.process(revised), transform(revised))
+    }
+
+    // MARK: - 处理量
+
+    func testWorkIsBoundedByTailWindow() {
+        var processor = makeProcessor()
+        var partial = ""
+        for i in 0..<400 {
+            partial.append(i % 7 == 0 ? "北" : "字")
+            transformedLength = 0
+            _ = processor.process(partial)
+            XCTAssertLessThanOrEqual(transformedLength, 3 * 2 * processor.window, "第 \(i) 次处理了 \(transformedLength) 字")
+        }
+    }
+}
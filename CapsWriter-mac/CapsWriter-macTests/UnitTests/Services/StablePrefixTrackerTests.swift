@@ -0,0 +1,61 @@
+import XCTest
+@testable import CapsWriter_mac
+
+class StablePrefixTrackerTests: XCTestCase {
+
+    private func makeTracker(agreement: Int = 3, age: TimeInterval = 0.4) -> StablePrefixTracker {
+        StablePrefixTracker(configuration: .init(agreementCount: agreement, minimumAge: age))
+    }
+
+    // MARK: - 稳定条件
+
+    func testCommitsOnlyAgreedAndAgedPrefix() {
+        var tracker = makeTracker()
+
+        XCTAssertEqual(tracker.update("今天", at: 0.0), "")
+        XCTAssertEqual(tracker.update("今天天", at: 0.2), "")
+        // 三次一致，但只有「今天」出现满 0.4 秒
+        XCTAssertEqual(tracker.update("今天天气", at: 0.4), "今天")
+        XCTAssertEqual(tracker.update("今天天气不错", at: 0.6), "天")
+        XCTAssertEqual(tracker.committedText, "今天天")
+    }
+
+    func testRevisedTailIsNotCommitted() {
+        var tracker = makeTracker(agreement: 2, age: 0)
+
+        XCTAssertEqual(tracker.update("我们明", at: 0.0), "")
+        // 「明」被改成「名」，只有「我们」一致
+        XCTAssertEqual(tracker.update("我们名单", at: 0.1), "我们")
+        XCTAssertEqual(tracker.update("我们名单上", at: 0.2), "名单")
+    }
+
+    func testDoesNotSplitEnglishWords() {
+        var tracker = makeTracker(agreement: 2, age: 0)
+
+        _ = tracker.update("打开 chrome", at: 0.0)
+        XCTAssertEqual(tracker.update("打开 chromebook", at: 0.1), "打开 ")
+        XCTAssertEqual(tracker.update("打开 chromebook 设置", at: 0.2), "chromebook")
+    }
+
+    // MARK: - 改写与最终结果
+
+    func testCommittedPrefixNeverShrinks() {
+        var tracker = makeTracker(agreement: 2, age: 0)
+
+        _ = tracker.update("你好世界", at: 0.0)
+        XCTAssertEqual(tracker.update("你好世界", at: 0.1), "你好世界")
+        XCTAssertEqual(tracker.update("你号", at: 0.2), "")
+        XCTAssertTrue(tracker.hasDiverged)
+        XCTAssertEqual(tracker.committedText, "你好世界")
+    }
+
+    func testFinishReturnsTailAndResets() {
+        var tracker = makeTracker(agreement: 2, age: 0)
+
+        _ = tracker.update("语音输入", at: 0.0)
+        _ = tracker.update("语音输入", at: 0.1)
+        XCTAssertEqual(tracker.finish("语音输入很方便"), "很方便")
+        XCTAssertEqual(tracker.committedText, "")
+        XCTAssertEqual(tracker.update("下一句", at: 1.0), "")
+    }
+}
@@ -0,0 +1,122 @@
+import XCTest
+@testable import CapsWriter_mac
+
+class TextReconcilerTests: XCTestCase {
+
+    let reconciler = TextReconciler()
+
+    /// 在文本缓冲区上模拟按键，光标初始在末尾
+    private func simulate(_ keys: [TextEditKey], on text: String) -> String {
+        var buffer = Array(text)
+        var cursor = buffer.count
+        var selection = 0
+
+        func deleteSelection() {
+            buffer.removeSubrange((cursor - selection)..<cursor)
+            cursor -= selection
+            selection = 0
+        }
+
+        for key in keys {
+            switch key {
+            case .type(let string):
+                deleteSelection()
+                buffer.insert(contentsOf: Array(string), at: cursor)
+                cursor += string.count
+            case .backspace(let count):
+                if selection > 0 {
+                    deleteSelection()
+                    buffer.removeSubrange((cursor - count + 1)..<cursor)
+                    cursor -= count - 1
+                } else {
+                    buffer.removeSubrange((cursor - count)..<cursor)
+                    cursor -= count
+                }
+            case .moveLeft(let count):
+                selection = 0
+                cursor -= count
+            case .moveRight(let count):
+                selection = 0
+                cursor += count
+            case .selectLeft(let count):
+                selection += count
+            }
+        }
+        XCTAssertEqual(cursor, buffer.count, "修正后光标应回到末尾")
+        return String(buffer)
+    }
+
+    private func assertReconciles(_ typed: String, _ target: String, file: StaticString = #file, line: UInt = #line) -> TextReconciler.Plan {
+        let plan = reconciler.plan(typed: typed, target: target)
+        XCTAssertEqual(simulate(plan.keys, on: typed), target, file: file, line: line)
+        return plan
+    }
+
+    // MARK: - 方案选择
+
+    func testIdenticalTextNeedsNoKeys() {
+        let plan = assertReconciles("你好世界", "你好世界")
+        XCTAssertEqual(plan.strategy, .none)
+        XCTAssertTrue(plan.keys.isEmpty)
+    }
+
+    func testAppendOnlyTypesTail() {
+        let plan = assertReconciles("今天天气", "今天天气不错。")
+        XCTAssertEqual(plan.keys, [.type("不错。")])
+    }
+
+    func testSingleCharacterFixInTheMiddle() {
+        let plan = assertReconciles("我们今天去公园玩", "我们明天去公园玩")
+        XCTAssertNotEqual(plan.strategy, .retypeSuffix, "只改一个字不应把后面全部重打")
+        XCTAssertLessThan(plan.cost, 8)
+    }
+
+    func testScatteredEditsUseMinimalEdit() {
+        let plan = assertReconciles(
+            "今天我们讨论一下关于那个项目的进度安排以及后续的人员分工问题",
+            "今天我们讨论一下关于这个项目的进度安排以及后续的人员分工的问题"
+        )
+        XCTAssertEqual(plan.strategy, .minimalEdit)
+    }
+
+    func testLargeRewriteFallsBack() {
+        let limited = TextReconciler(maxEditDistance: 4)
+        let typed = "这是一段完全识别错误的文字"
+        let target = "最终结果和之前毫无关系"
+        let plan = limited.plan(typed: typed, target: target)
+        XCTAssertNotEqual(plan.strategy, .minimalEdit)
+        XCTAssertEqual(simulate(plan.keys, on: typed), target)
+    }
+
+    // MARK: - 差分正确性
+
+    func testRandomEditsRoundTrip() {
+        let alphabet = Array("ab中文😀")
+        var generator = SystemRandomNumberGenerator()
+        for _ in 0..<300 {
+            let typed = String((0..<Int.random(in: 0...10, using: &generator)).map { _ in alphabet.randomElement()! })
+            let target = String((0..<Int.random(in: 0...10, using: &generator)).map { _ in alphabet.randomElement()! })
+            _ = assertReconciles(typed, target)
+        }
+    }
+
+    /// 长文本中散落几处修改，多半走最少增删，检查插入文字之后各处的光标位置
+    func testScatteredRandomEditsRoundTrip() {
+        let alphabet = Array("天地玄黄宇宙洪荒日月")
+        let replacements = Array("甲乙丙")
+        var generator = SystemRandomNumberGenerator()
+        for _ in 0..<300 {
+            let typed = (0..<40).map { _ in alphabet.randomElement(using: &generator)! }
+            var target = typed
+            for _ in 0..<Int.random(in: 1...4, using: &generator) {
+                let i = Int.random(in: 0..<target.count, using: &generator)
+                switch Int.random(in: 0..<3, using: &generator) {
+                case 0: target[i] = replacements.randomElement(using: &generator)!
+                case 1: target.insert(replacements.randomElement(using: &generator)!, at: i)
+                default: target.remove(at: i)
+                }
+            }
+            _ = assertReconciles(String(typed), String(target))
+        }
+    }
+}
@@ -0,0 +1,97 @@
+import XCTest
+import Combine
+@testable import CapsWriter_mac
+
+class TranscriptHistoryStoreTests: XCTestCase {
+
+    var logURL: URL!
+    var cancellables: Set<AnyCancellable>!
+
+    override func setUp() {
+        super.setUp()
+        cancellables = Set<AnyCancellable>()
+        logURL = FileManager.default.temporaryDirectory
+            .appendingPathComponent("transcript-history-\(UUID().uuidString)")
+            .appendingPathComponent("history.jsonl")
+    }
+
+    override func tearDown() {
+        cancellables = nil
+        try? FileManager.default.removeItem(at: logURL.deletingLastPathComponent())
+        logURL = nil
+        super.tearDown()
+    }
+
+    private func makeStore(capacity: Int = 3) -> TranscriptHistoryStore {
+        let store = TranscriptHistoryStore(logURL: logURL, windowCapacity: capacity)
+        drainMainQueue()
+        return store
+    }
+
+    private func drainMainQueue() {
+        let expectation = expectation(description: "main queue")
+        DispatchQueue.global().asyncAfter(deadline: .now() + 0.1) {
+            DispatchQueue.main.async { expectation.fulfill() }
+        }
+        wait(for: [expectation], timeout: 2.0)
+    }
+
+    private func entry(_ text: String, partial: Bool = false) -> TranscriptEntry {
+        TranscriptEntry(timestamp: Date(), text: text, isPartial: partial)
+    }
+
+    // MARK: - 窗口与增量通知
+
+    func testPartialResultsReplaceInPlace() {
+        let store = makeStore()
+        var changes: [TranscriptHistoryChange] = []
+        store.changes.sink { changes.append($0) }.store(in: &cancellables)
+
+        store.append(entry("你", partial: true))
+        store.append(entry("你好", partial: true))
+        store.append(entry("你好世界"))
+
+        XCTAssertEqual(store.window.map(\.text), ["你好世界"])
+        XCTAssertEqual(changes.count, 3)
+        if case .replacedLast(let last) = changes.last {
+            XCTAssertFalse(last.isPartial)
+        } else {
+            XCTFail("最终结果应替换末尾的部分结果")
+        }
+    }
+
+    func testWindowIsBounded() {
+        let store = makeStore(capacity: 3)
+        var trimmed = 0
+        store.changes.sink { change in
+            if case .trimmedFront(let count) = change { trimmed += count }
+        }.store(in: &cancellables)
+
+        (1...10).forEach { store.append(entry("第\($0)句")) }
+
+        XCTAssertEqual(store.window.map(\.text), ["第8句", "第9句", "第10句"])
+        XCTAssertEqual(trimmed, 7)
+    }
+
+    // MARK: - 持久化与翻页
+
+    func testReloadAndPageOlder() {
+        var store: TranscriptHistoryStore? = makeStore(capacity: 3)
+        (1...7).forEach { store?.append(entry("第\($0)句")) }
+        store?.append(entry("未完成", partial: true))
+        store?.flush()
+        store = nil
+
+        let reopened = makeStore(capacity: 3)
+        XCTAssertEqual(reopened.window.map(\.text), ["第5句", "第6句", "第7句"], "部分结果不应落盘")
+        XCTAssertTrue(reopened.hasOlder)
+
+        let loaded = expectation(description: "load older")
+        reopened.loadOlder(pageSize: 2) { count in
+            XCTAssertEqual(count, 2)
+            loaded.fulfill()
+        }
+        wait(for: [loaded], timeout: 2.0)
+        XCTAssertEqual(reopened.window.first?.text, "第3句")
+    }
+}
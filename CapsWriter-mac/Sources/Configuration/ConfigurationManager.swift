@@ -46,6 +46,21 @@ struct AudioConfiguration: Codable {
     }
 }
 
+/// 领域语法解码配置
+///
+/// 用 `util/grammar_graph.py compile` 把语法和模型词表编译成解码图，识别时只在语法允许的句子里搜索。
+/// CTC FST 解码器只支持 CTC 模型，所以每个配置带自己的流式 Zipformer2 CTC 模型，默认模型仍用于自由解码。
+struct GrammarProfile: Codable, Equatable {
+    var name: String
+    var modelPath: String       // 流式 Zipformer2 CTC 模型目录，包含 model.onnx 和 tokens.txt
+    var graphPath: String       // 编译好的解码图（.fst）
+    var maxActive: Int = 3000   // 每帧保留的活跃状态数
+    
+    func isValid() -> Bool {
+        return !name.isEmpty && !modelPath.isEmpty && !graphPath.isEmpty && maxActive > 0
+    }
+}
+
 /// 语音识别配置
 struct RecognitionConfiguration: Codable {
     var modelPath: String = "models/paraformer-zh-streaming"
@@ -59,6 +74,12 @@ struct RecognitionConfiguration: Codable {
     var rule1MinTrailingSilence: Float = 2.4
     var rule2MinTrailingSilence: Float = 1.2
     var rule3MinUtteranceLength: Float = 20.0
+    var finalizeTimeout: Double = 0.6  // 停止录音后收尾解码的最长时间（秒）
+    var enableAdaptiveEndpoint: Bool = true  // 按说话人的停顿习惯调整句末静音时长
+    var adaptiveEndpointMinSilence: Float = 0.4
+    var adaptiveEndpointMaxSilence: Float = 2.0
+    var grammarProfiles: [GrammarProfile] = []
+    var activeGrammarProfile: String = ""  // 本次会话使用的语法配置名，空表示自由解码
     var hotwordsScore: Float = 1.5
     var debug: Bool = false
     var modelName: String = "paraformer-zh-streaming"
@@ -71,7 +92,12 @@ struct RecognitionConfiguration: Codable {
                maxActivePaths > 0 && 
                rule1MinTrailingSilence > 0 && 
                rule2MinTrailingSilence > 0 && 
-               rule3MinUtteranceLength > 0
+               rule3MinUtteranceLength > 0 &&
+               finalizeTimeout > 0 &&
+               adaptiveEndpointMinSilence > 0 &&
+               adaptiveEndpointMaxSilence >= adaptiveEndpointMinSilence &&
+               grammarProfiles.allSatisfy { $0.isValid() } &&
+               (activeGrammarProfile.isEmpty || grammarProfiles.contains { $0.name == activeGrammarProfile })
     }
 }
 
@@ -167,10 +193,17 @@ struct AppBehaviorConfiguration: Codable {
     var minimizeOnStartup: Bool = true
     var checkUpdatesOnStartup: Bool = false
     
+    // 边说边上屏：部分结果的开头稳定后立即输入，不等整句结束（会用按键修改已输入的文字，默认关闭）
+    var enableStreamingInput: Bool = false
+    var streamingAgreementCount: Int = 3        // 连续几次部分结果一致才算稳定
+    var streamingMinimumAge: Double = 0.4       // 字保持不变多久才算稳定（秒）
+    
     func isValid() -> Bool {
         return startupDelay >= 0 && 
                recognitionStartDelay >= 0 && 
-               permissionCheckDelay >= 0
+               permissionCheckDelay >= 0 &&
+               streamingAgreementCount > 0 &&
+               streamingMinimumAge >= 0
     }
 }
 
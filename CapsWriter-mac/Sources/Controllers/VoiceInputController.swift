@@ -44,6 +44,11 @@ class VoiceInputController: ObservableObject {
     private let controllerQueue = DispatchQueue(label: "com.capswriter.voice-input-controller", qos: .userInitiated)
     private var audioForwardCount: Int = 0
     
+    // 边说边上屏的状态（仅在 controllerQueue 上访问）
+    private var stablePrefixTracker = StablePrefixTracker()
+    private var streamedText = ""  // 本句已经输入的文本（处理后）
+    private let textReconciler = TextReconciler()
+    
     // 日志控制开关
     private static let enableDetailedLogging: Bool = {
         #if DEBUG
@@ -512,6 +517,12 @@ class VoiceInputController: ObservableObject {
             // 同步到 RecordingState 供 UI 使用
             self?.recordingState.updatePartialTranscript(text)
         }
+        
+        // 边说边上屏：开头稳定的部分立即输入
+        guard configManager.appBehavior.enableStreamingInput else { return }
+        controllerQueue.async { [weak self] in
+            self?.commitStablePrefix(text)
+        }
     }
     
     private func handleFinalResult(_ text: String) {
@@ -521,14 +532,14 @@ class VoiceInputController: ObservableObject {
             self?.asrService?.addTranscriptEntry(text: text, isPartial: false)
             self?.asrService?.partialTranscript = ""
             
-            // 同步到 RecordingState 供 UI 使用
-            let entry = TranscriptEntry(timestamp: Date(), text: text, isPartial: false)
-            self?.recordingState.addTranscriptEntry(entry)
+            // RecordingState 与 ASR 服务共用同一个历史存储，这里只同步部分结果
             self?.recordingState.updatePartialTranscript("")
         }
         
-        // 处理文本输入
-        processTextInput(text)
+        // 处理文本输入（排在已提交的部分结果之后）
+        controllerQueue.async { [weak self] in
+            self?.processTextInput(text)
+        }
     }
     
     private func handleEndpointDetected() {
@@ -561,6 +572,10 @@ class VoiceInputController: ObservableObject {
         
         updatePhase(.recording)
         
+        controllerQueue.async { [weak self] in
+            self?.resetStreamingInput()
+        }
+        
         // 录音开始
         print("🚀 录音流程已开始")
         
@@ -604,6 +619,14 @@ class VoiceInputController: ObservableObject {
             return
         }
         
+        // 这句话已经边说边输入了一部分，只补上剩下的
+        if !stablePrefixTracker.committed.isEmpty {
+            finishStreamingInput(text, textInputService: textInputService)
+            return
+        }
+        stablePrefixTracker.reset()
+        textProcessingService.resetPartialState()
+        
         // 检查文本是否适合输入
         guard textInputService.shouldInputText(text) else {
             print("⚠️ 文本不适合输入，跳过: \(text)")
@@ -636,6 +659,69 @@ class VoiceInputController: ObservableObject {
         return textProcessingService.processText(text)
     }
     
+    // MARK: - Private Methods - Streaming Input
+    
+    private func resetStreamingInput() {
+        let behavior = configManager.appBehavior
+        stablePrefixTracker = StablePrefixTracker(configuration: .init(
+            agreementCount: behavior.streamingAgreementCount,
+            minimumAge: behavior.streamingMinimumAge
+        ))
+        streamedText = ""
+        textProcessingService.resetPartialState()
+    }
+    
+    /// 提交部分结果中新稳定下来的前缀
+    private func commitStablePrefix(_ partialText: String) {
+        guard let textInputService = textInputService else { return }
+        
+        let delta = stablePrefixTracker.update(partialText)
+        guard !delta.isEmpty else { return }
+        
+        // 只处理已稳定的前缀，且只重新处理变化的尾部；标点要看整句，留给最终结果
+        let processedText = textProcessingService.processPartialText(stablePrefixTracker.committedText)
+        reconcileStreamedText(to: processedText, textInputService: textInputService)
+    }
+    
+    /// 最终结果到达：整句走完整的文本处理（标点、格式规则），与已输入的部分对齐，并为下一句重置
+    private func finishStreamingInput(_ text: String, textInputService: any TextInputServiceProtocol) {
+        stablePrefixTracker.finish(text)
+        let typed = streamedText
+        streamedText = ""
+        textProcessingService.resetPartialState()
+        
+        // 与不边说边上屏时一样检查和处理整句；整句不适合输入时撤回已输入的部分
+        var formattedText = ""
+        if textInputService.shouldInputText(text) {
+            formattedText = textInputService.formatTextForInput(applyTextProcessing(text))
+        } else {
+            print("⚠️ 文本不适合输入，撤回已输入的部分: \(text)")
+        }
+        
+        print("🎤➡️⌨️ 语音输入（补齐）: \(typed) -> \(formattedText)")
+        
+        // 立即在处理队列上修正，不加 startupDelay：录音仍在继续，下一句的稳定前缀随时会接着输入，
+        // 修正必须排在它前面，否则退格和补齐会落在错误的位置
+        editTypedText(from: typed, to: formattedText, textInputService: textInputService)
+    }
+    
+    /// 把已经输入的文本改成 `text`，并记为已输入
+    private func reconcileStreamedText(to text: String, textInputService: any TextInputServiceProtocol) {
+        editTypedText(from: streamedText, to: text, textInputService: textInputService)
+        streamedText = text
+    }
+    
+    /// 把已经输入的 `typed` 改成 `text`：通常只是在末尾追加，被改写时用最少的按键修正
+    private func editTypedText(from typed: String, to text: String, textInputService: any TextInputServiceProtocol) {
+        if text.hasPrefix(typed) {
+            textInputService.appendText(String(text.dropFirst(typed.count)))
+        } else {
+            let plan = textReconciler.plan(typed: typed, target: text)
+            print("✏️ 修正已输入的文本（\(plan.strategy.rawValue)，代价 \(String(format: "%.1f", plan.cost))）: \(typed) -> \(text)")
+            textInputService.applyEdits(plan.keys)
+        }
+    }
+    
     // MARK: - Private Methods - State Management
     
     private func updatePhase(_ newPhase: VoiceInputPhase) {
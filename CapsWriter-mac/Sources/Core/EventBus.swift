@@ -4,6 +4,13 @@ import SwiftUI
 
 /// 事件驱动架构核心 - CapsWriter-mac 第一阶段任务 1.4
 /// 提供类型安全的事件发布和订阅机制，解耦组件间依赖
+///
+/// 性能设计：
+/// - 每个事件类型分配一个整数 ID，订阅者表是按 ID 索引的数组，按优先级预先排好序
+/// - 订阅表是写时复制的快照：订阅/取消时在锁内生成新快照，发布时只在锁内取快照引用，
+///   遍历和分发都不持锁，发布者之间互不阻塞
+/// - 高频事件（音量、部分识别结果）可以选择 `.synchronous`，在发布线程上直接调用，不经过队列
+/// - 统计与事件历史默认关闭，通过 `diagnosticsSampleRate` 按采样开启
 class EventBus: ObservableObject {
     
     // MARK: - Types
@@ -16,22 +23,30 @@ class EventBus: ObservableObject {
         case critical = 4
     }
     
+    /// 事件分发方式
+    enum Delivery {
+        /// 异步投递到指定队列
+        case queue(DispatchQueue)
+        /// 在发布线程上同步调用，适合高频、处理很轻的订阅者
+        case synchronous
+    }
+    
     /// 事件订阅者信息
     private struct Subscription {
         let id: UUID
         let priority: EventPriority
-        let handler: (any Event) -> Void
-        let queue: DispatchQueue
+        let delivery: Delivery
+        let handler: (Any) -> Void
         
-        init<T: Event>(
+        init<T>(
             id: UUID = UUID(),
             priority: EventPriority,
-            handler: @escaping (T) -> Void,
-            queue: DispatchQueue
+            delivery: Delivery,
+            handler: @escaping (T) -> Void
         ) {
             self.id = id
             self.priority = priority
-            self.queue = queue
+            self.delivery = delivery
             self.handler = { event in
                 if let typedEvent = event as? T {
                     handler(typedEvent)
@@ -40,6 +55,26 @@ class EventBus: ObservableObject {
         }
     }
     
+    /// 订阅表快照，创建后不再修改
+    private final class Snapshot {
+        /// 事件类型 -> 整数 ID
+        let typeIDs: [ObjectIdentifier: Int]
+        /// 按 ID 索引的类型名（调试用）
+        let typeNames: [String]
+        /// 按 ID 索引的订阅者列表，已按优先级从高到低排序
+        let tables: [[Subscription]]
+        
+        init(typeIDs: [ObjectIdentifier: Int] = [:], typeNames: [String] = [], tables: [[Subscription]] = []) {
+            self.typeIDs = typeIDs
+            self.typeNames = typeNames
+            self.tables = tables
+        }
+        
+        var subscriptionCount: Int {
+            tables.reduce(0) { $0 + $1.count }
+        }
+    }
+    
     /// 事件统计信息
     struct EventStatistics {
         var totalPublished: Int = 0
@@ -47,9 +82,10 @@ class EventBus: ObservableObject {
         var eventCounts: [String: Int] = [:]
         var lastEventTime: Date?
         
-        mutating func recordPublication(eventType: String) {
-            totalPublished += 1
-            eventCounts[eventType, default: 0] += 1
+        /// 记录一次采样到的发布，weight 为采样间隔，用来估算总数
+        mutating func recordPublication(eventType: String, weight: Int = 1) {
+            totalPublished += weight
+            eventCounts[eventType, default: 0] += weight
             lastEventTime = Date()
         }
         
@@ -67,103 +103,120 @@ class EventBus: ObservableObject {
     
     // MARK: - Published Properties
     
-    /// 事件统计信息
+    /// 事件统计信息（仅在开启采样时更新）
     @Published var statistics: EventStatistics = EventStatistics()
     
     /// 当前活跃订阅者数量
     @Published var activeSubscriptions: Int = 0
     
-    /// 最近发布的事件类型
+    /// 最近发布的事件类型（仅在开启采样时更新）
     @Published var lastPublishedEventType: String = ""
     
+    // MARK: - Diagnostics
+    
+    /// 统计与历史的采样间隔：0 表示关闭，N 表示每 N 次发布记录一次
+    var diagnosticsSampleRate: Int {
+        get { withLock { sampleRate } }
+        set { withLock { sampleRate = max(0, newValue) } }
+    }
+    
     // MARK: - Private Properties
     
-    private var subscriptions: [String: [Subscription]] = [:]
-    private let subscriptionQueue = DispatchQueue(label: "com.capswriter.eventbus", attributes: .concurrent)
+    private var snapshot = Snapshot()
+    private let lock = NSLock()
     private let statisticsQueue = DispatchQueue(label: "com.capswriter.eventbus.stats")
     
-    // 事件缓存用于调试
-    private var recentEvents: [(event: any Event, timestamp: Date)] = []
+    private var sampleRate = 0
+    private var publishCounter = 0
+    
+    // 事件缓存用于调试（仅在 statisticsQueue 上访问）
+    private var recentEvents: [(eventType: String, timestamp: Date)] = []
     private let maxRecentEvents = 100
     
     // MARK: - Singleton
     
     static let shared = EventBus()
     
-    private init() {
+    init() {
         print("🚌 EventBus: 事件总线已初始化")
     }
     
     // MARK: - Public Interface
     
     /// 发布事件
-    func publish<T: Event>(_ event: T, priority: EventPriority = .normal) {
-        let eventType = String(describing: T.self)
+    func publish<T>(_ event: T, priority: EventPriority = .normal) {
+        // 锁内只取快照引用和采样计数
+        let (current, sampled, weight): (Snapshot, Bool, Int) = withLock {
+            guard sampleRate > 0 else { return (snapshot, false, 0) }
+            publishCounter += 1
+            return (snapshot, publishCounter % sampleRate == 0, sampleRate)
+        }
         
-        subscriptionQueue.async(flags: .barrier) { [weak self] in
-            self?.processEvent(event, eventType: eventType, priority: priority)
+        if sampled {
+            recordPublication(eventType: String(describing: T.self), weight: weight)
         }
         
-        // 更新统计信息
-        statisticsQueue.async { [weak self] in
-            DispatchQueue.main.async {
-                self?.statistics.recordPublication(eventType: eventType)
-                self?.lastPublishedEventType = eventType
+        guard let typeID = current.typeIDs[ObjectIdentifier(T.self)] else { return }
+        for subscription in current.tables[typeID] {
+            switch subscription.delivery {
+            case .synchronous:
+                subscription.handler(event)
+            case .queue(let queue):
+                queue.async {
+                    subscription.handler(event)
+                }
             }
         }
-        
-        print("📡 EventBus: 发布事件 \(eventType) (优先级: \(priority.description))")
     }
     
-    /// 订阅事件
+    /// 订阅事件，返回订阅 ID，用 `unsubscribe(_:)` 取消
     @discardableResult
-    func subscribe<T: Event>(
+    func subscribe<T>(
         to eventType: T.Type,
         priority: EventPriority = .normal,
         queue: DispatchQueue = .main,
         handler: @escaping (T) -> Void
     ) -> UUID {
-        let subscription = Subscription(
-            priority: priority,
-            handler: handler,
-            queue: queue
+        return addSubscription(
+            Subscription(priority: priority, delivery: .queue(queue), handler: handler),
+            for: eventType
         )
-        let eventTypeName = String(describing: eventType)
-        
-        subscriptionQueue.async(flags: .barrier) { [weak self] in
-            self?.addSubscription(subscription, for: eventTypeName)
-        }
-        
-        // 更新统计信息
-        statisticsQueue.async { [weak self] in
-            DispatchQueue.main.async {
-                self?.statistics.recordSubscription()
-                self?.updateActiveSubscriptionsCount()
-            }
+    }
+    
+    /// 订阅事件，返回的 AnyCancellable 释放或取消时自动取消订阅
+    func subscribe<T>(
+        _ eventType: T.Type,
+        priority: EventPriority = .normal,
+        delivery: Delivery = .queue(.main),
+        handler: @escaping (T) -> Void
+    ) -> AnyCancellable {
+        let subscriptionId = addSubscription(
+            Subscription(priority: priority, delivery: delivery, handler: handler),
+            for: eventType
+        )
+        return AnyCancellable { [weak self] in
+            self?.unsubscribe(subscriptionId)
         }
-        
-        print("📝 EventBus: 订阅事件 \(eventTypeName) (订阅ID: \(subscription.id))")
-        return subscription.id
     }
     
     /// 取消订阅
     func unsubscribe(_ subscriptionId: UUID) {
-        subscriptionQueue.async(flags: .barrier) { [weak self] in
-            self?.removeSubscription(subscriptionId)
+        let count: Int = withLock {
+            let tables = snapshot.tables.map { $0.filter { $0.id != subscriptionId } }
+            snapshot = Snapshot(typeIDs: snapshot.typeIDs, typeNames: snapshot.typeNames, tables: tables)
+            return snapshot.subscriptionCount
         }
         
-        // 更新统计信息
         DispatchQueue.main.async { [weak self] in
-            self?.updateActiveSubscriptionsCount()
+            self?.activeSubscriptions = count
         }
-        
-        print("❌ EventBus: 取消订阅 \(subscriptionId)")
     }
     
     /// 取消所有订阅
     func unsubscribeAll() {
-        subscriptionQueue.async(flags: .barrier) { [weak self] in
-            self?.subscriptions.removeAll()
+        withLock {
+            let tables = Array(repeating: [Subscription](), count: snapshot.tables.count)
+            snapshot = Snapshot(typeIDs: snapshot.typeIDs, typeNames: snapshot.typeNames, tables: tables)
         }
         
         DispatchQueue.main.async { [weak self] in
@@ -174,101 +227,110 @@ class EventBus: ObservableObject {
     }
     
     /// 获取事件类型的订阅者数量
-    func getSubscriberCount<T: Event>(for eventType: T.Type) -> Int {
-        return subscriptionQueue.sync {
-            let eventTypeName = String(describing: eventType)
-            return subscriptions[eventTypeName]?.count ?? 0
-        }
+    func getSubscriberCount<T>(for eventType: T.Type) -> Int {
+        let current = withLock { snapshot }
+        guard let typeID = current.typeIDs[ObjectIdentifier(eventType)] else { return 0 }
+        return current.tables[typeID].count
     }
     
     /// 检查是否有事件类型的订阅者
-    func hasSubscribers<T: Event>(for eventType: T.Type) -> Bool {
+    func hasSubscribers<T>(for eventType: T.Type) -> Bool {
         return getSubscriberCount(for: eventType) > 0
     }
     
-    // MARK: - Event Processing
+    // MARK: - Subscription Management
     
-    private func processEvent(_ event: any Event, eventType: String, priority: EventPriority) {
-        // 缓存最近事件用于调试
-        recentEvents.append((event: event, timestamp: Date()))
-        if recentEvents.count > maxRecentEvents {
-            recentEvents.removeFirst(recentEvents.count - maxRecentEvents)
-        }
-        
-        // 获取订阅者并按优先级排序
-        guard let eventSubscriptions = subscriptions[eventType] else {
-            print("⚠️ EventBus: 没有找到事件 \(eventType) 的订阅者")
-            return
-        }
-        
-        let sortedSubscriptions = eventSubscriptions.sorted { lhs, rhs in
-            lhs.priority.rawValue > rhs.priority.rawValue
+    private func addSubscription<T>(_ subscription: Subscription, for eventType: T.Type) -> UUID {
+        let count: Int = withLock {
+            var typeIDs = snapshot.typeIDs
+            var typeNames = snapshot.typeNames
+            var tables = snapshot.tables
+            
+            // 第一次出现的事件类型分配新 ID
+            let key = ObjectIdentifier(eventType)
+            let typeID: Int
+            if let existing = typeIDs[key] {
+                typeID = existing
+            } else {
+                typeID = tables.count
+                typeIDs[key] = typeID
+                typeNames.append(String(describing: eventType))
+                tables.append([])
+            }
+            
+            // 插入到同优先级订阅者之后，保持按优先级从高到低
+            var table = tables[typeID]
+            let index = table.firstIndex { $0.priority.rawValue < subscription.priority.rawValue } ?? table.count
+            table.insert(subscription, at: index)
+            tables[typeID] = table
+            
+            snapshot = Snapshot(typeIDs: typeIDs, typeNames: typeNames, tables: tables)
+            return snapshot.subscriptionCount
         }
         
-        // 分发事件给订阅者
-        for subscription in sortedSubscriptions {
-            subscription.queue.async {
-                subscription.handler(event)
-            }
+        DispatchQueue.main.async { [weak self] in
+            self?.statistics.recordSubscription()
+            self?.activeSubscriptions = count
         }
         
-        print("📬 EventBus: 事件 \(eventType) 已分发给 \(sortedSubscriptions.count) 个订阅者")
+        return subscription.id
     }
     
-    private func addSubscription(_ subscription: Subscription, for eventType: String) {
-        if subscriptions[eventType] == nil {
-            subscriptions[eventType] = []
-        }
-        subscriptions[eventType]?.append(subscription)
+    private func withLock<R>(_ body: () -> R) -> R {
+        lock.lock()
+        defer { lock.unlock() }
+        return body()
     }
     
-    private func removeSubscription(_ subscriptionId: UUID) {
-        for (eventType, subs) in subscriptions {
-            subscriptions[eventType] = subs.filter { $0.id != subscriptionId }
-            
-            // 如果该事件类型没有订阅者了，移除该条目
-            if subscriptions[eventType]?.isEmpty == true {
-                subscriptions.removeValue(forKey: eventType)
+    // MARK: - Diagnostics Recording
+    
+    private func recordPublication(eventType: String, weight: Int) {
+        statisticsQueue.async { [weak self] in
+            guard let self = self else { return }
+            self.recentEvents.append((eventType: eventType, timestamp: Date()))
+            if self.recentEvents.count > self.maxRecentEvents {
+                self.recentEvents.removeFirst(self.recentEvents.count - self.maxRecentEvents)
+            }
+            DispatchQueue.main.async {
+                self.statistics.recordPublication(eventType: eventType, weight: weight)
+                self.lastPublishedEventType = eventType
             }
         }
     }
     
-    private func updateActiveSubscriptionsCount() {
-        let count = subscriptions.values.reduce(0) { $0 + $1.count }
-        activeSubscriptions = count
-    }
-    
     // MARK: - Debug and Diagnostics
     
     /// 获取调试信息
     var debugInfo: String {
-        return subscriptionQueue.sync {
-            var info = "EventBus Debug Info:\n"
-            info += "- 活跃订阅: \(activeSubscriptions)\n"
-            info += "- 已发布事件: \(statistics.totalPublished)\n"
-            info += "- 事件类型数: \(subscriptions.count)\n"
-            
-            if !subscriptions.isEmpty {
-                info += "- 订阅详情:\n"
-                for (eventType, subs) in subscriptions.sorted(by: { $0.key < $1.key }) {
-                    info += "  • \(eventType): \(subs.count) 个订阅者\n"
-                }
+        let current = withLock { snapshot }
+        var info = "EventBus Debug Info:\n"
+        info += "- 活跃订阅: \(current.subscriptionCount)\n"
+        info += "- 已发布事件: \(statistics.totalPublished)\(diagnosticsSampleRate > 0 ? "（采样估算）" : "（未开启采样）")\n"
+        info += "- 事件类型数: \(current.typeNames.count)\n"
+        
+        let details = zip(current.typeNames, current.tables)
+            .filter { !$0.1.isEmpty }
+            .sorted { $0.0 < $1.0 }
+        if !details.isEmpty {
+            info += "- 订阅详情:\n"
+            for (eventType, subs) in details {
+                info += "  • \(eventType): \(subs.count) 个订阅者\n"
             }
-            
-            return info
         }
+        
+        return info
     }
     
-    /// 获取最近事件历史
+    /// 获取最近事件历史（仅包含采样到的事件）
     func getRecentEvents(limit: Int = 10) -> [(eventType: String, timestamp: Date)] {
-        return Array(recentEvents.suffix(limit)).map { item in
-            (eventType: String(describing: type(of: item.event)), timestamp: item.timestamp)
+        return statisticsQueue.sync {
+            Array(recentEvents.suffix(limit))
         }
     }
     
     /// 清除事件历史和统计
     func clearHistory() {
-        subscriptionQueue.async(flags: .barrier) { [weak self] in
+        statisticsQueue.async { [weak self] in
             self?.recentEvents.removeAll()
         }
         
@@ -434,15 +496,14 @@ extension EventBus {
     
     /// 获取性能指标
     func getPerformanceMetrics() -> PerformanceMetrics {
-        return subscriptionQueue.sync {
-            let subscriberCount = subscriptions.values.reduce(0) { $0 + $1.count }
-            
-            return PerformanceMetrics(
-                averageEventProcessingTime: 0.001, // 简化实现，实际应该测量
-                peakSubscriberCount: subscriberCount,
-                totalEventTypes: subscriptions.count,
-                memoryUsage: recentEvents.count * 64 // 粗略估算
-            )
-        }
+        let current = withLock { snapshot }
+        let recentCount = statisticsQueue.sync { recentEvents.count }
+        
+        return PerformanceMetrics(
+            averageEventProcessingTime: 0.001, // 简化实现，实际应该测量
+            peakSubscriberCount: current.subscriptionCount,
+            totalEventTypes: current.typeNames.count,
+            memoryUsage: recentCount * 64 // 粗略估算
+        )
     }
 }
\ No newline at end of file
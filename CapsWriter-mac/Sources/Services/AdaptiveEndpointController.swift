@@ -0,0 +1,218 @@
+//
+//  AdaptiveEndpointController.swift
+//  CapsWriter-mac
+//
+//  自适应端点检测 - 从字的时间戳学习说话人的停顿习惯，调整判定句末所需的静音时长
+//
+
+import Foundation
+
+// MARK: - 停顿分布
+
+/// 停顿时长分布
+///
+/// 对数分桶的直方图，每加入一个样本，旧样本的权重按 `decay` 衰减，习惯变化后能跟上。
+/// 只保存桶计数，体积固定，便于持久化。
+struct PauseHistogram: Codable, Equatable {
+
+    /// 分桶范围（秒），超出范围的样本计入两端的桶
+    static let lowerBound: TimeInterval = 0.02
+    static let upperBound: TimeInterval = 5.0
+    static let binCount = 32
+
+    private(set) var counts: [Double] = Array(repeating: 0, count: PauseHistogram.binCount)
+    private(set) var total: Double = 0
+
+    mutating func add(_ pause: TimeInterval, decay: Double) {
+        guard pause > 0 else { return }
+        for i in counts.indices {
+            counts[i] *= decay
+        }
+        total = total * decay + 1
+        counts[Self.bin(for: pause)] += 1
+    }
+
+    /// 分位数，样本权重不足 `minimumWeight` 时返回 nil
+    func quantile(_ q: Double, minimumWeight: Double) -> TimeInterval? {
+        guard total >= minimumWeight, total > 0 else { return nil }
+        let target = q * total
+        var accumulated = 0.0
+        for (i, count) in counts.enumerated() where count > 0 {
+            if accumulated + count >= target {
+                // 桶内按对数均匀插值
+                let fraction = (target - accumulated) / count
+                return Self.edge(Double(i) + fraction)
+            }
+            accumulated += count
+        }
+        return Self.upperBound
+    }
+
+    private static var logSpan: Double { log(upperBound / lowerBound) }
+
+    private static func bin(for pause: TimeInterval) -> Int {
+        let position = log(max(pause, lowerBound) / lowerBound) / logSpan * Double(binCount)
+        return min(max(Int(position), 0), binCount - 1)
+    }
+
+    private static func edge(_ position: Double) -> TimeInterval {
+        lowerBound * exp(position / Double(binCount) * logSpan)
+    }
+}
+
+// MARK: - 停顿档案
+
+/// 一位说话人的停顿档案（持久化到磁盘）
+struct EndpointProfile: Codable, Equatable {
+    /// 句内相邻两个字之间的间隔
+    var wordPauses = PauseHistogram()
+    /// 一句结束到下一句开始之间的间隔
+    var sentencePauses = PauseHistogram()
+}
+
+// MARK: - 自适应端点检测
+
+/// 自适应端点检测
+///
+/// 识别器内置的端点规则用固定的静音时长：说得快的人句末要多等，说得慢的人句中停顿会被切断。
+/// 这里从每句最终结果的字时间戳学习句内停顿和句间停顿的分布，据此决定句末需要的静音时长：
+/// - 句内停顿的高分位数乘上余量，说话人在句中很少停这么久
+/// - 不超过句间停顿的低分位数，说话人在句间通常至少停这么久
+/// - 限制在 `minimumSilence`…`maximumSilence` 之间；样本不足时用 `fallbackSilence`
+///
+/// 结果中没有时间戳的模型（例如流式 Paraformer）只能用识别文字最后一次变化的时间代替最后一个字的时间，
+/// 这时不学习，始终使用 `fallbackSilence`。
+///
+/// 不是线程安全的，只在识别器的处理队列上使用。
+struct AdaptiveEndpointController {
+
+    // MARK: - Configuration
+
+    struct Configuration {
+        /// 静音时长的下限和上限（秒）
+        var minimumSilence: TimeInterval = 0.4
+        var maximumSilence: TimeInterval = 2.0
+        /// 没有足够样本时使用的静音时长（秒），一般取识别器的 rule2
+        var fallbackSilence: TimeInterval = 1.2
+        /// 一直没有识别出字时，静音多久算结束（秒），对应 rule1
+        var noSpeechSilence: TimeInterval = 2.4
+        /// 一句最长多久（秒），对应 rule3
+        var maximumUtteranceLength: TimeInterval = 20.0
+        /// 句内停顿分位数及余量
+        var wordPauseQuantile: Double = 0.98
+        var wordPauseMargin: Double = 1.5
+        /// 句间停顿分位数
+        var sentencePauseQuantile: Double = 0.25
+        /// 每个样本的衰减系数，0.998 约等于最近 350 个样本权重减半
+        var decay: Double = 0.998
+        /// 开始自适应需要的样本权重
+        var minimumWordSamples: Double = 40
+        var minimumSentenceSamples: Double = 5
+    }
+
+    let configuration: Configuration
+    private(set) var profile: EndpointProfile
+
+    // MARK: - State
+
+    /// 上一句最后一个字在整个会话中的时间（秒）
+    private var previousSegmentEnd: TimeInterval?
+
+    // MARK: - Initialization
+
+    init(configuration: Configuration = Configuration(), profile: EndpointProfile = EndpointProfile()) {
+        self.configuration = configuration
+        self.profile = profile
+    }
+
+    // MARK: - Decision
+
+    /// 当前判定句末需要的静音时长（秒）
+    var trailingSilenceThreshold: TimeInterval {
+        let config = configuration
+        guard let wordPause = profile.wordPauses.quantile(config.wordPauseQuantile,
+                                                          minimumWeight: config.minimumWordSamples) else {
+            return clamp(config.fallbackSilence)
+        }
+
+        var threshold = wordPause * config.wordPauseMargin
+        if let sentencePause = profile.sentencePauses.quantile(config.sentencePauseQuantile,
+                                                               minimumWeight: config.minimumSentenceSamples),
+           sentencePause > wordPause {
+            threshold = min(threshold, sentencePause)
+        }
+        return clamp(threshold)
+    }
+
+    /// 当前这句是否已经结束
+    /// - Parameters:
+    ///   - lastTokenTime: 最后一个字在这句中的时间（秒），还没有字时为 nil
+    ///   - audioTime: 这句已送入的音频时长（秒）
+    func isEndpoint(lastTokenTime: TimeInterval?, audioTime: TimeInterval) -> Bool {
+        if audioTime >= configuration.maximumUtteranceLength {
+            return true
+        }
+        guard let lastTokenTime = lastTokenTime else {
+            return audioTime >= configuration.noSpeechSilence
+        }
+        return audioTime - lastTokenTime >= trailingSilenceThreshold
+    }
+
+    // MARK: - Learning
+
+    /// 学习一句最终结果的字时间戳
+    /// - Parameters:
+    ///   - tokenTimes: 每个字在这句中的时间（秒）
+    ///   - segmentStart: 这句在整个会话中的起始时间（秒），用于计算句间停顿
+    mutating func learn(tokenTimes: [Float], segmentStart: TimeInterval) {
+        guard !tokenTimes.isEmpty else { return }
+        let decay = configuration.decay
+
+        for i in tokenTimes.indices.dropFirst() {
+            profile.wordPauses.add(TimeInterval(tokenTimes[i] - tokenTimes[i - 1]), decay: decay)
+        }
+
+        let start = segmentStart + TimeInterval(tokenTimes[0])
+        if let previousEnd = previousSegmentEnd, start > previousEnd {
+            profile.sentencePauses.add(start - previousEnd, decay: decay)
+        }
+        previousSegmentEnd = segmentStart + TimeInterval(tokenTimes[tokenTimes.count - 1])
+    }
+
+    /// 会话结束（松开按键等），下一句与这句之间的间隔不算句间停顿
+    mutating func endSession() {
+        previousSegmentEnd = nil
+    }
+
+    // MARK: - Persistence
+
+    /// 默认档案位置：~/Library/Application Support/CapsWriter-mac/EndpointProfile.json
+    static func defaultProfileURL() -> URL {
+        let appSupport = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask).first!
+        return appSupport.appendingPathComponent("CapsWriter-mac/EndpointProfile.json")
+    }
+
+    static func loadProfile(from url: URL = defaultProfileURL()) -> EndpointProfile {
+        guard let data = try? Data(contentsOf: url),
+              let profile = try? JSONDecoder().decode(EndpointProfile.self, from: data) else {
+            return EndpointProfile()
+        }
+        return profile
+    }
+
+    static func saveProfile(_ profile: EndpointProfile, to url: URL = defaultProfileURL()) {
+        do {
+            try FileManager.default.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true)
+            let data = try JSONEncoder().encode(profile)
+            try data.write(to: url, options: .atomic)
+        } catch {
+            print("⚠️ AdaptiveEndpointController: 保存停顿档案失败: \(error.localizedDescription)")
+        }
+    }
+
+    // MARK: - Helpers
+
+    private func clamp(_ value: TimeInterval) -> TimeInterval {
+        min(max(value, configuration.minimumSilence), configuration.maximumSilence)
+    }
+}
@@ -24,6 +24,9 @@ protocol HotWordServiceProtocol: ServiceLifecycleProtocol {
     
     /// 移除运行时热词
     func removeRuntimeHotWord(original: String, type: HotWordType)
+    
+    /// 最长一条热词或规则可能匹配的字数（增量处理时尾部窗口不能比它短）
+    var maxMatchLength: Int { get }
 }
 
 // MARK: - Supporting Types
@@ -207,6 +210,13 @@ class HotWordService: ObservableObject, HotWordServiceProtocol {
     /// 所有热词的扁平字典 - 用于快速查找，按优先级排序
     private var flatDictionary: [String: HotWordEntry] = [:]
     
+    /// 按优先级排好序的普通热词，重建字典时更新，替换时不必每次排序
+    private var sortedEntries: [(original: String, entry: HotWordEntry)] = []
+    
+    /// 最长匹配字数；规则是正则表达式，匹配长度没有上限，至少按 ruleMatchWindow 字估计
+    private var matchLengthLimit = 0
+    private let ruleMatchWindow = 32
+    
     /// 正则表达式缓存 - 用于规则类型的热词
     private var regexCache: [String: NSRegularExpression] = [:]
     
@@ -387,6 +397,10 @@ class HotWordService: ObservableObject, HotWordServiceProtocol {
         }
     }
     
+    var maxMatchLength: Int {
+        return hotWordQueue.sync { matchLengthLimit }
+    }
+    
     func getStatistics(completion: @escaping (HotWordStatistics) -> Void) {
         hotWordQueue.async { [weak self] in
             let result = self?.statistics ?? HotWordStatistics(
@@ -563,6 +577,15 @@ class HotWordService: ObservableObject, HotWordServiceProtocol {
         }
         
         flatDictionary = newFlatDictionary
+        sortedEntries = newFlatDictionary
+            .filter { $0.value.type != .rule }
+            .sorted { $0.value.priority > $1.value.priority }
+            .map { (original: $0.key, entry: $0.value) }
+        
+        let longestWord = sortedEntries.map { $0.original.count }.max() ?? 0
+        let longestRule = hotWordDictionaries[.rule]?.keys.map { max($0.count, ruleMatchWindow) }.max() ?? 0
+        matchLengthLimit = max(longestWord, longestRule)
+        
         logger.debug("🔨 扁平字典重建完成，共 \(self.flatDictionary.count) 条")
     }
     
@@ -607,14 +630,14 @@ class HotWordService: ObservableObject, HotWordServiceProtocol {
         }
         
         // 2. 处理普通字符串替换（按优先级）
-        for (original, entry) in flatDictionary.sorted(by: { $0.value.priority > $1.value.priority }) {
+        for (original, entry) in sortedEntries {
             // 🔒 超时检查：防止长时间执行
             if Date().timeIntervalSince(processingStartTime) > maxProcessingTime {
                 logger.warning("⚠️ 文本处理超时，停止字符串替换处理")
                 break
             }
             
-            if entry.type != .rule && result.contains(original) {
+            if result.contains(original) {
                 // 🔒 安全替换：限制替换次数
                 result = performSafeStringReplacement(
                     text: result,
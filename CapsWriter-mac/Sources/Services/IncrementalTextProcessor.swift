@@ -0,0 +1,87 @@
+//
+//  IncrementalTextProcessor.swift
+//  CapsWriter-mac
+//
+//  增量文本处理 - 部分结果只在末尾增长时，只重新处理末尾的一小段
+//
+
+import Foundation
+
+/// 增量文本处理
+///
+/// 热词替换这类只看局部的处理，结果只受附近 `window` 个字影响（`window` 不短于最长的匹配）。
+/// 离末尾超过 `window` 的部分不会再被新增的字改变，可以冻结下来，之后只处理冻结点之后的尾部：
+/// - 尾部超过两个窗口时，在倒数第 `window` 个字处分开处理，与整段处理结果一致才冻结前一段
+/// - 新的输入从离冻结点不足一个窗口处开始改动时，退回到更早的冻结点
+///
+/// 每次的处理量与尾部长度成正比，与整句长度无关。
+struct IncrementalTextProcessor {
+
+    /// 一段已冻结的输入及其处理结果
+    private struct Segment {
+        let rawEnd: Int
+        let output: String
+    }
+
+    let window: Int
+    private let transform: (String) -> String
+
+    /// 上一次的输入
+    private var raw: [Character] = []
+    private var segments: [Segment] = []
+    private var frozenOutput = ""
+
+    init(window: Int, transform: @escaping (String) -> String) {
+        self.window = max(window, 1)
+        self.transform = transform
+    }
+
+    /// 处理新的输入，返回整段的处理结果
+    mutating func process(_ text: String) -> String {
+        let chars = Array(text)
+        let common = Self.commonPrefixLength(raw, chars)
+        raw = chars
+
+        // 改动离冻结点不足一个窗口（新的匹配可能跨过冻结点），退回到更早的冻结点
+        if let last = segments.last, last.rawEnd + window > common {
+            while let last = segments.last, last.rawEnd + window > common {
+                segments.removeLast()
+            }
+            frozenOutput = segments.map(\.output).joined()
+        }
+
+        let frozenEnd = segments.last?.rawEnd ?? 0
+        let tailOutput = transform(String(chars[frozenEnd...]))
+        let result = frozenOutput + tailOutput
+
+        // 尾部足够长时，把末尾窗口之前的部分冻结
+        if chars.count - frozenEnd >= 2 * window {
+            let boundary = chars.count - window
+            let head = transform(String(chars[frozenEnd..<boundary]))
+            let rest = transform(String(chars[boundary...]))
+            // 有匹配跨过分界点时两种结果不同，下次再试
+            if head + rest == tailOutput {
+                segments.append(Segment(rawEnd: boundary, output: head))
+                frozenOutput += head
+            }
+        }
+
+        return result
+    }
+
+    /// 丢弃所有状态（开始新的一句）
+    mutating func reset() {
+        raw = []
+        segments = []
+        frozenOutput = ""
+    }
+
+    private static func commonPrefixLength(_ a: [Character], _ b: [Character]) -> Int {
+        var i = 0
+        let n = min(a.count, b.count)
+        while i < n && a[i] == b[i] {
+            i += 1
+        }
+        return i
+    }
+}
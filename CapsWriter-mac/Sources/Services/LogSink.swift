@@ -0,0 +1,275 @@
+//
+//  LogSink.swift
+//  CapsWriter-mac
+//
+//  异步批量日志后端 - 每线程无锁环 + 单写入线程 + 内存映射轮转文件
+//
+
+import Foundation
+
+// MARK: - 日志写入线程
+
+/// 日志写入线程
+///
+/// 写日志的线程只调用 `push`，把原始字段拷进自己线程的环（见 LogRing.h），不格式化、不加锁。
+/// 唯一的写入线程定期把所有环取空，按时间排序后整批交给 `handler` 格式化输出。
+final class LogSink {
+
+    // MARK: - Singleton
+
+    static let shared = LogSink()
+
+    // MARK: - Properties
+
+    /// 处理一批日志（在写入线程上调用），第二个参数是这段时间内被丢弃的条数
+    /// 空闲时也会以空批次定期调用，便于处理方做定时刷新
+    var handler: (([LogEntry], UInt64) -> Void)?
+
+    /// 空闲时的轮询间隔
+    private let idleInterval: TimeInterval = 0.02
+
+    /// 每次最多取出的条数
+    private let batchCapacity = 4096
+    private let buffer: UnsafeMutablePointer<cw_log_record>
+
+    private let wakeup = DispatchSemaphore(value: 0)
+    private let flushDone = DispatchSemaphore(value: 0)
+    private let stateLock = NSLock()
+    private var flushRequests = 0
+    private var thread: Thread?
+
+    // MARK: - Initialization
+
+    private init() {
+        buffer = UnsafeMutablePointer<cw_log_record>.allocate(capacity: batchCapacity)
+        let thread = Thread { [weak self] in
+            self?.run()
+        }
+        thread.name = "com.capswriter.log-sink"
+        thread.qualityOfService = .utility
+        self.thread = thread
+        thread.start()
+    }
+
+    deinit {
+        buffer.deallocate()
+    }
+
+    // MARK: - Producer
+
+    /// 写入一条日志，任何线程（包括音频回调）都可以调用，环满时丢弃，不会阻塞
+    @discardableResult
+    func push(level: LogLevel, category: LogCategory, message: String, file: String, function: String, line: Int) -> Bool {
+        var message = message
+        return message.withUTF8 { bytes in
+            file.withCString { filePtr in
+                function.withCString { functionPtr in
+                    bytes.withMemoryRebound(to: CChar.self) { text in
+                        cw_log_push(
+                            Date().timeIntervalSince1970,
+                            UInt8(level.ringIndex),
+                            UInt8(category.ringIndex),
+                            UInt32(clamping: line),
+                            filePtr,
+                            functionPtr,
+                            text.baseAddress,
+                            text.count
+                        )
+                    }
+                }
+            }
+        }
+    }
+
+    /// 等待已写入的日志全部处理完（退出前调用）
+    func flush(timeout: TimeInterval = 1.0) {
+        stateLock.lock()
+        flushRequests += 1
+        stateLock.unlock()
+        wakeup.signal()
+        _ = flushDone.wait(timeout: .now() + timeout)
+    }
+
+    // MARK: - Writer Thread
+
+    private func run() {
+        while true {
+            let entries = drain()
+            let dropped = cw_log_take_dropped()
+            handler?(entries, dropped)
+
+            stateLock.lock()
+            let requests = flushRequests
+            flushRequests = 0
+            stateLock.unlock()
+            for _ in 0..<requests {
+                flushDone.signal()
+            }
+
+            // 取满一批说明还有积压，立即继续
+            if entries.count < batchCapacity {
+                _ = wakeup.wait(timeout: .now() + idleInterval)
+            }
+        }
+    }
+
+    private func drain() -> [LogEntry] {
+        let count = cw_log_drain(buffer, batchCapacity)
+        guard count > 0 else { return [] }
+
+        var entries: [LogEntry] = []
+        entries.reserveCapacity(count)
+        for i in 0..<count {
+            entries.append(LogEntry(record: &buffer[i]))
+        }
+        // 不同线程的环依次取出，合并成时间顺序
+        entries.sort { $0.timestamp < $1.timestamp }
+        return entries
+    }
+}
+
+// MARK: - 记录转换
+
+extension LogLevel {
+    var ringIndex: Int {
+        LogLevel.allCases.firstIndex(of: self) ?? 0
+    }
+}
+
+extension LogCategory {
+    var ringIndex: Int {
+        LogCategory.allCases.firstIndex(of: self) ?? 0
+    }
+}
+
+extension LogEntry {
+    /// 由环中的原始记录构造（在写入线程上调用）
+    init(record: inout cw_log_record) {
+        let level = LogLevel.allCases[min(Int(record.level), LogLevel.allCases.count - 1)]
+        let category = LogCategory.allCases[min(Int(record.category), LogCategory.allCases.count - 1)]
+        var message = LogEntry.string(from: &record.message)
+        if record.truncated != 0 {
+            message += "…"
+        }
+        self.init(
+            timestamp: Date(timeIntervalSince1970: record.timestamp),
+            level: level,
+            category: category,
+            message: message,
+            file: LogEntry.string(from: &record.file),
+            function: LogEntry.string(from: &record.function),
+            line: Int(record.line),
+            thread: record.is_main_thread != 0 ? "Main" : "Background"
+        )
+    }
+
+    /// C 定长字符数组转 String
+    private static func string<T>(from tuple: inout T) -> String {
+        withUnsafePointer(to: &tuple) { pointer in
+            pointer.withMemoryRebound(to: CChar.self, capacity: MemoryLayout<T>.size) {
+                String(cString: $0)
+            }
+        }
+    }
+}
+
+// MARK: - 内存映射日志文件
+
+/// 内存映射的轮转日志文件
+///
+/// 文件按 `capacity` 预先扩展并映射到内存，写入就是一次内存拷贝，由系统负责落盘。
+/// 写满时截掉未用部分、改名为备份，再映射一个新文件。
+final class MappedLogFile {
+
+    let url: URL
+    private let capacity: Int
+    private var fd: Int32 = -1
+    private var base: UnsafeMutableRawPointer?
+    private var cursor = 0
+
+    init?(url: URL, capacity: Int) {
+        self.url = url
+        self.capacity = capacity
+        guard open() else { return nil }
+    }
+
+    deinit {
+        close()
+    }
+
+    /// 追加一批已格式化的日志
+    func append(_ data: Data) {
+        guard !data.isEmpty else { return }
+        if cursor + data.count > capacity {
+            rotate()
+        }
+        guard let base = base, cursor + data.count <= capacity else { return }
+        data.withUnsafeBytes { bytes in
+            (base + cursor).copyMemory(from: bytes.baseAddress!, byteCount: data.count)
+        }
+        cursor += data.count
+    }
+
+    /// 异步把已写入的部分刷到磁盘
+    func sync() {
+        guard let base = base, cursor > 0 else { return }
+        msync(base, cursor, MS_ASYNC)
+    }
+
+    func close() {
+        guard fd >= 0 else { return }
+        if let base = base {
+            msync(base, cursor, MS_SYNC)
+            munmap(base, capacity)
+        }
+        // 去掉预分配的空白部分
+        ftruncate(fd, off_t(cursor))
+        Darwin.close(fd)
+        fd = -1
+        base = nil
+    }
+
+    private func open() -> Bool {
+        try? FileManager.default.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true)
+        fd = Darwin.open(url.path, O_RDWR | O_CREAT, 0o644)
+        guard fd >= 0 else { return false }
+
+        // 接着已有内容往后写；上次异常退出时文件尾部可能是预分配的 0
+        var existing = Int(lseek(fd, 0, SEEK_END))
+        if existing >= capacity {
+            Darwin.close(fd)
+            fd = -1
+            rotateFile()
+            return open()
+        }
+
+        guard ftruncate(fd, off_t(capacity)) == 0,
+              let mapped = mmap(nil, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0),
+              mapped != MAP_FAILED else {
+            Darwin.close(fd)
+            fd = -1
+            return false
+        }
+
+        let bytes = mapped.assumingMemoryBound(to: UInt8.self)
+        while existing > 0 && bytes[existing - 1] == 0 {
+            existing -= 1
+        }
+        base = mapped
+        cursor = existing
+        return true
+    }
+
+    private func rotate() {
+        close()
+        rotateFile()
+        _ = open()
+    }
+
+    private func rotateFile() {
+        let formatter = DateFormatter()
+        formatter.dateFormat = "HHmmss"
+        let backupURL = url.appendingPathExtension("backup-\(formatter.string(from: Date()))")
+        try? FileManager.default.moveItem(at: url, to: backupURL)
+    }
+}
@@ -109,6 +109,19 @@ struct LogEntry: Identifiable, Codable {
         self.thread = Thread.isMainThread ? "Main" : "Background"
     }
     
+    /// 由已采集的字段初始化（日志写入线程上使用，时间和线程取写日志时的值）
+    init(timestamp: Date, level: LogLevel, category: LogCategory, message: String, file: String, function: String, line: Int, thread: String) {
+        self.id = UUID()
+        self.timestamp = timestamp
+        self.level = level
+        self.category = category
+        self.message = message
+        self.file = file
+        self.function = function
+        self.line = line
+        self.thread = thread
+    }
+    
     /// 格式化时间戳
     var formattedTimestamp: String {
         let formatter = DateFormatter()
@@ -178,6 +191,9 @@ class LoggingService: LoggingServiceProtocol, ObservableObject {
     private init() {
         setupLogDestinations()
         setupFileLogging()
+        LogSink.shared.handler = { [weak self] entries, dropped in
+            self?.processBatch(entries, dropped: dropped)
+        }
         print("📋 LoggingService 已初始化")
     }
     
@@ -192,20 +208,28 @@ class LoggingService: LoggingServiceProtocol, ObservableObject {
     /// 启用的输出目标
     private var enabledDestinations: Set<LogDestination> = [.console, .memory, .system]
     
-    /// 线程安全队列
-    private let loggingQueue = DispatchQueue(label: "com.capswriter.logging", qos: .utility)
-    
     /// 系统日志器
     private let osLog = OSLog(subsystem: "com.capswriter.mac", category: "general")
     
-    /// 文件日志器
+    /// 文件日志路径
     private var fileLogURL: URL?
     
+    /// 内存映射的日志文件（仅在日志写入线程上访问）
+    private var mappedFile: MappedLogFile?
+    private var lastFileSync = Date()
+    
     /// 最大内存日志条数
     private let maxMemoryLogs = 1000
     
-    /// 最大文件大小（字节）
-    private let maxFileSize: Int64 = 10 * 1024 * 1024 // 10MB
+    /// 最大文件大小（字节），写满后轮转
+    private let maxFileSize = 10 * 1024 * 1024 // 10MB
+    
+    /// 日志界面的刷新间隔，以及每次刷新最多加入的条数
+    /// 高频日志只抽样显示最新的部分，完整内容在日志文件中
+    private let memoryRefreshInterval: TimeInterval = 0.25
+    private let memorySampleLimit = 200
+    private var pendingMemoryLogs: [LogEntry] = []
+    private var lastMemoryRefresh = Date.distantPast
     
     // MARK: - Setup Methods
     
@@ -284,11 +308,8 @@ class LoggingService: LoggingServiceProtocol, ObservableObject {
         // 级别过滤
         guard level >= minLogLevel else { return }
         
-        let entry = LogEntry(level: level, category: category, message: message, file: file, function: function, line: line)
-        
-        loggingQueue.async { [weak self] in
-            self?.processLogEntry(entry)
-        }
+        // 只拷贝原始字段到当前线程的环，格式化和输出都在日志写入线程上批量进行
+        LogSink.shared.push(level: level, category: category, message: message, file: file, function: function, line: line)
     }
     
     func debug(_ message: String, category: LogCategory, file: String = #file, function: String = #function, line: Int = #line) {
@@ -312,13 +333,16 @@ class LoggingService: LoggingServiceProtocol, ObservableObject {
     }
     
     func clearLogs() {
-        loggingQueue.async { [weak self] in
-            DispatchQueue.main.async {
-                self?.memoryLogs.removeAll()
-            }
+        DispatchQueue.main.async { [weak self] in
+            self?.memoryLogs.removeAll()
         }
     }
     
+    /// 等待已写入的日志全部输出并落盘（退出前调用）
+    func flush() {
+        LogSink.shared.flush()
+    }
+    
     func getLogs(level: LogLevel? = nil, category: LogCategory? = nil, limit: Int? = nil) -> [LogEntry] {
         var filteredLogs = memoryLogs
         
@@ -383,66 +407,80 @@ class LoggingService: LoggingServiceProtocol, ObservableObject {
     
     // MARK: - Private Methods
     
-    /// 处理日志条目
-    private func processLogEntry(_ entry: LogEntry) {
-        // 输出到各个目标
-        for destination in enabledDestinations {
-            outputToDestination(entry, destination: destination)
+    /// 处理一批日志（在日志写入线程上调用）
+    private func processBatch(_ entries: [LogEntry], dropped: UInt64) {
+        var entries = entries
+        if dropped > 0 {
+            entries.append(LogEntry(level: .warning, category: .system, message: "日志缓冲区已满，丢弃了 \(dropped) 条日志"))
+        }
+        let destinations = enabledDestinations
+        
+        // 空批次只做定时刷新
+        guard !entries.isEmpty else {
+            if destinations.contains(.memory) {
+                outputToMemory([])
+            }
+            if destinations.contains(.file) {
+                syncFileIfNeeded()
+            }
+            return
+        }
+        
+        if destinations.contains(.console) {
+            print(entries.map(\.coloredConsoleString).joined(separator: "\n"))
+        }
+        if destinations.contains(.file) {
+            outputToFile(entries)
+        }
+        if destinations.contains(.system) {
+            entries.forEach(outputToSystemLog)
+        }
+        if destinations.contains(.memory) {
+            outputToMemory(entries)
         }
     }
     
-    /// 输出到指定目标
-    private func outputToDestination(_ entry: LogEntry, destination: LogDestination) {
-        switch destination {
-        case .console:
-            outputToConsole(entry)
-        case .file:
-            outputToFile(entry)
-        case .memory:
-            outputToMemory(entry)
-        case .system:
-            outputToSystemLog(entry)
+    /// 输出到文件：整批拼接后一次拷贝进映射区域
+    private func outputToFile(_ entries: [LogEntry]) {
+        guard let fileURL = fileLogURL else { return }
+        if mappedFile?.url != fileURL {
+            mappedFile?.close()
+            mappedFile = MappedLogFile(url: fileURL, capacity: maxFileSize)
         }
+        
+        var text = ""
+        for entry in entries {
+            text += entry.formattedString
+            text += "\n"
+        }
+        mappedFile?.append(Data(text.utf8))
+        syncFileIfNeeded()
     }
     
-    /// 输出到控制台
-    private func outputToConsole(_ entry: LogEntry) {
-        print(entry.coloredConsoleString)
+    /// 每秒最多请求一次异步落盘
+    private func syncFileIfNeeded() {
+        guard Date().timeIntervalSince(lastFileSync) >= 1.0 else { return }
+        mappedFile?.sync()
+        lastFileSync = Date()
     }
     
-    /// 输出到文件
-    private func outputToFile(_ entry: LogEntry) {
-        guard let fileURL = fileLogURL else { return }
-        
-        // 检查文件大小，如果超过限制则轮转
-        if let fileSize = try? FileManager.default.attributesOfItem(atPath: fileURL.path)[.size] as? Int64,
-           fileSize > maxFileSize {
-            rotateLogFile()
+    /// 输出到内存：按刷新间隔合并，每次只取最新的若干条
+    private func outputToMemory(_ entries: [LogEntry]) {
+        pendingMemoryLogs.append(contentsOf: entries)
+        if pendingMemoryLogs.count > memorySampleLimit {
+            pendingMemoryLogs.removeFirst(pendingMemoryLogs.count - memorySampleLimit)
         }
+        guard !pendingMemoryLogs.isEmpty,
+              Date().timeIntervalSince(lastMemoryRefresh) >= memoryRefreshInterval else { return }
         
-        let logString = entry.formattedString + "\n"
+        let batch = pendingMemoryLogs
+        pendingMemoryLogs.removeAll(keepingCapacity: true)
+        lastMemoryRefresh = Date()
         
-        if let data = logString.data(using: .utf8) {
-            if FileManager.default.fileExists(atPath: fileURL.path) {
-                // 追加到现有文件
-                if let fileHandle = try? FileHandle(forWritingTo: fileURL) {
-                    fileHandle.seekToEndOfFile()
-                    fileHandle.write(data)
-                    fileHandle.closeFile()
-                }
-            } else {
-                // 创建新文件
-                try? data.write(to: fileURL)
-            }
-        }
-    }
-    
-    /// 输出到内存
-    private func outputToMemory(_ entry: LogEntry) {
         DispatchQueue.main.async { [weak self] in
             guard let self = self else { return }
             
-            self.memoryLogs.append(entry)
+            self.memoryLogs.append(contentsOf: batch)
             
             // 保持最大条数限制
             if self.memoryLogs.count > self.maxMemoryLogs {
@@ -469,20 +507,6 @@ class LoggingService: LoggingServiceProtocol, ObservableObject {
         
         os_log("%{public}@", log: osLog, type: osLogType, entry.formattedString)
     }
-    
-    /// 轮转日志文件
-    private func rotateLogFile() {
-        guard let currentURL = fileLogURL else { return }
-        
-        // 创建备份文件名
-        let timestamp = DateFormatter().string(from: Date()).replacingOccurrences(of: ":", with: "-")
-        let backupURL = currentURL.appendingPathExtension("backup-\(timestamp)")
-        
-        try? FileManager.default.moveItem(at: currentURL, to: backupURL)
-        
-        // 重新设置文件日志
-        setupFileLogging()
-    }
 }
 
 // MARK: - 全局日志宏定义
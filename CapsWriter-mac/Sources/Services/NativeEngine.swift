@@ -0,0 +1,188 @@
+//
+//  NativeEngine.swift
+//  CapsWriter-mac
+//
+//  共用识别引擎的 Swift 绑定 - 调用 native/ 下的 capswriter_engine（C 接口见 native/include/capswriter_engine.h）
+//
+//  引擎把环形缓冲、重采样、静音切分、收尾补静音、文本管线放在一份 C++ 实现里，
+//  Python 通过 util/native_engine.py 调用同一个库。
+//
+//  默认不编译：先用 CMake 编译 libcapswriter_engine.dylib（-DCAPSWRITER_WITH_SHERPA=ON），
+//  链接到目标并在 Swift 编译条件中加上 CAPSWRITER_NATIVE_ENGINE。
+//  SherpaASRService 等仍用 StreamFinalizer 等 Swift 实现，尚未改为调用这里的绑定。
+//
+
+#if CAPSWRITER_NATIVE_ENGINE
+
+import Foundation
+
+// MARK: - 识别结果
+
+/// 一条识别结果
+struct NativeResult {
+    /// 是否为一句的最终结果（已经过文本管线）
+    let isFinal: Bool
+    /// 句子编号，从 0 开始
+    let index: Int
+    /// 这句在会话中的起始时间（秒）
+    let start: TimeInterval
+    let text: String
+    /// 每个字在这句中的时间（秒），模型不提供时间戳时为空
+    let tokenTimes: [Float]
+}
+
+// MARK: - 引擎
+
+/// 共用识别引擎，直接使用 sherpa-onnx 在线识别器
+///
+/// 不接管识别器：引擎和它的所有会话销毁之后，调用方才能销毁识别器。
+final class NativeEngine {
+
+    fileprivate let handle: OpaquePointer
+
+    init?(recognizer: OpaquePointer) {
+        guard let handle = cw_engine_create_sherpa(recognizer) else {
+            return nil
+        }
+        self.handle = handle
+    }
+
+    deinit {
+        cw_engine_destroy(handle)
+    }
+
+    /// 收尾时要补的静音长度（秒），与 StreamFinalizer.tailPadding 一致
+    static func tailPadding(forModelType modelType: String) -> Float {
+        return cw_tail_padding(modelType)
+    }
+}
+
+// MARK: - 文本管线
+
+/// 调空格 → 中文数字转阿拉伯数字 → 调空格 → 英文热词 → 字面替换规则
+///
+/// 不是线程安全的，多个会话共用时要在同一个处理队列上使用。
+final class NativeTextPipeline {
+
+    fileprivate let handle: OpaquePointer
+
+    init?(spacing: Bool = true, itn: Bool = true, hotwords: Bool = true) {
+        var options = cw_text_options(spacing: spacing ? 1 : 0, itn: itn ? 1 : 0, hotwords: hotwords ? 1 : 0)
+        guard let handle = cw_text_pipeline_create(&options) else {
+            return nil
+        }
+        self.handle = handle
+    }
+
+    deinit {
+        cw_text_pipeline_destroy(handle)
+    }
+
+    /// 英文热词：忽略大小写和词内空格匹配，替换为热词原文
+    func addHotword(_ hotword: String) {
+        cw_text_pipeline_add_hotword(handle, hotword)
+    }
+
+    /// 字面替换规则
+    func addRule(from: String, to: String) {
+        cw_text_pipeline_add_rule(handle, from, to)
+    }
+
+    func clear() {
+        cw_text_pipeline_clear(handle)
+    }
+
+    func process(_ text: String) -> String {
+        guard let result = cw_text_pipeline_process(handle, text) else {
+            return text
+        }
+        defer { cw_string_free(result) }
+        return String(cString: result)
+    }
+}
+
+// MARK: - 会话
+
+/// 一路识别会话
+///
+/// `write` 可以在音频回调中调用（不加锁、不分配内存）；其他方法只能在同一个处理队列上调用。
+final class NativeSession {
+
+    private let handle: OpaquePointer
+    // 持有引擎和文本管线，保证它们比会话活得久
+    private let engine: NativeEngine
+    private var pipeline: NativeTextPipeline?
+
+    /// 默认配置：16kHz 单声道输入，端点检测切句
+    static var defaultConfig: cw_session_config {
+        return cw_session_config_default()
+    }
+
+    init?(engine: NativeEngine, config: cw_session_config = NativeSession.defaultConfig) {
+        var config = config
+        guard let handle = cw_session_create(engine.handle, &config) else {
+            return nil
+        }
+        self.handle = handle
+        self.engine = engine
+    }
+
+    deinit {
+        cw_session_destroy(handle)
+    }
+
+    /// 最终结果经过的文本管线，nil 表示不处理
+    func setTextPipeline(_ pipeline: NativeTextPipeline?) {
+        self.pipeline = pipeline
+        cw_session_set_text_pipeline(handle, pipeline?.handle)
+    }
+
+    /// 写入交错的 float32 音频，返回实际写入的帧数（缓冲区满时丢弃）
+    @discardableResult
+    func write(_ samples: UnsafePointer<Float>, frames: Int) -> Int {
+        return Int(cw_session_write(handle, samples, Int32(frames)))
+    }
+
+    /// 处理已写入的音频，返回新产生的结果
+    func process() -> [NativeResult] {
+        _ = cw_session_process(handle)
+        return poll()
+    }
+
+    /// 结束输入，补尾部静音并解完，返回新产生的结果（包括这句的最终结果）
+    func finish() -> [NativeResult] {
+        _ = cw_session_finish(handle)
+        return poll()
+    }
+
+    /// 丢弃未处理的音频和结果
+    func reset() {
+        cw_session_reset(handle)
+    }
+
+    /// 缓冲区满时被丢弃的帧数
+    var overflow: UInt64 {
+        return cw_session_overflow(handle)
+    }
+
+    private func poll() -> [NativeResult] {
+        var results: [NativeResult] = []
+        var result = cw_result()
+        while cw_session_poll(handle, &result) == 1 {
+            var times: [Float] = []
+            if let timestamps = result.timestamps, result.count > 0 {
+                times = Array(UnsafeBufferPointer(start: timestamps, count: Int(result.count)))
+            }
+            results.append(NativeResult(
+                isFinal: result.is_final == 1,
+                index: Int(result.index),
+                start: result.start,
+                text: result.text.map { String(cString: $0) } ?? "",
+                tokenTimes: times
+            ))
+        }
+        return results
+    }
+}
+
+#endif
@@ -20,7 +20,8 @@ class OptimizedSherpaASRService: ObservableObject, SpeechRecognitionServiceProto
     @Published var isInitialized: Bool = false
     @Published var partialTranscript: String = ""
     @Published var logs: [String] = []
-    @Published var transcriptHistory: [TranscriptEntry] = []
+    let historyStore = TranscriptHistoryStore.shared
+    var transcriptHistory: [TranscriptEntry] { historyStore.window }
     @Published var performanceMetrics = RecognitionPerformanceMetrics()
     
     // MARK: - Private Properties
@@ -139,13 +140,11 @@ class OptimizedSherpaASRService: ObservableObject, SpeechRecognitionServiceProto
         
         addLog("⏹️ 停止优化识别处理...")
         
-        // 处理批处理队列中的剩余音频
-        batchQueue.async { [weak self] in
-            self?.processPendingBatch()
-        }
-        
-        recognitionQueue.async { [weak self] in
-            self?.finalizeOptimizedRecognition()
+        // 按 预处理 → 批处理 → 识别 的顺序排队，保证收尾解码排在最后一段音频之后
+        preprocessingQueue.async { [weak self] in
+            self?.batchQueue.async {
+                self?.processPendingBatch()
+            }
         }
         
         isRecognizing = false
@@ -169,12 +168,7 @@ class OptimizedSherpaASRService: ObservableObject, SpeechRecognitionServiceProto
             isPartial: isPartial
         )
         
-        DispatchQueue.main.async {
-            self.transcriptHistory.append(entry)
-            if self.transcriptHistory.count > 100 {
-                self.transcriptHistory.removeFirst(self.transcriptHistory.count - 100)
-            }
-        }
+        historyStore.append(entry)
     }
     
     // MARK: - Optimized Recognition Implementation
@@ -475,14 +469,18 @@ class OptimizedSherpaASRService: ObservableObject, SpeechRecognitionServiceProto
         recognitionStats.endpointsDetected += 1
     }
     
+    /// 送出不足一批的剩余音频，随后收尾解码（在 batchQueue 上调用）
     private func processPendingBatch() {
-        if !audioBatch.isEmpty {
-            let batch = audioBatch
-            audioBatch.removeAll()
-            
-            recognitionQueue.sync {
-                processBatch(batch)
+        let batch = audioBatch
+        audioBatch.removeAll()
+        
+        // 提高优先级：松开按键到出字的等待最影响体验
+        recognitionQueue.async(qos: .userInteractive, flags: .enforceQoS) { [weak self] in
+            guard let self = self else { return }
+            if !batch.isEmpty {
+                self.processBatch(batch)
             }
+            self.finalizeOptimizedRecognition()
         }
     }
     
@@ -492,21 +490,30 @@ class OptimizedSherpaASRService: ObservableObject, SpeechRecognitionServiceProto
             return
         }
         
-        // 获取最终结果
-        if let result = SherpaOnnxGetOnlineStreamResult(recognizer, stream) {
-            let finalText = getTextFromResultSafely(result)
-            
-            if !finalText.isEmpty {
-                let processedText = resultPostprocessor?.process(finalText) ?? finalText
-                DispatchQueue.main.async {
-                    self.delegate?.speechRecognitionDidReceiveFinalResult(processedText)
-                }
+        // 结束输入、补尾部静音、解完剩余帧，不等端点检测
+        let outcome = StreamFinalizer.finalize(
+            recognizer: recognizer,
+            stream: stream,
+            sampleRate: Int(sampleRate),
+            tailPadding: StreamFinalizer.tailPadding(forModelType: configManager.recognition.modelType),
+            timeout: configManager.recognition.finalizeTimeout,
+            extractText: getTextFromResultSafely
+        )
+        // 原来的流已销毁，下一句使用新的流
+        self.stream = outcome.stream
+        performanceMonitor.recordRecognitionDelay(outcome.elapsed)
+        if outcome.timedOut {
+            addLog("⚠️ 收尾解码超时（\(Int(outcome.elapsed * 1000))ms），使用当前结果")
+        }
+        
+        if !outcome.text.isEmpty {
+            let processedText = resultPostprocessor?.process(outcome.text) ?? outcome.text
+            DispatchQueue.main.async {
+                self.delegate?.speechRecognitionDidReceiveFinalResult(processedText)
             }
-            
-            SherpaOnnxDestroyOnlineRecognizerResult(result)
         }
         
-        addLog("✅ 优化识别处理完成")
+        addLog("✅ 优化识别处理完成（收尾 \(outcome.decodeCount) 次解码，\(Int(outcome.elapsed * 1000))ms）")
     }
     
     private func cleanupOptimizedRecognizer() {
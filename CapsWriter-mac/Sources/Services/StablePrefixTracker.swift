@@ -0,0 +1,140 @@
+//
+//  StablePrefixTracker.swift
+//  CapsWriter-mac
+//
+//  稳定前缀检测 - 从连续的部分识别结果中找出不会再变的开头，边说边上屏
+//
+
+import Foundation
+
+/// 稳定前缀检测
+///
+/// 流式识别的部分结果末尾经常被改写，开头则很快稳定下来。一段文字同时满足下面两个条件才算稳定：
+/// - 最近 `agreementCount` 次部分结果的公共前缀都包含它（局部一致）
+/// - 它在部分结果中保持不变已有 `minimumAge` 秒（字龄）
+///
+/// 已提交的前缀只增不减。识别结果改写了已提交的部分时不再提交，记为 `hasDiverged`，
+/// 等最终结果到达后再修正（见 TextReconciler）。
+struct StablePrefixTracker {
+
+    // MARK: - Configuration
+
+    struct Configuration {
+        /// 需要一致的连续部分结果个数
+        var agreementCount: Int = 3
+        /// 字保持不变的最短时间（秒）
+        var minimumAge: TimeInterval = 0.4
+    }
+
+    let configuration: Configuration
+
+    // MARK: - State
+
+    /// 已提交的前缀
+    private(set) var committed: [Character] = []
+
+    /// 识别结果是否改写过已提交的前缀
+    private(set) var hasDiverged = false
+
+    /// 最近几次部分结果
+    private var recent: [[Character]] = []
+
+    /// 当前部分结果，以及其中每个字首次出现的时间
+    private var current: [Character] = []
+    private var firstSeen: [TimeInterval] = []
+
+    var committedText: String { String(committed) }
+
+    // MARK: - Initialization
+
+    init(configuration: Configuration = Configuration()) {
+        self.configuration = configuration
+    }
+
+    // MARK: - Public Methods
+
+    /// 输入一次部分结果，返回这次新提交的文字（没有则为空）
+    mutating func update(_ hypothesis: String, at time: TimeInterval = ProcessInfo.processInfo.systemUptime) -> String {
+        let chars = Array(hypothesis)
+
+        // 与上一次相同的部分保留原来的出现时间，其余的从现在算起
+        let kept = Self.commonPrefixLength(current, chars)
+        firstSeen = Array(firstSeen.prefix(kept)) + Array(repeating: time, count: chars.count - kept)
+        current = chars
+
+        recent.append(chars)
+        if recent.count > configuration.agreementCount {
+            recent.removeFirst(recent.count - configuration.agreementCount)
+        }
+        guard recent.count >= configuration.agreementCount else { return "" }
+
+        // 已提交的部分被改写，不再往后提交
+        guard Self.commonPrefixLength(committed, chars) == committed.count else {
+            if !hasDiverged {
+                print("⚠️ StablePrefixTracker: 识别结果改写了已提交的文字")
+            }
+            hasDiverged = true
+            return ""
+        }
+
+        // 局部一致的长度
+        var agreed = chars.count
+        for previous in recent.dropLast() {
+            agreed = min(agreed, Self.commonPrefixLength(previous, chars))
+        }
+
+        // 字龄足够的长度（firstSeen 单调不减，找到第一个太新的字即可）
+        let aged = firstSeen.firstIndex { time - $0 < configuration.minimumAge } ?? chars.count
+
+        var end = min(agreed, aged)
+
+        // 不把英文单词、数字从中间切开
+        while end > committed.count && end < chars.count
+                && Self.isWordCharacter(chars[end - 1]) && Self.isWordCharacter(chars[end]) {
+            end -= 1
+        }
+
+        guard end > committed.count else { return "" }
+        let delta = String(chars[committed.count..<end])
+        committed = Array(chars[..<end])
+        return delta
+    }
+
+    /// 输入最终结果，返回还需要补上的文字，并为下一句重置
+    ///
+    /// 最终结果与已提交的前缀不一致时，按已提交的字数跳过开头。
+    @discardableResult
+    mutating func finish(_ finalText: String) -> String {
+        let chars = Array(finalText)
+        if Self.commonPrefixLength(committed, chars) < committed.count {
+            print("⚠️ StablePrefixTracker: 最终结果与已提交的文字不一致，已提交: \(committedText)，最终: \(finalText)")
+        }
+        let tail = String(chars.dropFirst(committed.count))
+        reset()
+        return tail
+    }
+
+    /// 丢弃所有状态（开始新的一句）
+    mutating func reset() {
+        committed = []
+        hasDiverged = false
+        recent = []
+        current = []
+        firstSeen = []
+    }
+
+    // MARK: - Helpers
+
+    static func commonPrefixLength(_ a: [Character], _ b: [Character]) -> Int {
+        var i = 0
+        let n = min(a.count, b.count)
+        while i < n && a[i] == b[i] {
+            i += 1
+        }
+        return i
+    }
+
+    private static func isWordCharacter(_ char: Character) -> Bool {
+        char.isASCII && (char.isLetter || char.isNumber)
+    }
+}
@@ -0,0 +1,117 @@
+//
+//  StreamFinalizer.swift
+//  CapsWriter-mac
+//
+//  收尾解码 - 松开按键后立即结束输入、补尾部静音、解完剩余帧，尽快拿到最终结果
+//
+
+import Foundation
+
+/// 收尾解码
+///
+/// 流式模型要攒够一个块（加上右侧上下文）才会解码，停止录音时最后几百毫秒的音频往往还没解码；
+/// 等端点检测又要多等 `rule2MinTrailingSilence`。这里直接：
+/// - 调用 `SherpaOnnxOnlineStreamInputFinished` 告诉识别器不会再有输入
+/// - 按模型补一段尾部静音，把最后一个块凑满
+/// - 在截止时间内把所有就绪的帧解完，取结果后换一个新的音频流
+///
+/// 结束输入的流即使重置也不能再接收音频，所以传入的流会被销毁，调用方改用 `Outcome.stream`。
+/// 必须在处理音频的串行队列上调用，保证排在已收到的音频之后。
+enum StreamFinalizer {
+
+    struct Outcome {
+        let text: String
+        /// 每个字在这句中的时间（秒），模型不提供时间戳时为空
+        let tokenTimes: [Float]
+        /// 解码次数
+        let decodeCount: Int
+        /// 是否因为超过截止时间而提前结束
+        let timedOut: Bool
+        let elapsed: TimeInterval
+        /// 下一句使用的音频流：新创建的流，传入的流已销毁
+        let stream: OpaquePointer
+    }
+
+    /// 按模型类型选择尾部静音的长度（秒）
+    ///
+    /// Paraformer 的块较大且需要右侧上下文，补得多一些；Zipformer/CTC 类模型块小，0.3 秒即可。
+    static func tailPadding(forModelType modelType: String) -> TimeInterval {
+        let type = modelType.lowercased()
+        if type.contains("paraformer") {
+            return 0.66
+        }
+        if type.contains("zipformer") || type.contains("ctc") || type.contains("transducer") || type.contains("lstm") {
+            return 0.3
+        }
+        return 0.66
+    }
+
+    /// 结束输入并解码剩余的帧，返回最终结果（已重置音频流）
+    static func finalize(
+        recognizer: OpaquePointer,
+        stream: OpaquePointer,
+        sampleRate: Int,
+        tailPadding: TimeInterval,
+        timeout: TimeInterval,
+        extractText: (UnsafePointer<SherpaOnnxOnlineRecognizerResult>) -> String
+    ) -> Outcome {
+        let start = ProcessInfo.processInfo.systemUptime
+        let deadline = start + timeout
+
+        // 尾部静音
+        let paddingCount = Int(Double(sampleRate) * tailPadding)
+        if paddingCount > 0 {
+            let padding = [Float](repeating: 0, count: paddingCount)
+            padding.withUnsafeBufferPointer { samples in
+                SherpaOnnxOnlineStreamAcceptWaveform(stream, Int32(sampleRate), samples.baseAddress, Int32(paddingCount))
+            }
+        }
+        SherpaOnnxOnlineStreamInputFinished(stream)
+
+        // 解完所有就绪的帧；单次解码无法中断，超时只在两次解码之间检查
+        var decodeCount = 0
+        var timedOut = false
+        while SherpaOnnxIsOnlineStreamReady(recognizer, stream) == 1 {
+            if ProcessInfo.processInfo.systemUptime >= deadline {
+                timedOut = true
+                break
+            }
+            SherpaOnnxDecodeOnlineStream(recognizer, stream)
+            decodeCount += 1
+        }
+
+        var text = ""
+        var tokenTimes: [Float] = []
+        if let result = SherpaOnnxGetOnlineStreamResult(recognizer, stream) {
+            text = extractText(result)
+            tokenTimes = Self.tokenTimes(of: result)
+            SherpaOnnxDestroyOnlineRecognizerResult(result)
+        }
+
+        // 结束输入的流重置后也不能再接收音频，换一个新的；创建失败时只能退回重置原来的流
+        var nextStream = stream
+        if let newStream = SherpaOnnxCreateOnlineStream(recognizer) {
+            SherpaOnnxDestroyOnlineStream(stream)
+            nextStream = newStream
+        } else {
+            SherpaOnnxOnlineStreamReset(recognizer, stream)
+        }
+
+        return Outcome(
+            text: text.trimmingCharacters(in: .whitespacesAndNewlines),
+            tokenTimes: tokenTimes,
+            decodeCount: decodeCount,
+            timedOut: timedOut,
+            elapsed: ProcessInfo.processInfo.systemUptime - start,
+            stream: nextStream
+        )
+    }
+
+    /// 识别结果中每个字的时间（秒），模型不提供时间戳时为空
+    static func tokenTimes(of result: UnsafePointer<SherpaOnnxOnlineRecognizerResult>) -> [Float] {
+        guard let timestamps = result.pointee.timestamps, result.pointee.count > 0 else {
+            return []
+        }
+        return Array(UnsafeBufferPointer(start: timestamps, count: Int(result.pointee.count)))
+    }
+}
@@ -12,6 +12,12 @@ protocol TextProcessingServiceProtocol: ServiceLifecycleProtocol {
     /// 仅应用热词替换
     func applyHotWordReplacement(_ text: String) -> String
     
+    /// 增量处理一句话不断增长的部分结果（热词替换），只重新处理变化的尾部
+    func processPartialText(_ text: String) -> String
+    
+    /// 重置增量处理状态（开始新的一句）
+    func resetPartialState()
+    
     /// 仅应用标点符号处理
     func applyPunctuationProcessing(_ text: String) -> String
     
@@ -104,6 +110,9 @@ class TextProcessingService: ObservableObject, TextProcessingServiceProtocol {
     private let processingQueue = DispatchQueue(label: "com.capswriter.textprocessing", qos: .userInitiated)
     private var cancellables = Set<AnyCancellable>()
     
+    /// 部分结果的增量处理状态（仅在 processingQueue 上访问）
+    private var partialProcessor: IncrementalTextProcessor?
+    
     /// 处理时间记录（用于计算平均值）
     private var processingTimes: [TimeInterval] = []
     private let maxProcessingTimeRecords = 100
@@ -218,6 +227,29 @@ class TextProcessingService: ObservableObject, TextProcessingServiceProtocol {
         return hotWordService.processText(text)
     }
     
+    func processPartialText(_ text: String) -> String {
+        guard isRunning && configManager.textProcessing.enableHotwordReplacement else {
+            return text
+        }
+        
+        return processingQueue.sync {
+            if partialProcessor == nil {
+                // 每句开始时按当前热词确定窗口，热词重新加载后下一句生效
+                let hotWordService = self.hotWordService
+                partialProcessor = IncrementalTextProcessor(window: hotWordService.maxMatchLength) {
+                    hotWordService.processText($0)
+                }
+            }
+            return partialProcessor!.process(text)
+        }
+    }
+    
+    func resetPartialState() {
+        processingQueue.async { [weak self] in
+            self?.partialProcessor = nil
+        }
+    }
+    
     func applyPunctuationProcessing(_ text: String) -> String {
         guard isRunning && configManager.textProcessing.enablePunctuation else {
             return text
@@ -0,0 +1,270 @@
+//
+//  TextReconciler.swift
+//  CapsWriter-mac
+//
+//  输入修正 - 已输入的文字与最终结果不同时，用最少的按键改成最终结果
+//
+
+import Foundation
+
+// MARK: - 编辑按键
+
+/// 修正时发送的按键
+enum TextEditKey: Equatable {
+    /// 输入文字
+    case type(String)
+    /// 退格若干次
+    case backspace(Int)
+    /// 光标左移若干字
+    case moveLeft(Int)
+    /// 光标右移若干字
+    case moveRight(Int)
+    /// Shift+← 向左选中若干字
+    case selectLeft(Int)
+}
+
+// MARK: - 输入修正
+
+/// 输入修正
+///
+/// 光标在已输入文字的末尾。按字素（Character）做 Myers 差分得到最少的增删，
+/// 再与「退格重打不同的尾部」「选中变化的区间整体替换」两种方案按按键代价比较，取最便宜的。
+/// 差异太大（编辑距离超过 `maxEditDistance`）时不做差分，只在后两种方案中选择。
+struct TextReconciler {
+
+    // MARK: - Cost Model
+
+    /// 各种按键的代价
+    struct CostModel {
+        /// 输入一个字
+        var typeCost: Double = 1.0
+        /// 退格一次
+        var backspaceCost: Double = 1.0
+        /// 方向键移动一次
+        var arrowCost: Double = 0.3
+        /// Shift+方向键选中一次
+        var selectCost: Double = 0.3
+        /// 每处修改的固定开销（光标跳到别处、输入法状态重置等）
+        var editCost: Double = 2.0
+    }
+
+    /// 修正方案
+    enum Strategy: String {
+        case none = "无需修正"
+        case retypeSuffix = "退格重打"
+        case minimalEdit = "最少增删"
+        case selectAndReplace = "选中替换"
+    }
+
+    struct Plan {
+        let strategy: Strategy
+        let keys: [TextEditKey]
+        let cost: Double
+    }
+
+    var costModel: CostModel
+    var maxEditDistance: Int
+
+    init(costModel: CostModel = CostModel(), maxEditDistance: Int = 200) {
+        self.costModel = costModel
+        self.maxEditDistance = maxEditDistance
+    }
+
+    // MARK: - Public Methods
+
+    /// 把已输入的 `typed` 改成 `target` 的按键序列
+    func plan(typed: String, target: String) -> Plan {
+        let a = Array(typed)
+        let b = Array(target)
+        guard a != b else {
+            return Plan(strategy: .none, keys: [], cost: 0)
+        }
+
+        var candidates = [retypeSuffixPlan(a, b), selectAndReplacePlan(a, b)]
+        if let hunks = Self.diff(a, b, maxEditDistance: maxEditDistance) {
+            candidates.append(minimalEditPlan(hunks, typedCount: a.count, targetCount: b.count))
+        }
+        // 代价相同时优先排在前面的（按键更简单）
+        return candidates.min { $0.cost < $1.cost }!
+    }
+
+    // MARK: - Plans
+
+    /// 退格到第一个不同的字，再输入剩下的部分
+    private func retypeSuffixPlan(_ a: [Character], _ b: [Character]) -> Plan {
+        let common = Self.commonPrefixLength(a, b)
+        let deleteCount = a.count - common
+        let insert = b[common...]
+
+        var keys: [TextEditKey] = []
+        if deleteCount > 0 { keys.append(.backspace(deleteCount)) }
+        if !insert.isEmpty { keys.append(.type(String(insert))) }
+
+        let cost = Double(deleteCount) * costModel.backspaceCost
+            + Double(insert.count) * costModel.typeCost
+            + costModel.editCost
+        return Plan(strategy: .retypeSuffix, keys: keys, cost: cost)
+    }
+
+    /// 去掉相同的开头和结尾，选中中间变化的区间，直接输入替换
+    private func selectAndReplacePlan(_ a: [Character], _ b: [Character]) -> Plan {
+        let prefix = Self.commonPrefixLength(a, b)
+        var suffix = 0
+        while suffix < min(a.count, b.count) - prefix && a[a.count - 1 - suffix] == b[b.count - 1 - suffix] {
+            suffix += 1
+        }
+        let selectCount = a.count - prefix - suffix
+        let replacement = b[prefix..<(b.count - suffix)]
+
+        var keys: [TextEditKey] = []
+        var cost = costModel.editCost
+        if suffix > 0 {
+            keys.append(.moveLeft(suffix))
+            cost += Double(suffix) * costModel.arrowCost
+        }
+        if selectCount > 0 {
+            keys.append(.selectLeft(selectCount))
+            cost += Double(selectCount) * costModel.selectCost
+        }
+        if !replacement.isEmpty {
+            keys.append(.type(String(replacement)))
+            cost += Double(replacement.count) * costModel.typeCost
+        } else {
+            keys.append(.backspace(1))
+            cost += costModel.backspaceCost
+        }
+        if suffix > 0 {
+            keys.append(.moveRight(suffix))
+            cost += Double(suffix) * costModel.arrowCost
+        }
+        return Plan(strategy: .selectAndReplace, keys: keys, cost: cost)
+    }
+
+    /// 从右往左逐处修改，最后把光标移回末尾
+    private func minimalEditPlan(_ hunks: [Hunk], typedCount: Int, targetCount: Int) -> Plan {
+        var keys: [TextEditKey] = []
+        var cost = 0.0
+        var cursor = typedCount
+
+        for hunk in hunks.reversed() {
+            let end = hunk.start + hunk.deleteCount
+            if cursor > end {
+                keys.append(.moveLeft(cursor - end))
+                cost += Double(cursor - end) * costModel.arrowCost
+            }
+            if hunk.deleteCount > 0 {
+                keys.append(.backspace(hunk.deleteCount))
+                cost += Double(hunk.deleteCount) * costModel.backspaceCost
+            }
+            if !hunk.insert.isEmpty {
+                keys.append(.type(String(hunk.insert)))
+                cost += Double(hunk.insert.count) * costModel.typeCost
+            }
+            cost += costModel.editCost
+            // 刚输入了替换的文字，光标在它后面
+            cursor = hunk.start + hunk.insert.count
+        }
+
+        // 最左一处之前的文字没有变，光标在最终文本中的位置就是它的起点加上插入的字数
+        if let first = hunks.first {
+            let trailing = targetCount - (first.start + first.insert.count)
+            if trailing > 0 {
+                keys.append(.moveRight(trailing))
+                cost += Double(trailing) * costModel.arrowCost
+            }
+        }
+        return Plan(strategy: .minimalEdit, keys: keys, cost: cost)
+    }
+
+    // MARK: - Myers Diff
+
+    /// 一处修改：删除 `typed[start..<start + deleteCount]`，在该位置插入 `insert`
+    struct Hunk: Equatable {
+        var start: Int
+        var deleteCount: Int
+        var insert: [Character]
+    }
+
+    /// Myers 差分，返回按位置排列的修改；编辑距离超过上限时返回 nil
+    static func diff(_ a: [Character], _ b: [Character], maxEditDistance: Int) -> [Hunk]? {
+        let n = a.count, m = b.count
+        let maxD = min(n + m, maxEditDistance)
+        let offset = maxD + 1
+        var v = [Int](repeating: 0, count: 2 * maxD + 3)
+        var trace: [[Int]] = []
+
+        for d in 0...maxD {
+            trace.append(v)
+            for k in stride(from: -d, through: d, by: 2) {
+                var x: Int
+                if k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]) {
+                    x = v[offset + k + 1]
+                } else {
+                    x = v[offset + k - 1] + 1
+                }
+                var y = x - k
+                while x < n && y < m && a[x] == b[y] {
+                    x += 1
+                    y += 1
+                }
+                v[offset + k] = x
+                if x >= n && y >= m {
+                    return backtrack(a, b, trace: trace, editDistance: d, offset: offset)
+                }
+            }
+        }
+        return nil
+    }
+
+    private static func backtrack(_ a: [Character], _ b: [Character], trace: [[Int]], editDistance: Int, offset: Int) -> [Hunk] {
+        // (是否插入, 在 a 中的位置, 插入的字)
+        var ops: [(insert: Bool, position: Int, char: Character?)] = []
+        var x = a.count, y = b.count
+
+        for d in stride(from: editDistance, to: 0, by: -1) {
+            let v = trace[d]
+            let k = x - y
+            let previousK = (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) ? k + 1 : k - 1
+            let previousX = v[offset + previousK]
+            let previousY = previousX - previousK
+
+            while x > previousX && y > previousY {
+                x -= 1
+                y -= 1
+            }
+            if x == previousX {
+                ops.append((true, previousX, b[previousY]))
+            } else {
+                ops.append((false, previousX, nil))
+            }
+            x = previousX
+            y = previousY
+        }
+
+        // 相邻的增删合成一处
+        var hunks: [Hunk] = []
+        for op in ops.reversed() {
+            if let last = hunks.last, last.start + last.deleteCount == op.position {
+                if op.insert {
+                    hunks[hunks.count - 1].insert.append(op.char!)
+                } else {
+                    hunks[hunks.count - 1].deleteCount += 1
+                }
+            } else {
+                hunks.append(op.insert
+                    ? Hunk(start: op.position, deleteCount: 0, insert: [op.char!])
+                    : Hunk(start: op.position, deleteCount: 1, insert: []))
+            }
+        }
+        return hunks
+    }
+
+    private static func commonPrefixLength(_ a: [Character], _ b: [Character]) -> Int {
+        var i = 0
+        let n = min(a.count, b.count)
+        while i < n && a[i] == b[i] {
+            i += 1
+        }
+        return i
+    }
+}
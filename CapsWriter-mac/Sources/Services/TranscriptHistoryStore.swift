@@ -0,0 +1,306 @@
+//
+//  TranscriptHistoryStore.swift
+//  CapsWriter-mac
+//
+//  转录历史存储 - 磁盘只追加日志 + 固定大小的内存窗口 + 增量变更通知
+//
+
+import Foundation
+import Combine
+
+// MARK: - 变更通知
+
+/// 转录历史的增量变更
+/// 订阅者按变更更新自己持有的数据，不需要每次重新比较整个数组
+enum TranscriptHistoryChange: Equatable {
+    /// 窗口末尾新增一条
+    case appended(TranscriptEntry)
+    /// 末尾的部分结果被替换（同一句话更新的部分结果，或它的最终结果）
+    case replacedLast(TranscriptEntry)
+    /// 窗口超出容量，从头部移出若干条
+    case trimmedFront(Int)
+    /// 向前翻页，在窗口头部插入较早的记录
+    case prepended([TranscriptEntry])
+    /// 整个窗口被替换（启动时载入、清空）
+    case reset([TranscriptEntry])
+}
+
+// MARK: - 转录历史存储
+
+/// 转录历史存储
+///
+/// - 最终结果追加写入磁盘日志（每行一条 JSON），部分结果只在内存中替换，不落盘
+/// - 内存中只保留最近 `windowCapacity` 条供界面显示，长时间听写内存不再增长
+/// - 较早的记录通过 `loadOlder(pageSize:)` 按页从日志读取
+/// - 每次变更通过 `changes` 发出增量通知
+///
+/// `window` 只在主线程读写，磁盘读写都在 `ioQueue` 上进行。
+final class TranscriptHistoryStore {
+
+    // MARK: - Singleton
+
+    static let shared = TranscriptHistoryStore()
+
+    // MARK: - Public Properties
+
+    /// 增量变更通知（主线程发出）
+    let changes = PassthroughSubject<TranscriptHistoryChange, Never>()
+
+    /// 内存窗口：最近的若干条记录，最后一条可能是部分结果
+    private(set) var window: [TranscriptEntry] = []
+
+    /// 内存窗口容量
+    let windowCapacity: Int
+
+    /// 日志中是否还有比窗口更早的记录
+    var hasOlder: Bool { windowStart > 0 }
+
+    // MARK: - Private Properties
+
+    private let logURL: URL
+    private let maxLogRecords: Int
+    private let ioQueue = DispatchQueue(label: "com.capswriter.transcript-history", qos: .utility)
+
+    /// 每条日志记录在文件中的字节偏移（仅在 ioQueue 上访问）
+    private var offsets: [UInt64] = []
+    private var fileHandle: FileHandle?
+
+    /// 窗口中第一条已落盘记录在日志中的序号（仅在主线程访问）
+    private var windowStart = 0
+    private var isLoadingOlder = false
+
+    private let encoder = JSONEncoder()
+    private let decoder = JSONDecoder()
+
+    // MARK: - Initialization
+
+    init(logURL: URL = TranscriptHistoryStore.defaultLogURL(), windowCapacity: Int = 100, maxLogRecords: Int = 50_000) {
+        self.logURL = logURL
+        self.windowCapacity = windowCapacity
+        self.maxLogRecords = maxLogRecords
+        encoder.dateEncodingStrategy = .secondsSince1970
+        decoder.dateDecodingStrategy = .secondsSince1970
+
+        ioQueue.async { [weak self] in
+            self?.openLog()
+        }
+    }
+
+    deinit {
+        try? fileHandle?.close()
+    }
+
+    /// 默认日志位置：~/Library/Application Support/CapsWriter-mac/Transcripts/history.jsonl
+    static func defaultLogURL() -> URL {
+        let appSupport = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask).first!
+        return appSupport.appendingPathComponent("CapsWriter-mac/Transcripts/history.jsonl")
+    }
+
+    // MARK: - Public Methods
+
+    /// 添加一条记录，可在任意线程调用
+    func append(_ entry: TranscriptEntry) {
+        guard !entry.text.isEmpty else { return }
+
+        if !entry.isPartial {
+            ioQueue.async { [weak self] in
+                self?.writeRecord(entry)
+            }
+        }
+
+        performOnMain { [weak self] in
+            self?.applyAppend(entry)
+        }
+    }
+
+    /// 从日志中载入窗口之前的一页记录，载入后通过 `.prepended` 通知
+    func loadOlder(pageSize: Int = 50, completion: ((Int) -> Void)? = nil) {
+        performOnMain { [weak self] in
+            guard let self = self, self.hasOlder, !self.isLoadingOlder else {
+                completion?(0)
+                return
+            }
+            self.isLoadingOlder = true
+            let end = self.windowStart
+            let start = max(0, end - pageSize)
+
+            self.ioQueue.async {
+                let entries = self.readRecords(start..<end)
+                DispatchQueue.main.async {
+                    self.isLoadingOlder = false
+                    // 载入期间被清空的话丢弃结果
+                    guard self.windowStart == end else {
+                        completion?(0)
+                        return
+                    }
+                    self.windowStart = start
+                    self.window.insert(contentsOf: entries, at: 0)
+                    self.changes.send(.prepended(entries))
+                    completion?(entries.count)
+                }
+            }
+        }
+    }
+
+    /// 替换内存窗口，不影响磁盘日志
+    func replaceWindow(_ entries: [TranscriptEntry]) {
+        performOnMain { [weak self] in
+            guard let self = self else { return }
+            self.window = Array(entries.suffix(self.windowCapacity))
+            self.changes.send(.reset(self.window))
+        }
+    }
+
+    /// 清空历史：内存窗口和磁盘日志
+    func clear() {
+        ioQueue.async { [weak self] in
+            guard let self = self else { return }
+            try? self.fileHandle?.truncate(atOffset: 0)
+            self.offsets.removeAll()
+        }
+        performOnMain { [weak self] in
+            guard let self = self else { return }
+            self.window.removeAll()
+            self.windowStart = 0
+            self.changes.send(.reset([]))
+        }
+    }
+
+    /// 等待已提交的磁盘写入完成（退出前调用）
+    func flush() {
+        ioQueue.sync {
+            try? fileHandle?.synchronize()
+        }
+    }
+
+    // MARK: - Window Management (Main Thread)
+
+    private func applyAppend(_ entry: TranscriptEntry) {
+        // 末尾是部分结果时，新的部分结果或最终结果替换它
+        if let last = window.last, last.isPartial {
+            window[window.count - 1] = entry
+            changes.send(.replacedLast(entry))
+        } else {
+            window.append(entry)
+            changes.send(.appended(entry))
+        }
+
+        let overflow = window.count - windowCapacity
+        if overflow > 0 {
+            window.removeFirst(overflow)
+            windowStart += overflow
+            changes.send(.trimmedFront(overflow))
+        }
+    }
+
+    private func performOnMain(_ block: @escaping () -> Void) {
+        if Thread.isMainThread {
+            block()
+        } else {
+            DispatchQueue.main.async(execute: block)
+        }
+    }
+
+    // MARK: - Log I/O (ioQueue)
+
+    private func openLog() {
+        let directory = logURL.deletingLastPathComponent()
+        try? FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+        if !FileManager.default.fileExists(atPath: logURL.path) {
+            FileManager.default.createFile(atPath: logURL.path, contents: nil)
+        }
+
+        // 扫描一遍建立偏移表，末尾写到一半的记录截掉
+        let data = (try? Data(contentsOf: logURL, options: .mappedIfSafe)) ?? Data()
+        var lineStart = 0
+        var validEnd = 0
+        for (index, byte) in data.enumerated() where byte == UInt8(ascii: "\n") {
+            offsets.append(UInt64(lineStart))
+            lineStart = index + 1
+            validEnd = lineStart
+        }
+
+        fileHandle = try? FileHandle(forUpdating: logURL)
+        if validEnd < data.count {
+            try? fileHandle?.truncate(atOffset: UInt64(validEnd))
+        }
+        _ = try? fileHandle?.seekToEnd()
+
+        if offsets.count > maxLogRecords {
+            compactLog()
+        }
+
+        // 载入最后一个窗口
+        let start = max(0, offsets.count - windowCapacity)
+        let entries = readRecords(start..<offsets.count)
+        DispatchQueue.main.async { [weak self] in
+            guard let self = self else { return }
+            // 载入前已经产生的新记录接在后面
+            let pending = self.window
+            self.windowStart = start + max(0, entries.count + pending.count - self.windowCapacity)
+            self.window = Array((entries + pending).suffix(self.windowCapacity))
+            self.changes.send(.reset(self.window))
+        }
+    }
+
+    private func writeRecord(_ entry: TranscriptEntry) {
+        guard let handle = fileHandle, var line = try? encoder.encode(entry) else { return }
+        line.append(UInt8(ascii: "\n"))
+        do {
+            let offset = try handle.seekToEnd()
+            try handle.write(contentsOf: line)
+            offsets.append(offset)
+        } catch {
+            print("⚠️ TranscriptHistoryStore: 写入转录日志失败: \(error)")
+        }
+    }
+
+    private func readRecords(_ range: Range<Int>) -> [TranscriptEntry] {
+        guard let handle = fileHandle, !range.isEmpty, range.upperBound <= offsets.count else { return [] }
+        let start = offsets[range.lowerBound]
+        let end = range.upperBound < offsets.count ? offsets[range.upperBound] : (try? handle.seekToEnd()) ?? start
+
+        var entries: [TranscriptEntry] = []
+        do {
+            try handle.seek(toOffset: start)
+            let data = try handle.read(upToCount: Int(end - start)) ?? Data()
+            for line in data.split(separator: UInt8(ascii: "\n")) {
+                if let entry = try? decoder.decode(TranscriptEntry.self, from: line) {
+                    entries.append(entry)
+                }
+            }
+        } catch {
+            print("⚠️ TranscriptHistoryStore: 读取转录日志失败: \(error)")
+        }
+        _ = try? handle.seekToEnd()
+        return entries
+    }
+
+    /// 日志超过上限时只保留后一半
+    private func compactLog() {
+        let keep = maxLogRecords / 2
+        let entries = readRecords((offsets.count - keep)..<offsets.count)
+        let tempURL = logURL.appendingPathExtension("tmp")
+
+        var data = Data()
+        var newOffsets: [UInt64] = []
+        for entry in entries {
+            guard let line = try? encoder.encode(entry) else { continue }
+            newOffsets.append(UInt64(data.count))
+            data.append(line)
+            data.append(UInt8(ascii: "\n"))
+        }
+
+        do {
+            try data.write(to: tempURL, options: .atomic)
+            try? fileHandle?.close()
+            _ = try FileManager.default.replaceItemAt(logURL, withItemAt: tempURL)
+            fileHandle = try FileHandle(forUpdating: logURL)
+            _ = try fileHandle?.seekToEnd()
+            offsets = newOffsets
+        } catch {
+            print("⚠️ TranscriptHistoryStore: 压缩转录日志失败: \(error)")
+            fileHandle = fileHandle ?? (try? FileHandle(forUpdating: logURL))
+        }
+    }
+}
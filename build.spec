@@ -5,7 +5,7 @@ from pprint import pprint
 
 
 from os.path import join, basename, dirname, exists
-from os import walk, makedirs, sep
+from os import walk, makedirs, sep, listdir
 from shutil import copyfile, rmtree
 
 # 初始化空列表
@@ -149,6 +149,13 @@ for folder in my_folders:
     for dirpath, dirnames, filenames in walk(folder):
         for filename in filenames:
             my_files.append(join(dirpath, filename))
+
+# 编译好的 capswriter_native 扩展模块（可选）
+if exists('native'):
+    for filename in listdir('native'):
+        if filename.startswith('capswriter_native') and filename.endswith(('.pyd', '.so')):
+            my_files.append(join('native', filename))
+
 for file in my_files:
     if not exists(file):
         continue
@@ -11,6 +11,49 @@ class ServerConfig:
     format_punc = True  # 输出时是否启用标点符号引擎
     format_spell = True  # 输出时是否调整中英之间的空格
 
+    pause_seg_min = 3    # 客户端标记停顿时，缓冲区音频超过多少秒就在停顿处切分识别
+
+    journal = True              # 是否把文件转录任务写入日志，服务端崩溃重启后继续识别
+    journal_path = 'journal/tasks.log'  # 任务日志的位置
+    journal_size = 64           # 任务日志的初始大小：64MB，不够时自动扩大
+    journal_interval = 5        # 每隔 5 秒把日志刷到磁盘，并视情况压缩
+    journal_expire = 24         # 结果一直没人取走的任务，保留 24 小时
+
+    diarize = False             # 是否载入说话人分离模型，为文件转录标注说话人（模型见 DiarizationArgs）
+    diarize_timeout = 300       # 识别完成后最多等说话人分离 300 秒，超时就不标注说话人，直接发出结果
+
+    lid = False                 # 是否识别语种，按语种选用 LanguageArgs 中的模型
+    lid_seconds = 5             # 只用每个任务开头 5 秒的音频识别语种
+
+    denoise = False             # 是否在识别前降噪（模型见 DenoiseArgs）
+    denoise_sources = ('file',) # 对哪些任务降噪，加上 'mic' 则听写也降噪
+    denoise_snr = 20            # 估计的信噪比高于 20dB 就不必降噪
+
+    tagging = False             # 是否用音频事件模型预筛，跳过音乐、等待音等没有人声的区间（模型见 TaggingArgs）
+    tagging_sources = ('file',) # 对哪些任务预筛
+    tagging_window = 5          # 以 5 秒为一个窗口判断有无人声
+    tagging_padding = 0.5       # 人声区间两端多保留 0.5 秒
+    tagging_threshold = 0.2     # 人声类标签的概率低于它就跳过该窗口
+
+    tier = False                # 是否两级解码：先快速识别，置信度低的片段再用 TierArgs 中更慢更准的模型重新识别
+    tier_sources = ('file',)    # 对哪些任务两级解码
+    tier_threshold = 0.6        # 片段置信度低于它就重新识别
+    tier_budget = 0.2           # 每个任务最多重新识别多少比例的音频
+
+    task_expire = 600           # 识别进程按任务保存的语种、两级解码预算，10 分钟没有新片段就丢弃
+
+
+# 路由配置，一个路由进程把客户端分发到多台服务端
+class RouterConfig:
+    addr = '0.0.0.0'
+    port = '6015'
+
+    nodes_file = 'router-nodes.txt'  # 服务端节点列表，修改后自动生效
+    replicas = 100                  # 一致性哈希环上每个节点的虚拟节点数
+    health_interval = 3             # 健康检查间隔：3秒
+    health_timeout = 2              # 健康检查超时：2秒
+    replay_limit = 64               # 每个任务最多缓存多少 MB 的消息，节点掉线时转发给新节点重新识别
+
 
 # 客户端配置
 class ClientConfig:
@@ -40,12 +83,34 @@ class ClientConfig:
     hot_en   = True             # 是否启用英文热词替换，英文热词存储在 hot_en.txt 文件里
     hot_rule = True             # 是否启用自定义规则替换，自定义规则存储在 hot_rule.txt 文件里
     hot_kwd  = True             # 是否启用关键词日记功能，自定义关键词存储在 keyword.txt 文件里
+    diary_flush = 2             # 日记在后台写入，每隔多少秒刷新到磁盘
+    diary_open_files = 8        # 后台写日记时最多同时打开多少个 md 文件
 
     mic_seg_duration = 15           # 麦克风听写时分段长度：15秒
     mic_seg_overlap = 2             # 麦克风听写时分段重叠：2秒
+    mic_chunk_duration = 0.2        # 麦克风录音每批取出的长度，与声卡回调的块大小无关
+    mic_ring_duration = 10          # 录音环形缓冲区的容量：10秒
+
+    vad = True                      # 是否在客户端检测语音活动，丢弃多余的静音后再上传
+    vad_padding = 0.3               # 语音前后保留的静音长度：0.3秒，更长的停顿会被丢弃
+    vad_model = 'models/silero_vad.onnx'    # VAD 模型，不存在时改用能量检测
+    vad_energy_margin = 12          # 能量检测：高于底噪多少 dB 算作语音
+    vad_energy_floor = -50          # 能量检测：低于多少 dBFS 一律算作静音
+
+    hands_free = False              # 免提模式：麦克风常开，检测到说话自动识别，停顿后自动上屏，快捷键用于暂停和恢复
+    hands_free_preroll = 0.3        # 免提模式：语音开始前补上多长的音频
+    hands_free_silence = 0.8        # 免提模式：静音多久算一段话结束
+    hands_free_min_speech = 0.3     # 免提模式：短于这个长度的声音（咳嗽、敲键盘）不识别
+    hands_free_max_segment = 60     # 免提模式：一段话最长 60 秒，超过就切开
 
     file_seg_duration = 25           # 转录文件时分段长度
     file_seg_overlap = 2             # 转录文件时分段重叠
+    file_diarize = False             # 转录文件时是否标注说话人，需要服务端开启 diarize
+
+    search_index = True             # 是否为识别结果建全文索引，用 python -m util.client_search_index search 搜索
+    index_dir = 'index'             # 索引存放的文件夹
+    index_batch = 20                # 攒够多少条结果写一次倒排表分段
+    index_segments = 8              # 分段超过多少个就合并成一个
 
 
 class ModelPaths:
@@ -65,3 +130,72 @@ class ParaformerArgs:
     debug = False
 
 
+class LanguageArgs:
+    # 语种识别用 whisper 模型的编码器、解码器
+    encoder = f"{Path() / 'models' / 'sherpa-onnx-whisper-tiny' / 'tiny-encoder.int8.onnx'}"
+    decoder = f"{Path() / 'models' / 'sherpa-onnx-whisper-tiny' / 'tiny-decoder.int8.onnx'}"
+    num_threads = 1
+
+    # 语种 -> (sherpa_onnx.OfflineRecognizer 的工厂函数, 参数)
+    # 其余语种，或模型文件不存在时，使用默认的 ParaformerArgs
+    models = {
+        'en': ('from_transducer', {
+            'encoder': f"{Path() / 'models' / 'zipformer-en' / 'encoder.int8.onnx'}",
+            'decoder': f"{Path() / 'models' / 'zipformer-en' / 'decoder.int8.onnx'}",
+            'joiner': f"{Path() / 'models' / 'zipformer-en' / 'joiner.int8.onnx'}",
+            'tokens': f"{Path() / 'models' / 'zipformer-en' / 'tokens.txt'}",
+            'num_threads': 6,
+        }),
+        'yue': ('from_paraformer', {
+            'paraformer': f"{Path() / 'models' / 'paraformer-trilingual' / 'model.int8.onnx'}",
+            'tokens': f"{Path() / 'models' / 'paraformer-trilingual' / 'tokens.txt'}",
+            'num_threads': 6,
+        }),
+    }
+
+
+class TaggingArgs:
+    model = f"{Path() / 'models' / 'sherpa-onnx-zipformer-audio-tagging' / 'model.int8.onnx'}"
+    labels = f"{Path() / 'models' / 'sherpa-onnx-zipformer-audio-tagging' / 'class_labels_indices.csv'}"
+    top_k = 10
+    num_threads = 2
+
+
+class DenoiseArgs:
+    model = f"{Path() / 'models' / 'gtcrn_simple.onnx'}"
+    num_threads = 1             # 每次降噪用的线程数
+    threads = 2                 # 降噪线程池大小，与识别并行
+
+
+class DiarizationArgs:
+    segmentation = f"{Path() / 'models' / 'sherpa-onnx-pyannote-segmentation-3-0' / 'model.onnx'}"
+    embedding = f"{Path() / 'models' / '3dspeaker_speech_eres2net_base_sv_zh-cn_3dspeaker_16k.onnx'}"
+    num_clusters = -1           # 说话人数量，-1 表示按阈值自动判断
+    threshold = 0.5             # 聚类阈值，越小分出的说话人越多
+    min_duration_on = 0.3
+    min_duration_off = 0.5
+    num_threads = 2
+    speaker_index = 'speakers.npz'  # 已知说话人的声纹库，用 python -m util.server_speaker_index 登记
+    speaker_threshold = 0.5     # 声纹相似度超过它才认作已知说话人
+    speaker_seconds = 30        # 每个说话人最多取多少秒音频提取声纹
+
+
+class TierArgs:
+    # 两级解码的慢速路径：默认用未量化的 Paraformer，比 int8 慢，但更准
+    factory = 'from_paraformer'
+    kwargs = {
+        'paraformer': f"{Path() / 'models' / 'paraformer-offline-zh' / 'model.onnx'}",
+        'tokens': f"{ModelPaths.tokens_path}",
+        'num_threads': 6,
+    }
+    # 也可以换成 Transducer 加 beam search 和语言模型重打分，例如：
+    # factory = 'from_transducer'
+    # kwargs = {'encoder': ..., 'decoder': ..., 'joiner': ..., 'tokens': ..., 'num_threads': 6,
+    #           'decoding_method': 'modified_beam_search', 'max_active_paths': 8,
+    #           'lm': 'models/lm.onnx', 'lm_scale': 0.3}
+
+    # 置信度：模型不输出 token 概率时，依据语速、重复、未知字估计
+    rate_min = 1.5              # 正常语速下限（字/秒）
+    rate_max = 9.0              # 正常语速上限（字/秒）
+    repeat_min = 3              # 同一个词连续重复几次算作异常
+    window = 5                  # 按约 5 秒的窗口打分和重新识别，尽量在停顿处切开
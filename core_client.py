@@ -16,8 +16,9 @@ import keyboard
 
 from config import ClientConfig as Config
 from util.client_cosmic import console, Cosmic
-from util.client_stream import stream_open, stream_close
-from util.client_shortcut_handler import bond_shortcut
+from util.client_stream import stream_open, stream_close, stream_drain
+from util.client_shortcut_handler import bond_shortcut, hands_free_start
+from util.client_hands_free import hands_free_loop
 from util.client_recv_result import recv_result
 from util.client_show_tips import show_mic_tips, show_file_tips
 from util.client_hot_update import update_hot_all, observe_hot
@@ -58,12 +59,20 @@ async def main_mic():
     # 打开音频流
     Cosmic.stream = stream_open()
 
+    # 定时从环形缓冲区批量取出录音数据
+    drain = asyncio.create_task(stream_drain())
+
     # Ctrl-C 关闭音频流，触发自动重启
     signal.signal(signal.SIGINT, stream_close)
 
     # 绑定按键
     bond_shortcut()
 
+    # 免提模式：一直监听，按语音段自动识别
+    if Config.hands_free:
+        asyncio.create_task(hands_free_loop())
+        hands_free_start()
+
     # 清空物理内存工作集
     if system() == 'Windows':
         empty_current_working_set()
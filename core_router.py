@@ -0,0 +1,50 @@
+import os
+import sys
+import asyncio
+
+import websockets
+from config import RouterConfig as Config
+from util.router_cosmic import console
+from util.router_nodes import load_nodes, health_check
+from util.router_ws import ws_router
+
+BASE_DIR = os.path.dirname(__file__); os.chdir(BASE_DIR)    # 确保 os.getcwd() 位置正确，用相对路径读取节点列表
+
+async def main():
+
+    console.line(2)
+    console.rule('[bold #d55252]CapsWriter Offline Router'); console.line()
+    console.print(f'当前基文件夹：[cyan underline]{BASE_DIR}', end='\n\n')
+    console.print(f'绑定的服务地址：[cyan underline]{Config.addr}:{Config.port}', end='\n\n')
+
+    # 载入节点列表，之后由健康检查定时重新载入
+    load_nodes()
+    console.line()
+
+    # 负责转发客户端消息的 coroutine
+    recv = websockets.serve(ws_router,
+                            Config.addr,
+                            Config.port,
+                            subprotocols=["binary"],
+                            max_size=None)
+
+    # 负责健康检查的 coroutine
+    check = health_check()
+    await asyncio.gather(recv, check)
+
+
+def init():
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:           # Ctrl-C 停止
+        console.print('\n再见！')
+    except OSError as e:                # 端口占用
+        console.print(f'出错了：{e}', style='bright_red'); console.input('...')
+    except Exception as e:
+        print(e)
+    finally:
+        sys.exit(0)
+
+
+if __name__ == "__main__":
+    init()
@@ -1,20 +1,104 @@
 import os
 import sys
 import asyncio
-from multiprocessing import Process, Manager
+from queue import Empty
+from multiprocessing import Process, Manager, Queue
 from platform import system
 
 import websockets
 from config import ServerConfig as Config
 from util.server_cosmic import Cosmic, console
 from util.server_check_model import check_model
-from util.server_ws_recv import ws_recv
-from util.server_ws_send import ws_send
+from util.server_ws_recv import ws_recv, health_check
+from util.server_ws_send import ws_send, expire_diarizations
 from util.server_init_recognizer import init_recognizer
+from util.server_init_diarizer import init_diarizer
+from util.server_journal import open_journal
 from util.empty_working_set import empty_current_working_set
 
 BASE_DIR = os.path.dirname(__file__); os.chdir(BASE_DIR)    # 确保 os.getcwd() 位置正确，用相对路径加载模型
 
+def start_recognizer() -> Process:
+    # 负责识别的子进程
+    recognize_process = Process(target=init_recognizer,
+                                args=(Cosmic.queue_in,
+                                      Cosmic.queue_out,
+                                      Cosmic.sockets_id),
+                                daemon=True)
+    recognize_process.start()
+    return recognize_process
+
+
+def replay_journal():
+    # 把日志中还没有结果的片段重新入队
+    tasks = Cosmic.journal.pending_tasks() if Cosmic.journal else []
+    for task in tasks:
+        Cosmic.queue_in.put(task)
+    if tasks:
+        console.print(f'从任务日志恢复 {len({t.task_id for t in tasks})} 个任务，'
+                      f'{len(tasks)} 个片段', end='\n\n')
+
+
+async def watch_recognizer(recognize_process: Process):
+    # 识别进程崩溃时重启，未完成的文件任务从日志恢复
+    while True:
+        await asyncio.sleep(1)
+        if recognize_process.is_alive() or recognize_process.exitcode == 0:
+            continue
+        console.print(f'识别进程意外退出（{recognize_process.exitcode}），正在重启', style='bright_red')
+
+        # 队列里残留的日志片段会随日志重新入队，先取出，避免重复识别
+        # 其他任务（麦克风任务、未开启日志时的文件任务）无法重发，放回队列
+        leftover = []
+        while True:
+            try:
+                task = Cosmic.queue_in.get_nowait()
+            except Empty:
+                break
+            if not task.journaled:
+                leftover.append(task)
+
+        recognize_process = start_recognizer()
+        for task in leftover:
+            Cosmic.queue_in.put(task)
+        replay_journal()
+
+
+def start_diarizer() -> Process:
+    # 负责说话人分离的子进程，与识别进程并行处理文件任务
+    diarize_process = Process(target=init_diarizer,
+                              args=(Cosmic.queue_diarize, Cosmic.queue_out),
+                              daemon=True)
+    diarize_process.start()
+    return diarize_process
+
+
+async def watch_diarizer(diarize_process: Process):
+    # 丢弃过期的等待；说话人分离进程崩溃时重启，正在等它的任务不再标注说话人
+    while True:
+        await asyncio.sleep(1)
+        if diarize_process.is_alive() or diarize_process.exitcode == 0:
+            await expire_diarizations()
+            continue
+        console.print(f'说话人分离进程意外退出（{diarize_process.exitcode}），正在重启', style='bright_red')
+
+        # 残留的音频属于已放弃的任务
+        while True:
+            try:
+                Cosmic.queue_diarize.get_nowait()
+            except Empty:
+                break
+        await expire_diarizations(abandon=True)
+        diarize_process = start_diarizer()
+
+
+async def maintain_journal():
+    # 定时刷盘、压缩日志
+    while Cosmic.journal:
+        await asyncio.sleep(Config.journal_interval)
+        await Cosmic.journal.maintain()
+
+
 async def main():
 
     # 检查模型文件
@@ -29,17 +113,24 @@ async def main():
     # 跨进程列表，用于保存 socket 的 id，用于让识别进程查看连接是否中断
     Cosmic.sockets_id = Manager().list()
 
+    # 打开任务日志
+    Cosmic.journal = open_journal()
+
     # 负责识别的子进程
-    recognize_process = Process(target=init_recognizer,
-                                args=(Cosmic.queue_in,
-                                      Cosmic.queue_out,
-                                      Cosmic.sockets_id),
-                                daemon=True)
-    recognize_process.start()
+    recognize_process = start_recognizer()
     Cosmic.queue_out.get()
     console.rule('[green3]开始服务')
     console.line()
 
+    # 继续上次崩溃时未完成的任务
+    replay_journal()
+
+    # 负责说话人分离的子进程，与识别进程并行处理文件任务
+    diarize_process = None
+    if Config.diarize:
+        Cosmic.queue_diarize = Queue()
+        diarize_process = start_diarizer()
+
     # 清空物理内存工作集
     if system() == 'Windows':
         empty_current_working_set()
@@ -49,14 +140,25 @@ async def main():
                             Config.addr,
                             Config.port,
                             subprotocols=["binary"],
-                            max_size=None)
+                            max_size=None,
+                            process_request=health_check)
 
     # 负责发送结果的 coroutine
     send = ws_send()
-    await asyncio.gather(recv, send)
+
+    # 负责看护识别进程、维护日志的 coroutine
+    watch = watch_recognizer(recognize_process)
+    maintain = maintain_journal()
+    coroutines = [recv, send, watch, maintain]
+    if diarize_process:
+        coroutines.append(watch_diarizer(diarize_process))
+    await asyncio.gather(*coroutines)
 
 
 def init():
+    # 命令行可以指定端口，方便在一台机器上启动多个节点：python core_server.py 6017
+    if sys.argv[1:]:
+        Config.port = sys.argv[1]
     try:
         asyncio.run(main())
     except KeyboardInterrupt:           # Ctrl-C 停止
@@ -67,6 +169,8 @@ def init():
         print(e)
     finally:
         Cosmic.queue_out.put(None)
+        if Cosmic.journal:
+            Cosmic.journal.close()
         sys.exit(0)
         # os._exit(0)
      
@@ -0,0 +1,235 @@
+/*
+ * capswriter_engine.h
+ *
+ * CapsWriter 识别引擎的 C 接口，Swift 客户端和 Python 服务端共用
+ *
+ * 引擎把一路音频从声卡回调一直处理到上屏文字：
+ *     环形缓冲 → 混音重采样 → 静音切分（可选）→ 识别器 → 结果 → 文本管线
+ * 识别器由后端提供：可以直接用 sherpa-onnx 的在线识别器（c-api.h），
+ * 也可以用一组回调接入其他实现（例如 Python 的 sherpa_onnx）。
+ *
+ * 线程约定：
+ *     cw_session_write 可以在音频回调中调用（单生产者，不加锁、不分配内存）
+ *     会话的其他函数只能在同一个处理线程上调用（单消费者）
+ *     文本管线不是线程安全的，多个会话共用时由调用方保证串行
+ *
+ * 字符串一律为 UTF-8。
+ */
+
+#ifndef CAPSWRITER_ENGINE_H
+#define CAPSWRITER_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(CAPSWRITER_ENGINE_BUILD)
+#define CW_API __declspec(dllexport)
+#else
+#define CW_API __declspec(dllimport)
+#endif
+#else
+#define CW_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct SherpaOnnxOnlineRecognizer;
+
+/* ==================== 识别后端 ==================== */
+
+/// 一组回调形式的识别后端，语义与 c-api.h 中同名的在线识别函数一致
+/// stream 是后端自己的音频流句柄，user 原样传回
+typedef struct cw_backend {
+    void *user;
+    void *(*create_stream)(void *user);
+    void (*destroy_stream)(void *user, void *stream);
+    void (*accept_waveform)(void *user, void *stream, int32_t sample_rate, const float *samples, int32_t n);
+    void (*input_finished)(void *user, void *stream);
+    int32_t (*is_ready)(void *user, void *stream);
+    void (*decode)(void *user, void *stream);
+    int32_t (*is_endpoint)(void *user, void *stream);
+    void (*reset)(void *user, void *stream);
+    /// 返回识别文字；timestamps 为每个 token 的时间（秒），没有时置为 NULL
+    /// 返回的指针有效到下一次调用该流的任意回调
+    const char *(*get_result)(void *user, void *stream, const float **timestamps, int32_t *count);
+    /// 引擎销毁时调用，可以为 NULL
+    void (*destroy)(void *user);
+    /// 一次解码多个音频流（对应 SherpaOnnxDecodeMultipleOnlineStreams），可以为 NULL，此时逐个调用 decode
+    void (*decode_multiple)(void *user, void *const *streams, int32_t n);
+} cw_backend;
+
+/* ==================== 引擎 ==================== */
+
+typedef struct cw_engine cw_engine;
+
+/// 用回调后端创建引擎，backend 会被复制
+CW_API cw_engine *cw_engine_create(const cw_backend *backend);
+
+/// 用 sherpa-onnx 在线识别器创建引擎，不接管识别器，调用方在引擎销毁后再销毁识别器
+/// 编译时没有启用 sherpa-onnx（CAPSWRITER_WITH_SHERPA）时返回 NULL
+CW_API cw_engine *cw_engine_create_sherpa(const struct SherpaOnnxOnlineRecognizer *recognizer);
+
+/// 所有会话销毁之后才能销毁引擎
+CW_API void cw_engine_destroy(cw_engine *engine);
+
+/// 收尾时要补的静音长度（秒）：Paraformer 需要更长的右侧上下文
+CW_API float cw_tail_padding(const char *model_type);
+
+/* ==================== 文本管线 ==================== */
+
+typedef struct cw_text_pipeline cw_text_pipeline;
+
+/// 文本管线各步骤的开关，与服务端 format_text、客户端 hot_sub 的顺序一致：
+///     调空格 → 中文数字转阿拉伯数字 → 调空格 → 英文热词 → 字面替换规则
+typedef struct cw_text_options {
+    int32_t spacing;    /* 调整中英之间的空格 */
+    int32_t itn;        /* 中文数字转阿拉伯数字 */
+    int32_t hotwords;   /* 英文热词、字面替换规则 */
+} cw_text_options;
+
+CW_API cw_text_options cw_text_options_default(void);
+
+CW_API cw_text_pipeline *cw_text_pipeline_create(const cw_text_options *options);
+CW_API void cw_text_pipeline_destroy(cw_text_pipeline *pipeline);
+
+/// 英文热词：忽略大小写和词内空格匹配，两侧不能紧接英文字母，替换为热词原文
+CW_API void cw_text_pipeline_add_hotword(cw_text_pipeline *pipeline, const char *hotword);
+
+/// 字面替换规则：把 from 替换为 to（最左最长匹配，不重叠）
+CW_API void cw_text_pipeline_add_rule(cw_text_pipeline *pipeline, const char *from, const char *to);
+
+/// 清空热词和规则
+CW_API void cw_text_pipeline_clear(cw_text_pipeline *pipeline);
+
+/// 处理一段文本，返回的字符串用 cw_string_free 释放
+CW_API char *cw_text_pipeline_process(cw_text_pipeline *pipeline, const char *text);
+
+CW_API void cw_string_free(char *s);
+
+/* ==================== 会话 ==================== */
+
+typedef struct cw_session cw_session;
+
+typedef struct cw_session_config {
+    int32_t input_sample_rate;  /* 写入音频的采样率，默认 16000 */
+    int32_t input_channels;     /* 写入音频的声道数（交错），默认 1 */
+    int32_t sample_rate;        /* 送入识别器的采样率，默认 16000 */
+    float ring_seconds;         /* 环形缓冲容量（秒），默认 10 */
+    float tail_padding;         /* 收尾时补的静音（秒），默认 0.66，见 cw_tail_padding */
+    int32_t use_endpoint;       /* 识别器检测到端点时切句，默认 1 */
+
+    /* 静音切分（免提模式）：只把语音段送入识别器，静音结束一段 */
+    int32_t segment;            /* 默认 0 */
+    float vad_energy_margin;    /* 高于底噪多少 dB 算作语音，默认 12 */
+    float vad_energy_floor;     /* 低于多少 dBFS 一律算作静音，默认 -50 */
+    float preroll;              /* 开始说话前保留的音频（秒），默认 0.3 */
+    float min_speech;           /* 连续多长的语音才算开始说话（秒），默认 0.3 */
+    float max_silence;          /* 静音多久结束一段（秒），默认 0.8 */
+    float max_segment;          /* 一段最长多久（秒），默认 60 */
+} cw_session_config;
+
+CW_API cw_session_config cw_session_config_default(void);
+
+/// 一条识别结果，指针有效到下一次 cw_session_poll 或会话销毁
+typedef struct cw_result {
+    int32_t is_final;           /* 0 为中间结果，1 为一句的最终结果 */
+    int32_t index;              /* 句子编号，从 0 开始 */
+    double start;               /* 这句在会话中的起始时间（秒） */
+    const char *text;           /* 最终结果已经过文本管线 */
+    const float *timestamps;    /* 每个 token 在这句中的时间（秒），可能为 NULL */
+    int32_t count;
+} cw_result;
+
+/// config 为 NULL 时使用默认配置；失败返回 NULL
+CW_API cw_session *cw_session_create(cw_engine *engine, const cw_session_config *config);
+CW_API void cw_session_destroy(cw_session *session);
+
+/// 最终结果经过的文本管线，NULL 表示不处理；不接管所有权
+CW_API void cw_session_set_text_pipeline(cw_session *session, cw_text_pipeline *pipeline);
+
+/// 写入交错的 float32 音频，缓冲区满时丢弃，返回实际写入的帧数（可在音频回调中调用）
+CW_API int32_t cw_session_write(cw_session *session, const float *samples, int32_t frames);
+
+/// 处理已写入的音频：重采样、切分、解码，返回新产生的结果数
+CW_API int32_t cw_session_process(cw_session *session);
+
+/// 结束输入：处理剩余音频，补尾部静音并解完，产生这句的最终结果，返回新产生的结果数
+CW_API int32_t cw_session_finish(cw_session *session);
+
+/// 丢弃未处理的音频和结果，开始新的会话
+CW_API void cw_session_reset(cw_session *session);
+
+/// 取出一条结果，没有时返回 0
+CW_API int32_t cw_session_poll(cw_session *session, cw_result *result);
+
+/// 缓冲区满时被丢弃的帧数
+CW_API uint64_t cw_session_overflow(const cw_session *session);
+
+/* ==================== 批量调度 ==================== */
+
+/// 服务端同时跑大量会话时，由调度器把各会话就绪的音频流凑成批一起解码，
+/// 比每个会话各自解码更能发挥模型的批处理效率
+///
+/// 调用方每隔几毫秒调用一次 cw_scheduler_tick：
+///     处理各会话已写入的音频（同 cw_session_process，但不解码）
+///     收集所有就绪的音频流，按截止时间先后排序，每 batch_size 路一批解码
+///     解码后各会话产生中间结果、检测端点，结果照常用 cw_session_poll 取出
+/// 每个会话有自己的中间结果截止时间：音频就绪后要在这段时间内解码，
+/// 负载高时截止时间早的会话先解码，交互式听写可以设得短一些，批量转录设得长一些
+///
+/// 调度器和加入它的会话只能在同一个线程上调用；多核可以开多个调度器，各管一部分会话
+
+typedef struct cw_scheduler cw_scheduler;
+
+typedef struct cw_scheduler_config {
+    int32_t batch_size;         /* 一批最多解码几路，0 为 CPU 核数，默认 0 */
+    float partial_deadline;     /* 会话默认的中间结果截止时间（秒），默认 0.2 */
+    float tick_budget;          /* 一次 tick 最多解码多久（秒），超出的留到下次，0 为不限，默认 0.05 */
+} cw_scheduler_config;
+
+typedef struct cw_scheduler_stats {
+    int32_t sessions;           /* 当前的会话数 */
+    uint64_t ticks;
+    uint64_t batches;           /* 解码的批数 */
+    uint64_t decoded;           /* 解码的音频流次数，decoded / batches 即平均批大小 */
+    uint64_t missed;            /* 超过截止时间才解码的次数 */
+    double max_lateness;        /* 超过截止时间最多的一次（秒） */
+} cw_scheduler_stats;
+
+CW_API cw_scheduler_config cw_scheduler_config_default(void);
+
+/// config 为 NULL 时使用默认配置；失败返回 NULL
+CW_API cw_scheduler *cw_scheduler_create(cw_engine *engine, const cw_scheduler_config *config);
+
+/// 销毁调度器，其中的会话恢复为自己解码
+CW_API void cw_scheduler_destroy(cw_scheduler *scheduler);
+
+/// 加入会话，partial_deadline <= 0 时用调度器的默认值
+/// 会话必须属于同一个引擎、不在其他调度器中，否则返回 0
+/// 加入后不要再调用 cw_session_process；cw_session_finish 仍可调用，会话销毁时自动移出
+CW_API int32_t cw_scheduler_add(cw_scheduler *scheduler, cw_session *session, float partial_deadline);
+
+CW_API void cw_scheduler_remove(cw_scheduler *scheduler, cw_session *session);
+
+/// 调度一次，返回解码的音频流次数
+CW_API int32_t cw_scheduler_tick(cw_scheduler *scheduler);
+
+CW_API cw_scheduler_stats cw_scheduler_get_stats(const cw_scheduler *scheduler);
+
+/* ==================== 片段拼接 ==================== */
+
+/// 与 util/server_recognize.seam_merge 一致，tokens 为 count 个 UTF-8 字符串
+/// 返回本片段要保留的 token 区间 [*begin, *end)；参数无效（指针为 NULL、个数为负）或出错时为空区间 [0, 0)
+CW_API void cw_seam_merge(const char *const *prev_tail, int32_t prev_count,
+                          const char *const *tokens, const float *timestamps, int32_t count,
+                          double overlap, double duration, int32_t has_prev, int32_t is_final,
+                          int32_t *begin, int32_t *end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAPSWRITER_ENGINE_H */
@@ -0,0 +1,45 @@
+"""
+编译 capswriter_native 扩展模块：
+
+    cd native
+    python setup.py build_ext --inplace
+
+生成的模块位于 native 文件夹，util/native.py 会自动载入；
+没有编译时，客户端和服务端仍使用纯 Python 实现。
+
+客户端和服务端共用的识别引擎（C 接口，Swift 和 Python 都能调用）用 CMake 编译：
+
+    cmake -S native -B native/build
+    cmake --build native/build
+"""
+
+import sys
+from setuptools import setup, Extension
+
+
+if sys.platform == 'win32':
+    extra_compile_args = ['/std:c++17', '/O2', '/utf-8']
+else:
+    extra_compile_args = ['-std=c++17', '-O2']
+
+
+setup(
+    name='capswriter_native',
+    version='0.1',
+    ext_modules=[
+        Extension(
+            'capswriter_native',
+            sources=[
+                'src/module.cpp',
+                'src/chinese_itn.cpp',
+                'src/hotword.cpp',
+                'src/resampler.cpp',
+                'src/seam_merge.cpp',
+                'src/spacing.cpp',
+            ],
+            include_dirs=['src'],
+            extra_compile_args=extra_compile_args,
+            language='c++',
+        ),
+    ],
+)
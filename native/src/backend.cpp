@@ -0,0 +1,64 @@
+#include "backend.h"
+
+namespace capswriter {
+
+void Backend::decode_batch(void* const* streams, size_t n) {
+    for (size_t i = 0; i < n; ++i) decode(streams[i]);
+}
+
+namespace {
+
+class CallbackBackend : public Backend {
+public:
+    explicit CallbackBackend(const cw_backend& callbacks) : cb_(callbacks) {}
+
+    ~CallbackBackend() override {
+        if (cb_.destroy) cb_.destroy(cb_.user);
+    }
+
+    void* create_stream() override { return cb_.create_stream(cb_.user); }
+    void destroy_stream(void* stream) override { cb_.destroy_stream(cb_.user, stream); }
+
+    void accept_waveform(void* stream, int sample_rate, const float* samples, size_t n) override {
+        cb_.accept_waveform(cb_.user, stream, sample_rate, samples, int32_t(n));
+    }
+
+    void input_finished(void* stream) override { cb_.input_finished(cb_.user, stream); }
+    bool is_ready(void* stream) override { return cb_.is_ready(cb_.user, stream) != 0; }
+    void decode(void* stream) override { cb_.decode(cb_.user, stream); }
+
+    void decode_batch(void* const* streams, size_t n) override {
+        if (cb_.decode_multiple)
+            cb_.decode_multiple(cb_.user, streams, int32_t(n));
+        else
+            Backend::decode_batch(streams, n);
+    }
+    bool is_endpoint(void* stream) override { return cb_.is_endpoint && cb_.is_endpoint(cb_.user, stream) != 0; }
+    void reset(void* stream) override { cb_.reset(cb_.user, stream); }
+
+    void get_result(void* stream, Result& out) override {
+        const float* timestamps = nullptr;
+        int32_t count = 0;
+        const char* text = cb_.get_result(cb_.user, stream, &timestamps, &count);
+        out.text = text ? text : "";
+        if (timestamps && count > 0)
+            out.timestamps.assign(timestamps, timestamps + count);
+        else
+            out.timestamps.clear();
+    }
+
+private:
+    cw_backend cb_;
+};
+
+}  // namespace
+
+std::unique_ptr<Backend> make_callback_backend(const cw_backend& callbacks) {
+    if (!callbacks.create_stream || !callbacks.destroy_stream || !callbacks.accept_waveform ||
+        !callbacks.input_finished || !callbacks.is_ready || !callbacks.decode || !callbacks.reset ||
+        !callbacks.get_result)
+        return nullptr;
+    return std::unique_ptr<Backend>(new CallbackBackend(callbacks));
+}
+
+}  // namespace capswriter
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "capswriter_engine.h"
+
+namespace capswriter {
+
+// 识别后端：一个识别器，可以创建多个音频流
+//
+// 接口与 c-api.h 中的在线识别函数一一对应，stream 是后端自己的句柄
+class Backend {
+public:
+    struct Result {
+        std::string text;
+        std::vector<float> timestamps;
+    };
+
+    virtual ~Backend() = default;
+
+    virtual void* create_stream() = 0;
+    virtual void destroy_stream(void* stream) = 0;
+    virtual void accept_waveform(void* stream, int sample_rate, const float* samples, size_t n) = 0;
+    virtual void input_finished(void* stream) = 0;
+    virtual bool is_ready(void* stream) = 0;
+    virtual void decode(void* stream) = 0;
+    // 一次解码多个音频流，默认逐个解码
+    virtual void decode_batch(void* const* streams, size_t n);
+    virtual bool is_endpoint(void* stream) = 0;
+    virtual void reset(void* stream) = 0;
+    virtual void get_result(void* stream, Result& out) = 0;
+};
+
+// 回调后端，转调 cw_backend 中的函数
+std::unique_ptr<Backend> make_callback_backend(const cw_backend& callbacks);
+
+// sherpa-onnx 在线识别器，没有启用 CAPSWRITER_WITH_SHERPA 时返回空
+std::unique_ptr<Backend> make_sherpa_backend(const SherpaOnnxOnlineRecognizer* recognizer);
+
+}  // namespace capswriter
@@ -0,0 +1,354 @@
+#include "chinese_itn.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "pattern.h"
+#include "unicode_chars.h"
+
+// 移植自 util/chinese_itn.py
+// 正则逐条用 pattern.h 的组合子改写，转换函数逐行对应，
+// Python 中会抛异常的地方（split 数量不对、字典取不到键……）在这里抛 Fail，
+// 由 replace 统一接住，行为与原实现的 try/except 一致
+
+namespace capswriter {
+
+namespace {
+
+using namespace pattern;
+
+struct Fail {};
+
+const char32_t* const kUnits = U"个只分万亿秒";
+
+const char32_t* const kIdioms[] = {
+    U"正经八百", U"五零二落", U"五零四散", U"五十步笑百步", U"乌七八糟", U"污七八糟", U"四百四病",
+    U"思绪万千", U"十有八九", U"十之八九", U"三十而立", U"三十六策", U"三十六计", U"三十六行",
+    U"三五成群", U"三百六十行", U"三六九等", U"七老八十", U"七零八落", U"七零八碎", U"七七八八",
+    U"乱七八遭", U"乱七八糟", U"略知一二", U"零零星星", U"零七八碎", U"九九归一", U"二三其德",
+    U"二三其意", U"无银三百两", U"八九不离十", U"百分之百", U"年三十", U"烂七八糟", U"一点一滴",
+    U"路易十六", U"九三学社", U"五四运动", U"入木三分", U"三十六计",
+};
+
+bool is_space_char(char32_t c) { return c == U' '; }
+
+// [a-zA-Z个只分万亿秒]，不忽略大小写
+bool is_letter_or_unit(char32_t c) { return is_ascii_letter(c) || contains(kUnits, c); }
+
+// ---------------- 正则 ----------------
+
+// 总模式，筛选出可能需要替换的内容（带 i 标志）
+const auto kPattern = seq(
+    opt(group<1>(seq(chr(is_letter_ignorecase), star(chr(is_space))))),
+    group<2>(seq(
+        plus(group<3>(alt(
+            chr(In{U"零幺一二两三四五六七八九十百千万点比"}),
+            seq(chr(In{U"零一二三四五六七八九十"}), chr(is_space_char)),
+            seq(behind(In{U"一二两三四五六七八九十"}), chr(In{U"年月日号分"})),
+            group<4>(Lit{U"分之"})))),
+        opt(group<5>(alt(
+            seq(behind(In{U"一二两三四五六七八九十"}),
+                chr([](char32_t c) { return is_letter_ignorecase(c) || contains(U"年月日号个只分万亿秒", c); })),
+            seq(behind(In{U"一二两三四五六七八九十"}, is_space), chr(is_letter_ignorecase))))),
+        cond<1>(Empty{},
+                plus(cond<5>(Empty{}, group<6>(alt(chr(In{U"零幺一二两三四五六七八九十百千万亿点比"}),
+                                                  group<7>(Lit{U"分之"})))))))));
+
+// 纯数字序号
+const auto kPureNum = seq(plus(chr(In{U"零幺一二三四五六七八九"})),
+                          star(group<1>(seq(Lit{U"点"}, plus(chr(In{U"零幺一二三四五六七八九"}))))),
+                          star(chr(is_space_char)), opt(chr(is_letter_or_unit)));
+
+// 数值
+const auto kValueNum = seq(opt(Lit{U"十"}),
+                           star(group<1>(seq(opt(Lit{U"零"}), chr(In{U"一二两三四五六七八九十"}),
+                                             rep(chr(In{U"十百千万"}), 1, 2)))),
+                           opt(Lit{U"零"}), opt(chr(In{U"一二三四五六七八九"})),
+                           opt(group<2>(seq(Lit{U"点"}, plus(chr(In{U"零一二三四五六七八九"}))))),
+                           star(chr(is_space_char)), opt(chr(is_letter_or_unit)));
+
+// 带小数的数值：[...]+(点)?(?(n)[...]+)
+template <int N>
+auto decimal_value() {
+    return seq(plus(chr(In{U"零一二三四五六七八九十百千万"})), opt(group<N>(Lit{U"点"})),
+               cond<N>(plus(chr(In{U"零一二三四五六七八九"})), Empty{}));
+}
+
+// 百分值（fullmatch 时后顾在开头总是成立）
+const auto kPercentValue = seq(group<1>(Lit{U"百分之"}), decimal_value<2>());
+
+// 分数
+const auto kFractionValue = seq(group<1>(decimal_value<2>()), Lit{U"分之"}, group<3>(decimal_value<4>()));
+
+// 比值
+const auto kRatioValue = seq(group<1>(decimal_value<2>()), Lit{U"比"}, group<3>(decimal_value<4>()));
+
+// 时间
+const auto kTimeValue = seq(plus(chr(In{U"零一二三四五六七八九十"})), Lit{U"点"},
+                            group<1>(seq(plus(chr(In{U"零一二三四五六七八九十"})), Lit{U"分"})),
+                            opt(group<2>(seq(plus(chr(In{U"零一二三四五六七八九十"})), Lit{U"秒"}))));
+
+// 日期
+const auto kDateValue = seq(opt(group<1>(seq(plus(chr(In{U"零一二三四五六七八九"})), Lit{U"年"}))),
+                            group<2>(seq(plus(chr(In{U"一二三四五六七八九十"})), Lit{U"月"})),
+                            group<3>(seq(plus(chr(In{U"一二三四五六七八九十"})), chr(In{U"日号"}))));
+
+template <class P>
+bool full(const P& p, const std::u32string& s) {
+    Context c(s.data(), s.size());
+    return fullmatch(p, c);
+}
+
+// ---------------- 字符串工具 ----------------
+
+std::u32string strip_set(const std::u32string& s, bool (*pred)(char32_t)) {
+    size_t b = 0, e = s.size();
+    while (b < e && pred(s[b])) ++b;
+    while (e > b && pred(s[e - 1])) --e;
+    return s.substr(b, e - b);
+}
+
+bool is_unit(char32_t c) { return contains(kUnits, c); }
+bool is_unit_or_letter(char32_t c) { return is_unit(c) || is_ascii_letter(c); }
+
+size_t count(const std::u32string& s, const std::u32string& sep) {
+    size_t n = 0;
+    for (size_t p = s.find(sep); p != std::u32string::npos; p = s.find(sep, p + sep.size())) ++n;
+    return n;
+}
+
+// a, b = s.split(sep)，数量不对时 Python 会抛 ValueError
+void split2(const std::u32string& s, const std::u32string& sep, std::u32string& a, std::u32string& b) {
+    if (count(s, sep) != 1) throw Fail();
+    size_t p = s.find(sep);
+    a = s.substr(0, p);
+    b = s.substr(p + sep.size());
+}
+
+std::u32string to_u32(const std::string& ascii) { return std::u32string(ascii.begin(), ascii.end()); }
+
+// 参与运算的值都不为负
+int64_t checked_add(int64_t a, int64_t b) {
+    if (a > INT64_MAX - b) throw ItnOverflow();
+    return a + b;
+}
+
+int64_t checked_mul(int64_t a, int64_t b) {
+    if (a && b > INT64_MAX / a) throw ItnOverflow();
+    return a * b;
+}
+
+// ---------------- 转换函数 ----------------
+
+char32_t num_mapper(char32_t c) {
+    switch (c) {
+        case U'零': return U'0';
+        case U'一': case U'幺': return U'1';
+        case U'二': case U'两': return U'2';
+        case U'三': return U'3';
+        case U'四': return U'4';
+        case U'五': return U'5';
+        case U'六': return U'6';
+        case U'七': return U'7';
+        case U'八': return U'8';
+        case U'九': return U'9';
+        case U'点': return U'.';
+    }
+    throw Fail();
+}
+
+int64_t value_mapper(char32_t c) {
+    switch (c) {
+        case U'零': return 0;
+        case U'一': return 1;
+        case U'二': case U'两': return 2;
+        case U'三': return 3;
+        case U'四': return 4;
+        case U'五': return 5;
+        case U'六': return 6;
+        case U'七': return 7;
+        case U'八': return 8;
+        case U'九': return 9;
+        case U'十': return 10;
+        case U'百': return 100;
+        case U'千': return 1000;
+        case U'万': return 10000;
+    }
+    throw Fail();
+}
+
+// 把数字后面跟着的单位剥离开
+void strip_unit(const std::u32string& original, std::u32string& stripped, std::u32string& unit) {
+    unit.clear();
+    stripped = strip_set(strip_set(original, is_unit_or_letter), is_space);
+    if (stripped != original) unit = original.substr(std::min(stripped.size(), original.size()));
+}
+
+std::u32string convert_pure_num(const std::u32string& original, bool strict = false) {
+    std::u32string stripped, unit;
+    strip_unit(original, stripped, unit);
+    if (stripped == U"一" && !strict) return original;
+    std::u32string converted;
+    for (char32_t c : stripped) converted += num_mapper(c);
+    return converted + unit;
+}
+
+std::u32string convert_value_num(const std::u32string& original) {
+    std::u32string stripped, unit;
+    strip_unit(original, stripped, unit);
+    if (stripped.find(U'点') == std::u32string::npos) stripped += U'点';
+    std::u32string int_part, decimal_part;
+    split2(stripped, U"点", int_part, decimal_part);
+    if (int_part.empty()) return original;
+
+    int64_t value = 0, temp = 0, base = 1;
+    for (char32_t c : int_part) {
+        if (c == U'十') {
+            temp = temp == 0 ? 10 : checked_mul(value_mapper(c), temp);
+            base = 1;
+        } else if (c == U'零') {
+            base = 1;
+        } else if (contains(U"一二两三四五六七八九", c)) {
+            temp = checked_add(temp, value_mapper(c));
+        } else if (c == U'万') {
+            value = checked_add(value, temp);
+            value = checked_mul(value, value_mapper(c));
+            base = value_mapper(c) / 10;
+            temp = 0;
+        } else if (c == U'百' || c == U'千') {
+            value = checked_add(value, checked_mul(temp, value_mapper(c)));
+            base = value_mapper(c) / 10;
+            temp = 0;
+        }
+    }
+    value = checked_add(value, checked_mul(temp, base));
+    std::u32string final_ = to_u32(std::to_string(value));
+
+    std::u32string decimal_str = convert_pure_num(decimal_part, true);
+    if (!decimal_str.empty()) final_ += U"." + decimal_str;
+    final_ += unit;
+    return final_;
+}
+
+std::u32string convert_fraction_value(const std::u32string& original) {
+    std::u32string denominator, numerator;
+    split2(original, U"分之", denominator, numerator);
+    return convert_value_num(numerator) + U"/" + convert_value_num(denominator);
+}
+
+std::u32string convert_percent_value(const std::u32string& original) {
+    return convert_value_num(original.size() > 3 ? original.substr(3) : U"") + U"%";
+}
+
+std::u32string convert_ratio_value(const std::u32string& original) {
+    std::u32string num1, num2;
+    split2(original, U"比", num1, num2);
+    return convert_value_num(num1) + U":" + convert_value_num(num2);
+}
+
+std::u32string convert_time_value(const std::u32string& original) {
+    std::vector<std::u32string> res;
+    std::u32string part;
+    for (char32_t c : original) {
+        if (contains(U"点分秒", c)) {
+            if (!part.empty()) res.push_back(part);
+            part.clear();
+        } else {
+            part += c;
+        }
+    }
+    if (!part.empty()) res.push_back(part);
+    if (res.size() < 2) throw Fail();
+
+    std::u32string final_ = convert_value_num(res[0]);
+    final_ += U":" + convert_value_num(res[1]);
+    if (res.size() > 2) final_ += U":" + convert_value_num(res[2]);
+    if (res.size() > 3) final_ += U"." + convert_pure_num(res[3]);
+    return final_;
+}
+
+std::u32string convert_date_value(std::u32string original) {
+    std::u32string final_, head;
+    if (original.find(U'年') != std::u32string::npos) {
+        split2(original, U"年", head, original);
+        final_ += convert_pure_num(head) + U"年";
+    }
+    if (original.find(U'月') != std::u32string::npos) {
+        split2(original, U"月", head, original);
+        final_ += convert_value_num(head) + U"月";
+    }
+    if (original.find(U'日') != std::u32string::npos) {
+        split2(original, U"日", head, original);
+        final_ += convert_value_num(head) + U"日";
+    } else if (original.find(U'号') != std::u32string::npos) {
+        split2(original, U"号", head, original);
+        final_ += convert_value_num(head) + U"号";
+    }
+    return final_;
+}
+
+std::u32string replace(const std::u32string& string, const std::vector<long>& idiom_pos, const Context& m) {
+    long l_pos = std::max(m.caps[2].begin - 2, 0L), r_pos = m.caps[2].end;
+    std::u32string head;
+    if (m.caps[1].matched()) head = string.substr(m.caps[1].begin, m.caps[1].end - m.caps[1].begin);
+    std::u32string original = string.substr(m.caps[2].begin, m.caps[2].end - m.caps[2].begin);
+
+    try {
+        std::u32string final_;
+        bool idiom = false;
+        for (long p : idiom_pos)
+            if (p >= l_pos && p < r_pos) idiom = true;
+
+        if (idiom) {
+            final_ = original;
+        } else if (full(kPureNum, strip_set(original, is_unit))) {
+            final_ = convert_pure_num(original);
+        } else if (full(kValueNum, strip_set(original, is_unit))) {
+            final_ = convert_value_num(original);
+        } else if (full(kPercentValue, original)) {
+            final_ = convert_percent_value(original);
+        } else if (full(kFractionValue, original)) {
+            final_ = convert_fraction_value(original);
+        } else if (full(kRatioValue, original)) {
+            final_ = convert_ratio_value(original);
+        } else if (full(kTimeValue, original)) {
+            final_ = convert_time_value(original);
+        } else if (full(kDateValue, original)) {
+            final_ = convert_date_value(original);
+        } else {
+            final_ = original;
+        }
+        if (!head.empty()) final_ = head + final_;
+        return final_;
+    } catch (const Fail&) {
+        return original;
+    }
+}
+
+}  // namespace
+
+std::u32string chinese_to_num(const std::u32string& text) {
+    // string.find(idiom)：每个成语在整句中第一次出现的位置
+    std::vector<long> idiom_pos;
+    for (const char32_t* idiom : kIdioms) {
+        size_t p = text.find(idiom);
+        if (p != std::u32string::npos) idiom_pos.push_back(long(p));
+    }
+
+    std::u32string out;
+    Context c(text.data(), text.size());
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end;
+        if (match_at(kPattern, c, pos, end) && end > pos) {
+            out += replace(text, idiom_pos, c);
+            pos = end;
+        } else {
+            out += text[pos];
+            ++pos;
+        }
+    }
+    return out;
+}
+
+}  // namespace capswriter
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+namespace capswriter {
+
+// 数值超出 64 位整数范围时抛出，调用方应退回 Python 实现
+struct ItnOverflow : std::overflow_error {
+    ItnOverflow() : std::overflow_error("chinese_to_num: value out of range") {}
+};
+
+// 把中文数字转为阿拉伯数字，与 util/chinese_itn.chinese_to_num 行为一致
+std::u32string chinese_to_num(const std::u32string& text);
+
+}  // namespace capswriter
@@ -0,0 +1,312 @@
+// capswriter_engine.h 的实现：C 接口只做参数检查和类型转换，逻辑都在各个 C++ 类中
+// 异常不能越过 C 接口，内存不足等异常在这里接住，返回 NULL 或 0
+
+#include "capswriter_engine.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "backend.h"
+#include "scheduler.h"
+#include "seam_merge.h"
+#include "session.h"
+#include "text_pipeline.h"
+#include "utf8.h"
+
+using namespace capswriter;
+
+struct cw_engine {
+    std::unique_ptr<Backend> backend;
+};
+
+struct cw_text_pipeline {
+    TextPipeline pipeline;
+};
+
+struct cw_session {
+    std::unique_ptr<Session> session;
+    cw_scheduler* scheduler = nullptr;
+};
+
+struct cw_scheduler {
+    std::unique_ptr<Scheduler> scheduler;
+    std::vector<cw_session*> sessions;
+};
+
+namespace {
+
+std::u32string u32(const char* s) { return s ? utf8_to_u32(s, std::strlen(s)) : std::u32string(); }
+
+char* dup_string(const std::string& s) {
+    char* out = static_cast<char*>(std::malloc(s.size() + 1));
+    if (out) std::memcpy(out, s.c_str(), s.size() + 1);
+    return out;
+}
+
+bool valid_config(const cw_session_config& c) {
+    return c.input_sample_rate > 0 && c.input_channels > 0 && c.sample_rate > 0 && c.ring_seconds > 0 &&
+           c.tail_padding >= 0 && c.preroll >= 0 && c.min_speech >= 0 && c.max_silence > 0 && c.max_segment > 0;
+}
+
+}  // namespace
+
+extern "C" {
+
+// ---------------- 引擎 ----------------
+
+cw_engine* cw_engine_create(const cw_backend* backend) {
+    if (!backend) return nullptr;
+    try {
+        auto impl = make_callback_backend(*backend);
+        if (!impl) return nullptr;
+        return new cw_engine{std::move(impl)};
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+cw_engine* cw_engine_create_sherpa(const struct SherpaOnnxOnlineRecognizer* recognizer) {
+    try {
+        auto impl = make_sherpa_backend(recognizer);
+        if (!impl) return nullptr;
+        return new cw_engine{std::move(impl)};
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void cw_engine_destroy(cw_engine* engine) { delete engine; }
+
+float cw_tail_padding(const char* model_type) {
+    // 与 Mac 客户端 StreamFinalizer.tailPadding 一致
+    std::string type = model_type ? model_type : "";
+    for (char& c : type) c = char(std::tolower(static_cast<unsigned char>(c)));
+    if (type.find("paraformer") != std::string::npos) return 0.66f;
+    for (const char* key : {"zipformer", "ctc", "transducer", "lstm"})
+        if (type.find(key) != std::string::npos) return 0.3f;
+    return 0.66f;
+}
+
+// ---------------- 文本管线 ----------------
+
+cw_text_options cw_text_options_default(void) { return cw_text_options{1, 1, 1}; }
+
+cw_text_pipeline* cw_text_pipeline_create(const cw_text_options* options) {
+    cw_text_options o = options ? *options : cw_text_options_default();
+    TextPipeline::Options opts;
+    opts.spacing = o.spacing != 0;
+    opts.itn = o.itn != 0;
+    opts.hotwords = o.hotwords != 0;
+    try {
+        return new cw_text_pipeline{TextPipeline(opts)};
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void cw_text_pipeline_destroy(cw_text_pipeline* pipeline) { delete pipeline; }
+
+void cw_text_pipeline_add_hotword(cw_text_pipeline* pipeline, const char* hotword) {
+    if (!pipeline || !hotword) return;
+    try {
+        pipeline->pipeline.add_hotword(u32(hotword));
+    } catch (...) {
+    }
+}
+
+void cw_text_pipeline_add_rule(cw_text_pipeline* pipeline, const char* from, const char* to) {
+    if (!pipeline || !from) return;
+    try {
+        pipeline->pipeline.add_rule(u32(from), u32(to));
+    } catch (...) {
+    }
+}
+
+void cw_text_pipeline_clear(cw_text_pipeline* pipeline) {
+    if (pipeline) pipeline->pipeline.clear();
+}
+
+char* cw_text_pipeline_process(cw_text_pipeline* pipeline, const char* text) {
+    if (!pipeline || !text) return nullptr;
+    try {
+        return dup_string(u32_to_utf8(pipeline->pipeline.process(u32(text))));
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void cw_string_free(char* s) { std::free(s); }
+
+// ---------------- 会话 ----------------
+
+cw_session_config cw_session_config_default(void) {
+    cw_session_config c;
+    c.input_sample_rate = 16000;
+    c.input_channels = 1;
+    c.sample_rate = 16000;
+    c.ring_seconds = 10.0f;
+    c.tail_padding = 0.66f;
+    c.use_endpoint = 1;
+    c.segment = 0;
+    c.vad_energy_margin = 12.0f;
+    c.vad_energy_floor = -50.0f;
+    c.preroll = 0.3f;
+    c.min_speech = 0.3f;
+    c.max_silence = 0.8f;
+    c.max_segment = 60.0f;
+    return c;
+}
+
+cw_session* cw_session_create(cw_engine* engine, const cw_session_config* config) {
+    if (!engine) return nullptr;
+    cw_session_config c = config ? *config : cw_session_config_default();
+    if (!valid_config(c)) return nullptr;
+    try {
+        std::unique_ptr<Session> session(new Session(*engine->backend, c));
+        if (!session->valid()) return nullptr;
+        return new cw_session{std::move(session)};
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void cw_session_destroy(cw_session* session) {
+    if (session && session->scheduler) cw_scheduler_remove(session->scheduler, session);
+    delete session;
+}
+
+void cw_session_set_text_pipeline(cw_session* session, cw_text_pipeline* pipeline) {
+    if (session) session->session->set_text_pipeline(pipeline ? &pipeline->pipeline : nullptr);
+}
+
+int32_t cw_session_write(cw_session* session, const float* samples, int32_t frames) {
+    if (!session || !samples || frames <= 0) return 0;
+    return int32_t(session->session->write(samples, size_t(frames)));
+}
+
+int32_t cw_session_process(cw_session* session) {
+    if (!session) return 0;
+    try {
+        return session->session->process();
+    } catch (...) {
+        return 0;
+    }
+}
+
+int32_t cw_session_finish(cw_session* session) {
+    if (!session) return 0;
+    try {
+        return session->session->finish();
+    } catch (...) {
+        return 0;
+    }
+}
+
+void cw_session_reset(cw_session* session) {
+    if (session) session->session->reset();
+}
+
+int32_t cw_session_poll(cw_session* session, cw_result* result) {
+    if (!session || !result) return 0;
+    return session->session->poll(*result) ? 1 : 0;
+}
+
+uint64_t cw_session_overflow(const cw_session* session) { return session ? session->session->overflow() : 0; }
+
+// ---------------- 批量调度 ----------------
+
+cw_scheduler_config cw_scheduler_config_default(void) {
+    cw_scheduler_config c;
+    c.batch_size = 0;
+    c.partial_deadline = 0.2f;
+    c.tick_budget = 0.05f;
+    return c;
+}
+
+cw_scheduler* cw_scheduler_create(cw_engine* engine, const cw_scheduler_config* config) {
+    if (!engine) return nullptr;
+    cw_scheduler_config c = config ? *config : cw_scheduler_config_default();
+    if (c.batch_size < 0 || c.partial_deadline <= 0 || c.tick_budget < 0) return nullptr;
+
+    Scheduler::Config sc;
+    sc.batch_size = size_t(c.batch_size);
+    sc.partial_deadline = c.partial_deadline;
+    sc.tick_budget = c.tick_budget;
+    try {
+        return new cw_scheduler{std::unique_ptr<Scheduler>(new Scheduler(*engine->backend, sc)), {}};
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void cw_scheduler_destroy(cw_scheduler* scheduler) {
+    if (!scheduler) return;
+    for (cw_session* session : scheduler->sessions) session->scheduler = nullptr;
+    delete scheduler;
+}
+
+int32_t cw_scheduler_add(cw_scheduler* scheduler, cw_session* session, float partial_deadline) {
+    if (!scheduler || !session || session->scheduler) return 0;
+    try {
+        scheduler->sessions.reserve(scheduler->sessions.size() + 1);
+        if (!scheduler->scheduler->add(session->session.get(), partial_deadline)) return 0;
+    } catch (...) {
+        return 0;
+    }
+    scheduler->sessions.push_back(session);
+    session->scheduler = scheduler;
+    return 1;
+}
+
+void cw_scheduler_remove(cw_scheduler* scheduler, cw_session* session) {
+    if (!scheduler || !session || session->scheduler != scheduler) return;
+    scheduler->scheduler->remove(session->session.get());
+    auto& sessions = scheduler->sessions;
+    sessions.erase(std::remove(sessions.begin(), sessions.end(), session), sessions.end());
+    session->scheduler = nullptr;
+}
+
+int32_t cw_scheduler_tick(cw_scheduler* scheduler) {
+    if (!scheduler) return 0;
+    try {
+        return scheduler->scheduler->tick();
+    } catch (...) {
+        return 0;
+    }
+}
+
+cw_scheduler_stats cw_scheduler_get_stats(const cw_scheduler* scheduler) {
+    if (!scheduler) return cw_scheduler_stats{};
+    return scheduler->scheduler->stats();
+}
+
+// ---------------- 片段拼接 ----------------
+
+void cw_seam_merge(const char* const* prev_tail, int32_t prev_count, const char* const* tokens,
+                   const float* timestamps, int32_t count, double overlap, double duration, int32_t has_prev,
+                   int32_t is_final, int32_t* begin, int32_t* end) {
+    if (begin) *begin = 0;
+    if (end) *end = 0;
+    if (prev_count < 0 || count < 0 || (prev_count && !prev_tail) || (count && (!tokens || !timestamps))) return;
+    for (int32_t i = 0; i < prev_count; ++i)
+        if (!prev_tail[i]) return;
+    for (int32_t i = 0; i < count; ++i)
+        if (!tokens[i]) return;
+
+    try {
+        std::vector<std::string> prev(prev_tail, prev_tail + prev_count), toks(tokens, tokens + count);
+        std::vector<double> times(timestamps, timestamps + count);
+        SeamBounds b = seam_merge(prev, toks, times, overlap, duration, has_prev != 0, is_final != 0);
+        if (begin) *begin = int32_t(b.begin);
+        if (end) *end = int32_t(b.end);
+    } catch (...) {
+    }
+}
+
+}  // extern "C"
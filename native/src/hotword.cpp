@@ -0,0 +1,106 @@
+#include "hotword.h"
+
+#include <queue>
+
+namespace capswriter {
+
+HotwordMatcher::HotwordMatcher() { clear(); }
+
+void HotwordMatcher::clear() {
+    nodes_.assign(1, Node());
+    empty_patterns_.clear();
+    lengths_.clear();
+    num_patterns_ = 0;
+    built_ = false;
+}
+
+int HotwordMatcher::add(const std::u32string& pattern) {
+    int id = int(num_patterns_++);
+    lengths_.push_back(pattern.size());
+    built_ = false;
+
+    // 空模式在 Python 中 `'' in s` 恒为真
+    if (pattern.empty()) {
+        empty_patterns_.push_back(id);
+        return id;
+    }
+
+    int node = 0;
+    for (char32_t c : pattern) {
+        auto it = nodes_[node].next.find(c);
+        if (it == nodes_[node].next.end()) {
+            nodes_.emplace_back();
+            int child = int(nodes_.size()) - 1;
+            nodes_[node].next[c] = child;
+            node = child;
+        } else {
+            node = it->second;
+        }
+    }
+    nodes_[node].outputs.push_back(id);
+    return id;
+}
+
+void HotwordMatcher::build() {
+    std::queue<int> queue;
+    for (auto& kv : nodes_[0].next) {
+        nodes_[kv.second].fail = 0;
+        queue.push(kv.second);
+    }
+    while (!queue.empty()) {
+        int node = queue.front();
+        queue.pop();
+        for (auto& kv : nodes_[node].next) {
+            int child = kv.second;
+            int f = nodes_[node].fail;
+            while (f && !nodes_[f].next.count(kv.first)) f = nodes_[f].fail;
+            auto it = nodes_[f].next.find(kv.first);
+            nodes_[child].fail = (it != nodes_[f].next.end() && it->second != child) ? it->second : 0;
+
+            // 失配节点的输出也是本节点的输出，按层序合并后扫描时无需再沿失配链查找
+            const auto& inherited = nodes_[nodes_[child].fail].outputs;
+            nodes_[child].outputs.insert(nodes_[child].outputs.end(), inherited.begin(), inherited.end());
+            queue.push(child);
+        }
+    }
+    built_ = true;
+}
+
+std::vector<int> HotwordMatcher::find(const std::u32string& text) {
+    if (!built_) build();
+
+    std::vector<char> hit(num_patterns_, 0);
+    int node = 0;
+    for (char32_t c : text) {
+        while (node && !nodes_[node].next.count(c)) node = nodes_[node].fail;
+        auto it = nodes_[node].next.find(c);
+        node = it == nodes_[node].next.end() ? 0 : it->second;
+
+        for (int id : nodes_[node].outputs) hit[id] = 1;
+    }
+    for (int id : empty_patterns_) hit[id] = 1;
+
+    std::vector<int> result;
+    for (size_t id = 0; id < num_patterns_; ++id)
+        if (hit[id]) result.push_back(int(id));
+    return result;
+}
+
+std::vector<std::pair<size_t, int>> HotwordMatcher::locate(const std::u32string& text) {
+    if (!built_) build();
+
+    std::vector<std::pair<size_t, int>> result;
+    int node = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char32_t c = text[i];
+        while (node && !nodes_[node].next.count(c)) node = nodes_[node].fail;
+        auto it = nodes_[node].next.find(c);
+        node = it == nodes_[node].next.end() ? 0 : it->second;
+
+        // 节点自身的模式在前，继承的（更短的）在后
+        for (int id : nodes_[node].outputs) result.emplace_back(i + 1 - lengths_[id], id);
+    }
+    return result;
+}
+
+}  // namespace capswriter
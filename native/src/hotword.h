@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace capswriter {
+
+// 多模式子串匹配（Aho-Corasick）
+//
+// 热词替换原先对每个热词做一次 `pattern in sentence`，热词越多越慢；
+// 这里把所有模式编译成一个自动机，一次扫描就得到全部命中的模式编号
+class HotwordMatcher {
+public:
+    HotwordMatcher();
+
+    // 添加模式，返回模式编号（从 0 开始按添加顺序递增）
+    int add(const std::u32string& pattern);
+
+    void clear();
+
+    size_t size() const { return num_patterns_; }
+
+    // 返回在 text 中出现过的模式编号，升序排列
+    std::vector<int> find(const std::u32string& text);
+
+    // 所有非空模式的出现位置 (起点, 模式编号)，按终点、再按模式由长到短排列
+    std::vector<std::pair<size_t, int>> locate(const std::u32string& text);
+
+    size_t length(int id) const { return lengths_[id]; }
+
+private:
+    struct Node {
+        std::map<char32_t, int> next;
+        int fail = 0;
+        std::vector<int> outputs;
+    };
+
+    void build();
+
+    std::vector<Node> nodes_;
+    std::vector<int> empty_patterns_;
+    std::vector<size_t> lengths_;
+    size_t num_patterns_ = 0;
+    bool built_ = false;
+};
+
+}  // namespace capswriter
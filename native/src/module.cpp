@@ -0,0 +1,355 @@
+// capswriter_native：客户端、服务端热点路径的 C++ 实现
+//
+// Python 端的 util 模块保留原有函数名，检测到本模块时转调这里，
+// 没有编译本模块时仍走纯 Python 实现。音频类接口通过 buffer 协议
+// 直接读取 numpy 数组的内存，不做额外拷贝。
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <new>
+#include <string>
+#include <vector>
+
+#include "chinese_itn.h"
+#include "hotword.h"
+#include "resampler.h"
+#include "ring_buffer.h"
+#include "seam_merge.h"
+#include "spacing.h"
+
+using namespace capswriter;
+
+namespace {
+
+// ---------------- 字符串转换 ----------------
+
+bool to_u32(PyObject* obj, std::u32string& out) {
+    if (!PyUnicode_Check(obj)) {
+        PyErr_SetString(PyExc_TypeError, "expected str");
+        return false;
+    }
+    Py_UCS4* data = PyUnicode_AsUCS4Copy(obj);
+    if (!data) return false;
+    out.assign(reinterpret_cast<char32_t*>(data), PyUnicode_GetLength(obj));
+    PyMem_Free(data);
+    return true;
+}
+
+PyObject* from_u32(const std::u32string& s) {
+    return PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, s.data(), Py_ssize_t(s.size()));
+}
+
+bool to_utf8_list(PyObject* obj, std::vector<std::string>& out) {
+    PyObject* seq = PySequence_Fast(obj, "expected a sequence of str");
+    if (!seq) return false;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    out.reserve(n);
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        Py_ssize_t size;
+        const char* utf8 = PyUnicode_AsUTF8AndSize(PySequence_Fast_GET_ITEM(seq, i), &size);
+        if (!utf8) {
+            Py_DECREF(seq);
+            return false;
+        }
+        out.emplace_back(utf8, size);
+    }
+    Py_DECREF(seq);
+    return true;
+}
+
+bool to_double_list(PyObject* obj, std::vector<double>& out) {
+    PyObject* seq = PySequence_Fast(obj, "expected a sequence of float");
+    if (!seq) return false;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    out.reserve(n);
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        double v = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(seq, i));
+        if (v == -1.0 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            return false;
+        }
+        out.push_back(v);
+    }
+    Py_DECREF(seq);
+    return true;
+}
+
+// ---------------- 文本 ----------------
+
+PyObject* py_adjust_space(PyObject*, PyObject* arg) {
+    std::u32string text;
+    if (!to_u32(arg, text)) return nullptr;
+    std::u32string result;
+    Py_BEGIN_ALLOW_THREADS
+    result = adjust_space(text);
+    Py_END_ALLOW_THREADS
+    return from_u32(result);
+}
+
+PyObject* py_chinese_to_num(PyObject*, PyObject* arg) {
+    std::u32string text;
+    if (!to_u32(arg, text)) return nullptr;
+    std::u32string result;
+    bool overflow = false;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        result = chinese_to_num(text);
+    } catch (const ItnOverflow&) {
+        overflow = true;
+    }
+    Py_END_ALLOW_THREADS
+    if (overflow) {
+        PyErr_SetString(PyExc_OverflowError, "chinese_to_num: value out of range");
+        return nullptr;
+    }
+    return from_u32(result);
+}
+
+// ---------------- 片段拼接 ----------------
+
+PyObject* py_seam_merge(PyObject*, PyObject* args) {
+    PyObject *prev_obj, *tokens_obj, *timestamps_obj;
+    double overlap, duration;
+    int has_prev, is_final;
+    if (!PyArg_ParseTuple(args, "OOOddpp", &prev_obj, &tokens_obj, &timestamps_obj, &overlap, &duration,
+                          &has_prev, &is_final))
+        return nullptr;
+
+    std::vector<std::string> prev, tokens;
+    std::vector<double> timestamps;
+    if (!to_utf8_list(prev_obj, prev) || !to_utf8_list(tokens_obj, tokens) ||
+        !to_double_list(timestamps_obj, timestamps))
+        return nullptr;
+
+    SeamBounds b = seam_merge(prev, tokens, timestamps, overlap, duration, has_prev, is_final);
+    return Py_BuildValue("(nn)", Py_ssize_t(b.begin), Py_ssize_t(b.end));
+}
+
+// ---------------- 音频 ----------------
+
+PyObject* py_downmix_decimate(PyObject*, PyObject* args) {
+    Py_buffer view;
+    int channels, factor;
+    if (!PyArg_ParseTuple(args, "y*ii", &view, &channels, &factor)) return nullptr;
+    if (channels < 1 || factor < 1 || view.len % (sizeof(float) * channels)) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "buffer size does not match channels");
+        return nullptr;
+    }
+
+    size_t frames = view.len / sizeof(float) / channels;
+    size_t out_frames = decimated_frames(frames, factor);
+    PyObject* out = PyBytes_FromStringAndSize(nullptr, Py_ssize_t(out_frames * sizeof(float)));
+    if (!out) {
+        PyBuffer_Release(&view);
+        return nullptr;
+    }
+    downmix_decimate(static_cast<const float*>(view.buf), frames, channels, factor,
+                     reinterpret_cast<float*>(PyBytes_AS_STRING(out)));
+    PyBuffer_Release(&view);
+    return out;
+}
+
+// ---------------- HotwordMatcher ----------------
+
+struct PyHotwordMatcher {
+    PyObject_HEAD
+    HotwordMatcher* matcher;
+};
+
+PyObject* matcher_new(PyTypeObject* type, PyObject*, PyObject*) {
+    auto* self = reinterpret_cast<PyHotwordMatcher*>(type->tp_alloc(type, 0));
+    if (!self) return nullptr;
+    self->matcher = new (std::nothrow) HotwordMatcher();
+    if (!self->matcher) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return reinterpret_cast<PyObject*>(self);
+}
+
+void matcher_dealloc(PyHotwordMatcher* self) {
+    delete self->matcher;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+PyObject* matcher_add(PyHotwordMatcher* self, PyObject* arg) {
+    std::u32string pattern;
+    if (!to_u32(arg, pattern)) return nullptr;
+    return PyLong_FromLong(self->matcher->add(pattern));
+}
+
+PyObject* matcher_clear(PyHotwordMatcher* self, PyObject*) {
+    self->matcher->clear();
+    Py_RETURN_NONE;
+}
+
+PyObject* matcher_find(PyHotwordMatcher* self, PyObject* arg) {
+    std::u32string text;
+    if (!to_u32(arg, text)) return nullptr;
+    std::vector<int> ids = self->matcher->find(text);
+    PyObject* list = PyList_New(Py_ssize_t(ids.size()));
+    if (!list) return nullptr;
+    for (size_t i = 0; i < ids.size(); ++i) PyList_SET_ITEM(list, i, PyLong_FromLong(ids[i]));
+    return list;
+}
+
+Py_ssize_t matcher_len(PyHotwordMatcher* self) { return Py_ssize_t(self->matcher->size()); }
+
+PyMethodDef matcher_methods[] = {
+    {"add", (PyCFunction)matcher_add, METH_O, "add(pattern) -> id，添加一个模式"},
+    {"clear", (PyCFunction)matcher_clear, METH_NOARGS, "清空所有模式"},
+    {"find", (PyCFunction)matcher_find, METH_O, "find(text) -> [id]，返回出现过的模式编号（升序）"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PySequenceMethods matcher_as_sequence = {};
+
+PyTypeObject HotwordMatcherType = {PyVarObject_HEAD_INIT(nullptr, 0)};
+
+// ---------------- RingBuffer ----------------
+
+struct PyRingBuffer {
+    PyObject_HEAD
+    RingBuffer* ring;
+};
+
+PyObject* ring_new(PyTypeObject* type, PyObject* args, PyObject*) {
+    Py_ssize_t frames;
+    int channels;
+    if (!PyArg_ParseTuple(args, "ni", &frames, &channels)) return nullptr;
+    if (frames < 1 || channels < 1) {
+        PyErr_SetString(PyExc_ValueError, "frames and channels must be positive");
+        return nullptr;
+    }
+    auto* self = reinterpret_cast<PyRingBuffer*>(type->tp_alloc(type, 0));
+    if (!self) return nullptr;
+    self->ring = new (std::nothrow) RingBuffer(size_t(frames), channels);
+    if (!self->ring) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return reinterpret_cast<PyObject*>(self);
+}
+
+void ring_dealloc(PyRingBuffer* self) {
+    delete self->ring;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+PyObject* ring_write(PyRingBuffer* self, PyObject* arg) {
+    Py_buffer view;
+    if (PyObject_GetBuffer(arg, &view, PyBUF_C_CONTIGUOUS) < 0) return nullptr;
+    size_t frame_bytes = sizeof(float) * self->ring->channels();
+    if (view.len % frame_bytes) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "buffer size does not match channels");
+        return nullptr;
+    }
+    size_t n = self->ring->write(static_cast<const float*>(view.buf), view.len / frame_bytes);
+    PyBuffer_Release(&view);
+    return PyLong_FromSize_t(n);
+}
+
+PyObject* ring_read(PyRingBuffer* self, PyObject* args) {
+    Py_ssize_t max_frames = 0;
+    if (!PyArg_ParseTuple(args, "|n", &max_frames)) return nullptr;
+    size_t n = self->ring->available();
+    if (max_frames > 0) n = std::min(n, size_t(max_frames));
+    PyObject* out = PyBytes_FromStringAndSize(nullptr, Py_ssize_t(n * sizeof(float) * self->ring->channels()));
+    if (!out) return nullptr;
+    self->ring->read(reinterpret_cast<float*>(PyBytes_AS_STRING(out)), n);
+    return out;
+}
+
+PyObject* ring_available(PyRingBuffer* self, PyObject*) { return PyLong_FromSize_t(self->ring->available()); }
+
+PyObject* ring_reset(PyRingBuffer* self, PyObject*) {
+    self->ring->reset();
+    Py_RETURN_NONE;
+}
+
+PyObject* ring_discard_until(PyRingBuffer* self, PyObject* args) {
+    Py_ssize_t mark;
+    if (!PyArg_ParseTuple(args, "n", &mark)) return nullptr;
+    if (mark > 0) self->ring->discard_until(size_t(mark));
+    Py_RETURN_NONE;
+}
+
+PyObject* ring_get_written(PyRingBuffer* self, void*) { return PyLong_FromSize_t(self->ring->written()); }
+PyObject* ring_get_overflow(PyRingBuffer* self, void*) { return PyLong_FromSize_t(self->ring->overflow()); }
+PyObject* ring_get_capacity(PyRingBuffer* self, void*) { return PyLong_FromSize_t(self->ring->capacity()); }
+PyObject* ring_get_channels(PyRingBuffer* self, void*) { return PyLong_FromLong(self->ring->channels()); }
+
+PyMethodDef ring_methods[] = {
+    {"write", (PyCFunction)ring_write, METH_O, "write(buffer) -> frames，写入 float32 交错音频"},
+    {"read", (PyCFunction)ring_read, METH_VARARGS, "read(max_frames=0) -> bytes，读出至多 max_frames 帧"},
+    {"available", (PyCFunction)ring_available, METH_NOARGS, "可读取的帧数"},
+    {"reset", (PyCFunction)ring_reset, METH_NOARGS, "丢弃未读取的数据"},
+    {"discard_until", (PyCFunction)ring_discard_until, METH_VARARGS,
+     "discard_until(mark)，丢弃累计位置 mark 之前写入、尚未读取的数据"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyGetSetDef ring_getset[] = {
+    {"overflow", (getter)ring_get_overflow, nullptr, "缓冲区满时被丢弃的帧数", nullptr},
+    {"written", (getter)ring_get_written, nullptr, "累计写入的帧数", nullptr},
+    {"capacity", (getter)ring_get_capacity, nullptr, "容量（帧）", nullptr},
+    {"channels", (getter)ring_get_channels, nullptr, "声道数", nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+PyTypeObject RingBufferType = {PyVarObject_HEAD_INIT(nullptr, 0)};
+
+// ---------------- 模块 ----------------
+
+PyMethodDef module_methods[] = {
+    {"adjust_space", py_adjust_space, METH_O, "adjust_space(text) -> str，调整中英之间的空格"},
+    {"chinese_to_num", py_chinese_to_num, METH_O, "chinese_to_num(text) -> str，中文数字转阿拉伯数字"},
+    {"seam_merge", py_seam_merge, METH_VARARGS,
+     "seam_merge(prev_tail, tokens, timestamps, overlap, duration, has_prev, is_final) -> (m, n)"},
+    {"downmix_decimate", py_downmix_decimate, METH_VARARGS,
+     "downmix_decimate(buffer, channels, factor) -> bytes，多声道混为单声道并整数倍抽取"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyModuleDef module_def = {
+    PyModuleDef_HEAD_INIT, "capswriter_native", "CapsWriter 热点路径的 C++ 实现", -1, module_methods,
+};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit_capswriter_native(void) {
+    HotwordMatcherType.tp_name = "capswriter_native.HotwordMatcher";
+    HotwordMatcherType.tp_basicsize = sizeof(PyHotwordMatcher);
+    HotwordMatcherType.tp_flags = Py_TPFLAGS_DEFAULT;
+    HotwordMatcherType.tp_doc = "多模式子串匹配器";
+    HotwordMatcherType.tp_new = matcher_new;
+    HotwordMatcherType.tp_dealloc = (destructor)matcher_dealloc;
+    HotwordMatcherType.tp_methods = matcher_methods;
+    matcher_as_sequence.sq_length = (lenfunc)matcher_len;
+    HotwordMatcherType.tp_as_sequence = &matcher_as_sequence;
+
+    RingBufferType.tp_name = "capswriter_native.RingBuffer";
+    RingBufferType.tp_basicsize = sizeof(PyRingBuffer);
+    RingBufferType.tp_flags = Py_TPFLAGS_DEFAULT;
+    RingBufferType.tp_doc = "RingBuffer(frames, channels)，单生产者单消费者的 float32 环形缓冲区";
+    RingBufferType.tp_new = ring_new;
+    RingBufferType.tp_dealloc = (destructor)ring_dealloc;
+    RingBufferType.tp_methods = ring_methods;
+    RingBufferType.tp_getset = ring_getset;
+
+    if (PyType_Ready(&HotwordMatcherType) < 0 || PyType_Ready(&RingBufferType) < 0) return nullptr;
+
+    PyObject* m = PyModule_Create(&module_def);
+    if (!m) return nullptr;
+    Py_INCREF(&HotwordMatcherType);
+    Py_INCREF(&RingBufferType);
+    if (PyModule_AddObject(m, "HotwordMatcher", reinterpret_cast<PyObject*>(&HotwordMatcherType)) < 0 ||
+        PyModule_AddObject(m, "RingBuffer", reinterpret_cast<PyObject*>(&RingBufferType)) < 0) {
+        Py_DECREF(m);
+        return nullptr;
+    }
+    return m;
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+// 小型回溯匹配组合子
+//
+// 用来逐条移植 Python 端的正则，语义与 re 保持一致：贪婪量词、分组捕获、
+// 条件分组 (?(n)...)、定长后顾。每个组合子都是一个函数对象，
+// 以续延 k(pos) 串联，在编译期展开，匹配时不分配内存。
+
+#include <array>
+#include <cstddef>
+
+#include "unicode_chars.h"
+
+namespace capswriter {
+namespace pattern {
+
+struct Capture {
+    long begin = -1;
+    long end = -1;
+    bool matched() const { return begin >= 0; }
+};
+
+struct Context {
+    const char32_t* s;
+    size_t len;
+    std::array<Capture, 10> caps;
+
+    Context(const char32_t* s_, size_t len_) : s(s_), len(len_) {}
+    void reset() { caps.fill(Capture()); }
+};
+
+// 匹配一个满足谓词的字符
+template <class Pred>
+struct Char {
+    Pred pred;
+    template <class K>
+    bool operator()(Context& c, size_t pos, K&& k) const {
+        return pos < c.len && pred(c.s[pos]) && k(pos + 1);
+    }
+};
+
+template <class Pred>
+Char<Pred> chr(Pred p) { return Char<Pred>{p}; }
+
+// 匹配一段字面文本
+struct Lit {
+    const char32_t* text;
+    template <class K>
+    bool operator()(Context& c, size_t pos, K&& k) const {
+        size_t i = 0;
+        for (; text[i]; ++i)
+            if (pos + i >= c.len || c.s[pos + i] != text[i]) return false;
+        return k(pos + i);
+    }
+};
+
+struct Empty {
+    template <class K>
+    bool operator()(Context&, size_t pos, K&& k) const { return k(pos); }
+};
+
+template <class... P>
+struct Seq;
+
+template <class A>
+struct Seq<A> {
+    A a;
+    template <class K>
+    bool operator()(Context& c, size_t pos, K&& k) const { return a(c, pos, k); }
+};
+
+template <class A, class... Rest>
+struct Seq<A, Rest...> {
+    A a;
+    Seq<Rest...> rest;
+    template <class K>
+    bool operator()(Context& c, size_t pos, K&& k) const {
+        return a(c, pos, [&](size_t p) { return rest(c, p, k); });
+    }
+};
+
+template <class... P>
+Seq<P...> seq(P... p) { return Seq<P...>{p...}; }
+
+template <class... P>
+struct Alt;
+
+template <class A>
+struct Alt<A> {
+    A a;
+    template <class K>
+    bool operator()(Context& c, size_t pos, K&& k) const { return a(c, pos, k); }
+};
+
+template <class A, class... Rest>
+struct Alt<A, Rest...> {
+    A a;
+    Alt<Rest...> rest;
+    template <class K>
+    bool operator()(Context& c, size_t pos, K&& k) const {
+        return a(c, pos, k) || rest(c, pos, k);
+    }
+};
+
+template <class... P>
+Alt<P...> alt(P... p) { return Alt<P...>{p...}; }
+
+// 贪婪重复 {lo,hi}，hi < 0 表示不设上限；与 re 一样，空迭代不再继续重复
+template <class A>
+struct Repeat {
+    A a;
+    int lo;
+    int hi;
+
+    template <class K>
+    bool step(Context& c, size_t pos, int count, K& k) const {
+        if (hi < 0 || count < hi) {
+            bool ok = a(c, pos, [&](size_t p) {
+                if (p == pos && count >= lo) return false;
+                return step(c, p, count + 1, k);
+            });
+            if (ok) return true;
+        }
+        return count >= lo && k(pos);
+    }
+
+    template <class K>
+    bool operator()(Context& c, size_t pos, K&& k) const { return step(c, pos, 0, k); }
+};
+
+template <class A>
+Repeat<A> rep(A a, int lo, int hi) { return Repeat<A>{a, lo, hi}; }
+template <class A>
+Repeat<A> star(A a) { return Repeat<A>{a, 0, -1}; }
+template <class A>
+Repeat<A> plus(A a) { return Repeat<A>{a, 1, -1}; }
+template <class A>
+Repeat<A> opt(A a) { return Repeat<A>{a, 0, 1}; }
+
+// 捕获分组，回溯时恢复旧值
+template <int N, class A>
+struct Group {
+    A a;
+    template <class K>
+    bool operator()(Context& c, size_t pos, K&& k) const {
+        return a(c, pos, [&](size_t p) {
+            Capture old = c.caps[N];
+            c.caps[N] = Capture{long(pos), long(p)};
+            if (k(p)) return true;
+            c.caps[N] = old;
+            return false;
+        });
+    }
+};
+
+template <int N, class A>
+Group<N, A> group(A a) { return Group<N, A>{a}; }
+
+// 条件分组 (?(n)yes|no)
+template <int N, class Yes, class No>
+struct Cond {
+    Yes yes;
+    No no;
+    template <class K>
+    bool operator()(Context& c, size_t pos, K&& k) const {
+        return c.caps[N].matched() ? yes(c, pos, k) : no(c, pos, k);
+    }
+};
+
+template <int N, class Yes, class No>
+Cond<N, Yes, No> cond(Yes y, No n) { return Cond<N, Yes, No>{y, n}; }
+
+// 单字符后顾 (?<=[...])
+template <class Pred>
+struct Behind {
+    Pred pred;
+    template <class K>
+    bool operator()(Context& c, size_t pos, K&& k) const {
+        return pos >= 1 && pred(c.s[pos - 1]) && k(pos);
+    }
+};
+
+template <class Pred>
+Behind<Pred> behind(Pred p) { return Behind<Pred>{p}; }
+
+// 双字符后顾 (?<=[...][...])
+template <class P1, class P2>
+struct Behind2 {
+    P1 p1;
+    P2 p2;
+    template <class K>
+    bool operator()(Context& c, size_t pos, K&& k) const {
+        return pos >= 2 && p1(c.s[pos - 2]) && p2(c.s[pos - 1]) && k(pos);
+    }
+};
+
+template <class P1, class P2>
+Behind2<P1, P2> behind(P1 p1, P2 p2) { return Behind2<P1, P2>{p1, p2}; }
+
+// 字符集合谓词
+struct In {
+    const char32_t* set;
+    bool operator()(char32_t ch) const { return contains(set, ch); }
+};
+
+template <class P>
+bool fullmatch(const P& p, Context& c) {
+    c.reset();
+    return p(c, 0, [&](size_t e) { return e == c.len; });
+}
+
+template <class P>
+bool match_at(const P& p, Context& c, size_t pos, size_t& end) {
+    c.reset();
+    return p(c, pos, [&](size_t e) {
+        end = e;
+        return true;
+    });
+}
+
+}  // namespace pattern
+}  // namespace capswriter
@@ -0,0 +1,73 @@
+#include "resampler.h"
+
+#include <cmath>
+
+namespace capswriter {
+
+size_t downmix_decimate(const float* in, size_t frames, int channels, int factor, float* out) {
+    size_t n = 0;
+    if (channels == 1) {
+        for (size_t i = 0; i < frames; i += factor) out[n++] = in[i];
+        return n;
+    }
+    // numpy 对 float32 求均值时在 float32 上累加，再除以声道数
+    for (size_t i = 0; i < frames; i += factor) {
+        const float* frame = in + i * channels;
+        float sum = frame[0];
+        for (int c = 1; c < channels; ++c) sum += frame[c];
+        out[n++] = sum / float(channels);
+    }
+    return n;
+}
+
+StreamResampler::StreamResampler(int in_rate, int channels, int out_rate)
+    : in_rate_(in_rate),
+      channels_(channels),
+      out_rate_(out_rate),
+      factor_(in_rate >= out_rate && in_rate % out_rate == 0 ? in_rate / out_rate : 0) {}
+
+void StreamResampler::reset() {
+    skip_ = 0;
+    pos_ = 0;
+    last_ = 0;
+}
+
+void StreamResampler::process(const float* in, size_t frames, std::vector<float>& out) {
+    if (!frames) return;
+
+    if (factor_) {
+        if (skip_ >= frames) {
+            skip_ -= frames;
+            return;
+        }
+        size_t begin = out.size();
+        out.resize(begin + decimated_frames(frames - skip_, factor_));
+        size_t n = downmix_decimate(in + skip_ * channels_, frames - skip_, channels_, factor_, &out[begin]);
+        skip_ = skip_ + n * factor_ - frames;
+        return;
+    }
+
+    mono_.resize(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        const float* frame = in + i * channels_;
+        float sum = frame[0];
+        for (int c = 1; c < channels_; ++c) sum += frame[c];
+        mono_[i] = sum / float(channels_);
+    }
+
+    const double step = double(in_rate_) / out_rate_;
+    const double limit = double(frames - 1);
+    while (pos_ <= limit) {
+        double base = std::floor(pos_);
+        float frac = float(pos_ - base);
+        long i = long(base);
+        float a = i < 0 ? last_ : mono_[i];
+        float b = frac > 0 ? mono_[i + 1] : a;
+        out.push_back(a + (b - a) * frac);
+        pos_ += step;
+    }
+    pos_ -= double(frames);
+    last_ = mono_[frames - 1];
+}
+
+}  // namespace capswriter
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace capswriter {
+
+// 交错多声道 float32 → 单声道，按整数倍抽取
+// 与 numpy 的 np.mean(data[::factor], axis=1) 结果一致
+// 返回写入 out 的帧数，out 至少要有 ceil(frames / factor) 个位置
+size_t downmix_decimate(const float* in, size_t frames, int channels, int factor, float* out);
+
+// 输出帧数
+inline size_t decimated_frames(size_t frames, int factor) { return (frames + factor - 1) / factor; }
+
+// 流式混音重采样：交错多声道 → 单声道，输入可以分成任意长度的块
+//
+// 采样率是整数倍时按整数倍抽取（与 downmix_decimate 一致，跨块保持相位），
+// 否则线性插值。语音识别的特征提取自带低通，这两种方式对识别率都没有影响。
+class StreamResampler {
+public:
+    StreamResampler(int in_rate, int channels, int out_rate);
+
+    // 把结果追加到 out
+    void process(const float* in, size_t frames, std::vector<float>& out);
+
+    void reset();
+
+    int in_rate() const { return in_rate_; }
+    int out_rate() const { return out_rate_; }
+
+private:
+    const int in_rate_;
+    const int channels_;
+    const int out_rate_;
+    const int factor_;          // 整数倍抽取的倍数，不是整数倍时为 0
+
+    size_t skip_ = 0;           // 整数倍抽取：下一个要取的帧在下一块中的位置
+    double pos_ = 0;            // 线性插值：下一个输出点在下一块中的位置，-1~0 表示落在上一块最后一帧之后
+    float last_ = 0;
+    std::vector<float> mono_;
+};
+
+}  // namespace capswriter
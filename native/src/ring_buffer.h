@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace capswriter {
+
+// 单生产者、单消费者的 float32 环形缓冲区
+//
+// 写入端（声卡回调）只移动 head_，读取端只移动 tail_，
+// 以 acquire/release 保证数据在游标移动之前可见，无需加锁。
+// 存储在构造时一次分配，写入路径不分配内存。
+class RingBuffer {
+public:
+    RingBuffer(size_t frames, int channels)
+        : capacity_(frames), channels_(channels), data_(frames * channels) {}
+
+    size_t capacity() const { return capacity_; }
+    int channels() const { return channels_; }
+    size_t overflow() const { return overflow_.load(std::memory_order_relaxed); }
+
+    size_t available() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    // 满了就丢弃新数据，返回实际写入的帧数
+    size_t write(const float* in, size_t frames) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t free = capacity_ - (head - tail);
+        size_t n = std::min(frames, free);
+        if (n < frames) overflow_.fetch_add(frames - n, std::memory_order_relaxed);
+        if (!n) return 0;
+
+        copy_in(head % capacity_, in, n);
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // 最多读取 max_frames 帧（0 表示全部），返回读取的帧数
+    size_t read(float* out, size_t max_frames) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t n = head - tail;
+        if (max_frames) n = std::min(n, max_frames);
+        if (!n) return 0;
+
+        copy_out(tail % capacity_, out, n);
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // 累计写入的帧数，两端都可以读取，配合 discard_until 使用
+    size_t written() const { return head_.load(std::memory_order_acquire); }
+
+    // 丢弃累计位置 mark 之前写入、尚未读取的数据，之后写入的保留（由读取端调用）
+    void discard_until(size_t mark) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        mark = std::min(mark, head_.load(std::memory_order_acquire));
+        if (mark > tail) tail_.store(mark, std::memory_order_release);
+    }
+
+    // 丢弃未读取的数据（由读取端调用）
+    void reset() {
+        tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+        overflow_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    void copy_in(size_t start, const float* in, size_t n) {
+        size_t first = std::min(n, capacity_ - start);
+        std::memcpy(&data_[start * channels_], in, first * channels_ * sizeof(float));
+        if (first < n) std::memcpy(&data_[0], in + first * channels_, (n - first) * channels_ * sizeof(float));
+    }
+
+    void copy_out(size_t start, float* out, size_t n) const {
+        size_t first = std::min(n, capacity_ - start);
+        std::memcpy(out, &data_[start * channels_], first * channels_ * sizeof(float));
+        if (first < n) std::memcpy(out + first * channels_, &data_[0], (n - first) * channels_ * sizeof(float));
+    }
+
+    const size_t capacity_;
+    const int channels_;
+    std::vector<float> data_;
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+    std::atomic<size_t> overflow_{0};
+};
+
+}  // namespace capswriter
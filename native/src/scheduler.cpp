@@ -0,0 +1,134 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace capswriter {
+
+namespace {
+
+double steady_seconds() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+size_t default_batch_size() {
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores ? cores : 4;
+}
+
+}  // namespace
+
+Scheduler::Scheduler(Backend& backend, const Config& config, Clock clock)
+    : backend_(backend),
+      batch_size_(config.batch_size ? config.batch_size : default_batch_size()),
+      default_deadline_(config.partial_deadline),
+      tick_budget_(config.tick_budget),
+      clock_(clock ? std::move(clock) : Clock(steady_seconds)) {}
+
+Scheduler::~Scheduler() {
+    for (auto& e : entries_) e.session->set_deferred(false);
+}
+
+bool Scheduler::add(Session* session, double deadline) {
+    if (!session || &session->backend() != &backend_) return false;
+    for (auto& e : entries_)
+        if (e.session == session) return false;
+
+    entries_.push_back(Entry{session, deadline > 0 ? deadline : default_deadline_});
+    session->set_deferred(true);
+    return true;
+}
+
+void Scheduler::remove(Session* session) {
+    auto it = std::find_if(entries_.begin(), entries_.end(), [&](const Entry& e) { return e.session == session; });
+    if (it == entries_.end()) return;
+    session->set_deferred(false);
+    entries_.erase(it);
+}
+
+int Scheduler::tick() {
+    const double start = clock_();
+    ++ticks_;
+
+    for (auto& e : entries_) e.session->process();
+
+    int decoded = 0;
+    bool stop = false;
+    while (!stop) {
+        const double now = clock_();
+        ready_.clear();
+        for (auto& e : entries_) {
+            if (!backend_.is_ready(e.session->stream())) {
+                e.waiting = false;
+                continue;
+            }
+            if (!e.waiting) {
+                e.waiting = true;
+                e.since = now;
+            }
+            ready_.push_back(&e);
+        }
+        if (ready_.empty()) break;
+
+        // 截止时间早的先解码
+        std::stable_sort(ready_.begin(), ready_.end(),
+                         [](const Entry* a, const Entry* b) { return a->since + a->deadline < b->since + b->deadline; });
+
+        for (size_t pos = 0; pos < ready_.size(); pos += batch_size_) {
+            // 至少解一批，保证每次 tick 都有进展
+            const double t = clock_();
+            if (decoded && tick_budget_ > 0 && t - start >= tick_budget_) {
+                stop = true;
+                break;
+            }
+
+            size_t n = std::min(batch_size_, ready_.size() - pos);
+            batch_.clear();
+            for (size_t i = pos; i < pos + n; ++i) {
+                Entry* e = ready_[i];
+                double lateness = t - (e->since + e->deadline);
+                if (lateness > 0) {
+                    ++missed_;
+                    max_lateness_ = std::max(max_lateness_, lateness);
+                }
+                batch_.push_back(e->session->stream());
+                e->waiting = false;
+                e->decoded = true;
+            }
+            backend_.decode_batch(batch_.data(), n);
+            ++batches_;
+            decoded_ += n;
+            decoded += int(n);
+
+            // 端点马上切句，免得积压的下一句音频解进这一句
+            for (size_t i = pos; i < pos + n; ++i) {
+                Entry* e = ready_[i];
+                if (!e->session->at_endpoint()) continue;
+                e->session->after_decode();
+                e->decoded = false;
+            }
+        }
+    }
+
+    for (auto& e : entries_) {
+        if (!e.decoded) continue;
+        e.decoded = false;
+        e.session->after_decode();
+    }
+    return decoded;
+}
+
+cw_scheduler_stats Scheduler::stats() const {
+    cw_scheduler_stats s;
+    s.sessions = int32_t(entries_.size());
+    s.ticks = ticks_;
+    s.batches = batches_;
+    s.decoded = decoded_;
+    s.missed = missed_;
+    s.max_lateness = max_lateness_;
+    return s;
+}
+
+}  // namespace capswriter
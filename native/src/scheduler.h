@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "backend.h"
+#include "capswriter_engine.h"
+#include "session.h"
+
+namespace capswriter {
+
+// 批量调度：多个会话共用一个识别器时，把就绪的音频流凑成批一起解码
+//
+// 每次 tick：
+//     各会话处理已写入的音频，只送入识别器、不解码
+//     反复收集就绪的音频流，按截止时间（开始等待的时刻 + 会话的截止时间）排序，每 batch_size 路一批解码，
+//     直到没有就绪的音频流或超出 tick_budget
+//     每批解完检测端点，到了端点的会话马上产生最终结果并重置音频流
+//     其余解码过的会话在 tick 结束时产生中间结果
+// 一路音频流解码一次之后重新开始等待，积压多的会话不会一直占着前面的位置
+class Scheduler {
+public:
+    using Clock = std::function<double()>;      // 秒
+
+    struct Config {
+        size_t batch_size = 0;                  // 0 为 CPU 核数
+        double partial_deadline = 0.2;
+        double tick_budget = 0.05;              // 0 为不限
+    };
+
+    Scheduler(Backend& backend, const Config& config, Clock clock = Clock());
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // 会话必须使用同一个后端；deadline <= 0 时用默认值
+    bool add(Session* session, double deadline);
+    void remove(Session* session);
+
+    int tick();
+
+    cw_scheduler_stats stats() const;
+
+    size_t batch_size() const { return batch_size_; }
+
+private:
+    struct Entry {
+        Session* session;
+        double deadline;
+        bool waiting = false;       // 就绪但还没解码
+        double since = 0;           // 开始等待的时刻
+        bool decoded = false;       // 这次 tick 解码过
+    };
+
+    Backend& backend_;
+    const size_t batch_size_;
+    const double default_deadline_;
+    const double tick_budget_;
+    Clock clock_;
+
+    std::vector<Entry> entries_;
+    std::vector<Entry*> ready_;
+    std::vector<void*> batch_;
+
+    uint64_t ticks_ = 0;
+    uint64_t batches_ = 0;
+    uint64_t decoded_ = 0;
+    uint64_t missed_ = 0;
+    double max_lateness_ = 0;
+};
+
+}  // namespace capswriter
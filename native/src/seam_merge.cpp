@@ -0,0 +1,56 @@
+#include "seam_merge.h"
+
+#include <algorithm>
+
+namespace capswriter {
+
+namespace {
+
+// Python 中 a[-k:] == b[m:n][:k] 的比较
+bool same_edge(const std::vector<std::string>& prev, const std::vector<std::string>& tokens, size_t m, size_t n,
+               size_t k) {
+    size_t a_len = std::min(k, prev.size());
+    size_t b_len = m < n ? std::min(k, n - m) : 0;
+    if (a_len != b_len) return false;
+    for (size_t i = 0; i < a_len; ++i)
+        if (prev[prev.size() - a_len + i] != tokens[m + i]) return false;
+    return true;
+}
+
+}  // namespace
+
+SeamBounds seam_merge(const std::vector<std::string>& prev_tail,
+                      const std::vector<std::string>& tokens,
+                      const std::vector<double>& timestamps,
+                      double overlap,
+                      double duration,
+                      bool has_prev,
+                      bool is_final) {
+    const size_t count = timestamps.size();
+    size_t m = count, n = count;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (timestamps[i] > overlap / 2) {
+            m = i;
+            break;
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        n = i + 1;
+        if (timestamps[i] > duration - overlap / 2) break;
+    }
+    if (!has_prev) m = 0;
+    if (is_final) n = count;
+
+    // tokens 与 timestamps 一一对应，越界时按 Python 切片的方式截断
+    n = std::min(n, tokens.size());
+
+    if (!prev_tail.empty() && same_edge(prev_tail, tokens, m, n, 2))
+        m += 2;
+    else if (!prev_tail.empty() && same_edge(prev_tail, tokens, m, n, 1))
+        m += 1;
+
+    return SeamBounds{m, n};
+}
+
+}  // namespace capswriter
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace capswriter {
+
+// 片段拼接时要保留的 token 区间 [begin, end)
+struct SeamBounds {
+    size_t begin;
+    size_t end;
+};
+
+// 移植自 util/server_recognize.recognize 中的去重逻辑
+//
+// 先粗去重：依据字级时间戳，丢掉落在前后 overlap/2 之内的 token
+// 再细去重：若上一片段末尾与本片段开头有重复的字，再跳过 1~2 个
+SeamBounds seam_merge(const std::vector<std::string>& prev_tail,
+                      const std::vector<std::string>& tokens,
+                      const std::vector<double>& timestamps,
+                      double overlap,
+                      double duration,
+                      bool has_prev,
+                      bool is_final);
+
+}  // namespace capswriter
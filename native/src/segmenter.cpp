@@ -0,0 +1,103 @@
+#include "segmenter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace capswriter {
+
+EnergyVad::EnergyVad(int sample_rate, float margin_db, float floor_db)
+    : frame_(size_t(sample_rate / 50)), margin_db_(margin_db), floor_db_(floor_db) {}
+
+bool EnergyVad::is_speech(const float* samples, size_t n) {
+    size_t frames = frame_ ? n / frame_ : 0;
+    if (!frames) return false;
+
+    float loudest = -1000.0f, quiet = 1000.0f;
+    for (size_t f = 0; f < frames; ++f) {
+        const float* p = samples + f * frame_;
+        double energy = 0;
+        for (size_t i = 0; i < frame_; ++i) energy += double(p[i]) * p[i];
+        float db = 10.0f * std::log10(float(energy / frame_) + 1e-10f);
+        loudest = std::max(loudest, db);
+        quiet = std::min(quiet, db);
+    }
+
+    if (quiet < noise_db_)
+        noise_db_ = quiet;
+    else
+        noise_db_ += 0.05f * (quiet - noise_db_);
+
+    return loudest > std::max(noise_db_ + margin_db_, floor_db_);
+}
+
+namespace {
+
+size_t to_samples(float seconds, int sample_rate) { return size_t(std::lround(double(seconds) * sample_rate)); }
+
+}  // namespace
+
+Segmenter::Segmenter(const Config& config)
+    : vad_(config.sample_rate, config.margin_db, config.floor_db),
+      preroll_samples_(to_samples(config.preroll, config.sample_rate)),
+      min_speech_samples_(to_samples(config.min_speech, config.sample_rate)),
+      max_silence_samples_(to_samples(config.max_silence, config.sample_rate)),
+      max_segment_samples_(to_samples(config.max_segment, config.sample_rate)) {}
+
+void Segmenter::reset() {
+    vad_.reset();
+    preroll_.clear();
+    pending_.clear();
+    begin_.clear();
+    speaking_ = false;
+    silence_ = 0;
+    length_ = 0;
+}
+
+Segmenter::Event Segmenter::push(const float* samples, size_t n) {
+    if (speaking_) {
+        length_ += n;
+        if (vad_.is_speech(samples, n))
+            silence_ = 0;
+        else
+            silence_ += n;
+
+        if (silence_ >= max_silence_samples_ || length_ >= max_segment_samples_) {
+            speaking_ = false;
+            silence_ = 0;
+            length_ = 0;
+            return Event::End;
+        }
+        return Event::Speaking;
+    }
+
+    if (!vad_.is_speech(samples, n)) {
+        // 不连续的疑似语音当作噪声，并入预录
+        hold(pending_.data(), pending_.size());
+        pending_.clear();
+        hold(samples, n);
+        return Event::Idle;
+    }
+
+    pending_.insert(pending_.end(), samples, samples + n);
+    if (pending_.size() < min_speech_samples_) return Event::Idle;
+
+    // 确认开始说话
+    begin_.assign(preroll_.begin(), preroll_.end());
+    begin_.insert(begin_.end(), pending_.begin(), pending_.end());
+    preroll_.clear();
+    pending_.clear();
+    speaking_ = true;
+    silence_ = 0;
+    length_ = begin_.size();
+    return Event::Begin;
+}
+
+const std::vector<float>& Segmenter::take_pending() { return begin_; }
+
+void Segmenter::hold(const float* samples, size_t n) {
+    preroll_.insert(preroll_.end(), samples, samples + n);
+    if (preroll_.size() > preroll_samples_)
+        preroll_.erase(preroll_.begin(), preroll_.begin() + (preroll_.size() - preroll_samples_));
+}
+
+}  // namespace capswriter
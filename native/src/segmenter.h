@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace capswriter {
+
+// 基于能量的语音检测，与 util/client_vad.EnergyVad 一致
+//
+// 按 20ms 分帧求能量，整块中任意一帧高于阈值就算语音；
+// 底噪跟踪每块最安静的一帧：更安静时立即下调，否则缓慢上调
+class EnergyVad {
+public:
+    EnergyVad(int sample_rate, float margin_db, float floor_db);
+
+    bool is_speech(const float* samples, size_t n);
+
+    void reset() { noise_db_ = -60.0f; }
+
+    float noise_db() const { return noise_db_; }
+
+private:
+    const size_t frame_;
+    const float margin_db_;
+    const float floor_db_;
+    float noise_db_ = -60.0f;
+};
+
+// 静音切分，与 util/client_hands_free.SpeechSegmenter 一致
+//
+// 空闲时音频存入预录；连续 min_speech 秒的语音确认开始说话，连同预录一起作为这段话的开头；
+// 说话中静音超过 max_silence 秒或这段话超过 max_segment 秒，这段话结束
+class Segmenter {
+public:
+    struct Config {
+        int sample_rate = 16000;
+        float margin_db = 12.0f;
+        float floor_db = -50.0f;
+        float preroll = 0.3f;
+        float min_speech = 0.3f;
+        float max_silence = 0.8f;
+        float max_segment = 60.0f;
+    };
+
+    // 输入一块音频之后的状态
+    enum class Event {
+        Idle,       // 没有在说话，这块存入预录或待确认
+        Begin,      // 开始说话，用 take_pending 取出这段话开头的音频（包括这块）
+        Speaking,   // 这块属于正在说的这段话
+        End,        // 这块属于这段话，这段话到此结束
+    };
+
+    explicit Segmenter(const Config& config);
+
+    Event push(const float* samples, size_t n);
+
+    // Begin 之后取出预录和已确认的语音
+    const std::vector<float>& take_pending();
+
+    bool speaking() const { return speaking_; }
+
+    void reset();
+
+private:
+    void hold(const float* samples, size_t n);
+
+    EnergyVad vad_;
+    const size_t preroll_samples_;
+    const size_t min_speech_samples_;
+    const size_t max_silence_samples_;
+    const size_t max_segment_samples_;
+
+    std::deque<float> preroll_;
+    std::vector<float> pending_;    // 疑似语音，还不够 min_speech 长
+    std::vector<float> begin_;
+    bool speaking_ = false;
+    size_t silence_ = 0;            // 这段话末尾连续静音的采样数
+    size_t length_ = 0;             // 这段话的采样数
+};
+
+}  // namespace capswriter
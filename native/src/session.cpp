@@ -0,0 +1,205 @@
+#include "session.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "utf8.h"
+
+namespace capswriter {
+
+namespace {
+
+Segmenter::Config segmenter_config(const cw_session_config& c) {
+    Segmenter::Config s;
+    s.sample_rate = c.sample_rate;
+    s.margin_db = c.vad_energy_margin;
+    s.floor_db = c.vad_energy_floor;
+    s.preroll = c.preroll;
+    s.min_speech = c.min_speech;
+    s.max_silence = c.max_silence;
+    s.max_segment = c.max_segment;
+    return s;
+}
+
+}  // namespace
+
+Session::Session(Backend& backend, const cw_session_config& config)
+    : backend_(backend),
+      config_(config),
+      ring_(std::max<size_t>(1, size_t(config.ring_seconds * config.input_sample_rate)), config.input_channels),
+      resampler_(config.input_sample_rate, config.input_channels, config.sample_rate),
+      segmenter_(segmenter_config(config)),
+      block_(size_t(config.sample_rate / 10)) {
+    stream_ = backend_.create_stream();
+}
+
+Session::~Session() {
+    if (stream_) backend_.destroy_stream(stream_);
+}
+
+int Session::process() {
+    size_t before = queue_.size();
+
+    size_t frames = ring_.available();
+    if (!frames) return 0;
+    input_.resize(frames * config_.input_channels);
+    frames = ring_.read(input_.data(), frames);
+
+    mono_.clear();
+    resampler_.process(input_.data(), frames, mono_);
+    handle(mono_.data(), mono_.size());
+
+    return int(queue_.size() - before);
+}
+
+void Session::handle(const float* samples, size_t n) {
+    if (!config_.segment) {
+        processed_ += n;
+        feed(samples, n);
+        return;
+    }
+
+    // 静音切分按固定长度的块判断，与客户端按录音批次判断的效果相当
+    carry_.insert(carry_.end(), samples, samples + n);
+    size_t pos = 0;
+    for (; pos + block_ <= carry_.size(); pos += block_) {
+        const float* block = carry_.data() + pos;
+        processed_ += block_;
+        switch (segmenter_.push(block, block_)) {
+            case Segmenter::Event::Idle:
+                break;
+            case Segmenter::Event::Begin: {
+                const auto& head = segmenter_.take_pending();
+                sentence_start_ = processed_ - head.size();
+                feed(head.data(), head.size());
+                break;
+            }
+            case Segmenter::Event::Speaking:
+                feed(block, block_);
+                break;
+            case Segmenter::Event::End:
+                feed(block, block_);
+                end_sentence();
+                break;
+        }
+    }
+    carry_.erase(carry_.begin(), carry_.begin() + pos);
+}
+
+void Session::feed(const float* samples, size_t n) {
+    if (!n) return;
+    backend_.accept_waveform(stream_, config_.sample_rate, samples, n);
+    fed_ += n;
+    if (deferred_) return;
+
+    bool decoded = false;
+    while (backend_.is_ready(stream_)) {
+        backend_.decode(stream_);
+        decoded = true;
+    }
+    if (decoded) after_decode();
+}
+
+void Session::after_decode() {
+    backend_.get_result(stream_, result_);
+    if (!result_.text.empty() && result_.text != last_text_) {
+        last_text_ = result_.text;
+        emit(false, result_);
+    }
+
+    if (config_.use_endpoint && backend_.is_endpoint(stream_)) {
+        emit(true, result_);
+        backend_.reset(stream_);
+        sentence_start_ += fed_;
+        fed_ = 0;
+        last_text_.clear();
+    }
+}
+
+void Session::end_sentence() {
+    if (fed_) {
+        // 补一段静音，让最后几个字拿到右侧上下文
+        std::vector<float> padding(size_t(config_.tail_padding * config_.sample_rate), 0.0f);
+        if (!padding.empty()) backend_.accept_waveform(stream_, config_.sample_rate, padding.data(), padding.size());
+        backend_.input_finished(stream_);
+        while (backend_.is_ready(stream_)) backend_.decode(stream_);
+
+        backend_.get_result(stream_, result_);
+        emit(true, result_);
+
+        // 结束输入的流 reset 之后也不能再接收音频，换一个新的
+        renew_stream();
+    } else {
+        backend_.reset(stream_);
+    }
+    sentence_start_ = processed_;
+    fed_ = 0;
+    last_text_.clear();
+}
+
+void Session::renew_stream() {
+    void* stream = backend_.create_stream();
+    if (!stream) throw std::runtime_error("create_stream failed");
+    backend_.destroy_stream(stream_);
+    stream_ = stream;
+}
+
+void Session::emit(bool is_final, Backend::Result& result) {
+    if (is_final && result.text.empty()) return;
+
+    Stored item{is_final, index_, double(sentence_start_) / config_.sample_rate, result.text, result.timestamps};
+    if (is_final) {
+        if (pipeline_) item.text = u32_to_utf8(pipeline_->process(utf8_to_u32(item.text)));
+        ++index_;
+    }
+    queue_.push_back(std::move(item));
+}
+
+int Session::finish() {
+    size_t before = queue_.size();
+    process();
+
+    // 不够一块的尾巴：正在说话时属于这段话
+    if (config_.segment) {
+        if (segmenter_.speaking()) {
+            processed_ += carry_.size();
+            feed(carry_.data(), carry_.size());
+        } else {
+            processed_ += carry_.size();
+        }
+        carry_.clear();
+        segmenter_.reset();
+    }
+    end_sentence();
+    return int(queue_.size() - before);
+}
+
+void Session::reset() {
+    ring_.reset();
+    resampler_.reset();
+    segmenter_.reset();
+    backend_.reset(stream_);
+    carry_.clear();
+    queue_.clear();
+    processed_ = 0;
+    sentence_start_ = 0;
+    fed_ = 0;
+    index_ = 0;
+    last_text_.clear();
+}
+
+bool Session::poll(cw_result& out) {
+    if (queue_.empty()) return false;
+    current_ = std::move(queue_.front());
+    queue_.pop_front();
+
+    out.is_final = current_.is_final ? 1 : 0;
+    out.index = current_.index;
+    out.start = current_.start;
+    out.text = current_.text.c_str();
+    out.timestamps = current_.timestamps.empty() ? nullptr : current_.timestamps.data();
+    out.count = int32_t(current_.timestamps.size());
+    return true;
+}
+
+}  // namespace capswriter
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "backend.h"
+#include "capswriter_engine.h"
+#include "resampler.h"
+#include "ring_buffer.h"
+#include "segmenter.h"
+#include "text_pipeline.h"
+
+namespace capswriter {
+
+// 一路识别会话
+//
+// 与 Mac 客户端 SherpaASRService 和 Python 客户端免提模式的流程一致：
+//     写入端（音频回调）只写环形缓冲；
+//     处理线程取出音频，混音重采样到识别器的采样率，
+//     静音切分模式下只把语音段送入识别器，否则全部送入；
+//     每次解码后文字有变化就产生中间结果；识别器检测到端点、
+//     一段语音结束或调用 finish 时补尾部静音解完，产生最终结果并换一个新的音频流（结束输入的流不能再接收音频）
+class Session {
+public:
+    Session(Backend& backend, const cw_session_config& config);
+    ~Session();
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    bool valid() const { return stream_ != nullptr; }
+
+    void set_text_pipeline(TextPipeline* pipeline) { pipeline_ = pipeline; }
+
+    size_t write(const float* samples, size_t frames) { return ring_.write(samples, frames); }
+
+    int process();
+    int finish();
+    void reset();
+
+    bool poll(cw_result& out);
+
+    uint64_t overflow() const { return ring_.overflow(); }
+
+    // 由调度器批量解码（见 scheduler.h）：送入音频后不再自己解码，
+    // 调度器解码之后调用 after_decode 产生中间结果、检测端点；收尾时仍由会话自己解完
+    void set_deferred(bool deferred) { deferred_ = deferred; }
+    void after_decode();
+    bool at_endpoint() const { return config_.use_endpoint && backend_.is_endpoint(stream_); }
+
+    Backend& backend() const { return backend_; }
+    void* stream() const { return stream_; }
+
+private:
+    struct Stored {
+        bool is_final;
+        int index;
+        double start;
+        std::string text;
+        std::vector<float> timestamps;
+    };
+
+    void handle(const float* samples, size_t n);
+    void feed(const float* samples, size_t n);
+    void end_sentence();
+    void renew_stream();
+    void emit(bool is_final, Backend::Result& result);
+
+    Backend& backend_;
+    const cw_session_config config_;
+    void* stream_ = nullptr;
+    TextPipeline* pipeline_ = nullptr;
+    bool deferred_ = false;
+
+    RingBuffer ring_;
+    StreamResampler resampler_;
+    Segmenter segmenter_;
+    const size_t block_;                // 静音切分每次判断的采样数
+
+    std::vector<float> input_;          // 从环形缓冲取出的交错音频
+    std::vector<float> mono_;           // 重采样后的音频
+    std::vector<float> carry_;          // 不够一块、留到下次的音频
+
+    uint64_t processed_ = 0;            // 会话中已处理的采样数（识别器采样率）
+    uint64_t sentence_start_ = 0;       // 当前这句在会话中的起始采样
+    size_t fed_ = 0;                    // 当前这句已送入识别器的采样数
+    int index_ = 0;
+    std::string last_text_;
+    Backend::Result result_;
+
+    std::deque<Stored> queue_;
+    Stored current_;
+};
+
+}  // namespace capswriter
@@ -0,0 +1,72 @@
+#include "backend.h"
+
+// sherpa-onnx 的在线识别器，只在启用 CAPSWRITER_WITH_SHERPA 时编译进来，
+// c-api.h 与 Mac 客户端使用同一份（CapsWriter-mac/CapsWriter-mac/Include）
+
+#ifdef CAPSWRITER_WITH_SHERPA
+
+#include "c-api.h"
+
+namespace capswriter {
+
+namespace {
+
+class SherpaBackend : public Backend {
+public:
+    explicit SherpaBackend(const SherpaOnnxOnlineRecognizer* recognizer) : recognizer_(recognizer) {}
+
+    void* create_stream() override { return const_cast<SherpaOnnxOnlineStream*>(SherpaOnnxCreateOnlineStream(recognizer_)); }
+
+    void destroy_stream(void* stream) override { SherpaOnnxDestroyOnlineStream(s(stream)); }
+
+    void accept_waveform(void* stream, int sample_rate, const float* samples, size_t n) override {
+        SherpaOnnxOnlineStreamAcceptWaveform(s(stream), sample_rate, samples, int32_t(n));
+    }
+
+    void input_finished(void* stream) override { SherpaOnnxOnlineStreamInputFinished(s(stream)); }
+    bool is_ready(void* stream) override { return SherpaOnnxIsOnlineStreamReady(recognizer_, s(stream)) == 1; }
+    void decode(void* stream) override { SherpaOnnxDecodeOnlineStream(recognizer_, s(stream)); }
+
+    void decode_batch(void* const* streams, size_t n) override {
+        std::vector<const SherpaOnnxOnlineStream*> batch(n);
+        for (size_t i = 0; i < n; ++i) batch[i] = s(streams[i]);
+        SherpaOnnxDecodeMultipleOnlineStreams(recognizer_, batch.data(), int32_t(n));
+    }
+    bool is_endpoint(void* stream) override { return SherpaOnnxOnlineStreamIsEndpoint(recognizer_, s(stream)) == 1; }
+    void reset(void* stream) override { SherpaOnnxOnlineStreamReset(recognizer_, s(stream)); }
+
+    void get_result(void* stream, Result& out) override {
+        out.text.clear();
+        out.timestamps.clear();
+        const SherpaOnnxOnlineRecognizerResult* r = SherpaOnnxGetOnlineStreamResult(recognizer_, s(stream));
+        if (!r) return;
+        if (r->text) out.text = r->text;
+        // 没有时间戳信息时 timestamps 为 NULL
+        if (r->timestamps && r->count > 0) out.timestamps.assign(r->timestamps, r->timestamps + r->count);
+        SherpaOnnxDestroyOnlineRecognizerResult(r);
+    }
+
+private:
+    static const SherpaOnnxOnlineStream* s(void* stream) { return static_cast<const SherpaOnnxOnlineStream*>(stream); }
+
+    const SherpaOnnxOnlineRecognizer* recognizer_;
+};
+
+}  // namespace
+
+std::unique_ptr<Backend> make_sherpa_backend(const SherpaOnnxOnlineRecognizer* recognizer) {
+    if (!recognizer) return nullptr;
+    return std::unique_ptr<Backend>(new SherpaBackend(recognizer));
+}
+
+}  // namespace capswriter
+
+#else
+
+namespace capswriter {
+
+std::unique_ptr<Backend> make_sherpa_backend(const SherpaOnnxOnlineRecognizer*) { return nullptr; }
+
+}  // namespace capswriter
+
+#endif
@@ -0,0 +1,153 @@
+#include "spacing.h"
+
+#include "unicode_chars.h"
+
+// 移植自 util/format_tools.py，逐条对应其中的正则：
+//
+//   ([一-龥]|[a-z0-9]+\s)?    左侧：一个汉字，或者英文数字加一个空白
+//   ([a-z0-9 ]+)                      中间：英文数字和空格
+//   ([一-龥]|[a-z0-9]+)?      右侧：一个汉字（中间已贪婪吃掉了英文数字）
+//
+// 这个模式的回溯情形有限，直接按位置展开，线性扫描即可
+
+namespace capswriter {
+
+namespace {
+
+// (?i)[a-z0-9]
+bool is_alnum(char32_t c) { return is_letter_ignorecase(c) || is_ascii_digit(c); }
+
+// (?i)[a-z0-9 ]
+bool is_center(char32_t c) { return is_alnum(c) || c == U' '; }
+
+// 在中间部分里，字符只有字母、数字和空格，\w 就是非空格
+bool is_word(char32_t c) { return c != U' '; }
+
+bool has_digit_edge(const std::u32string& s, bool left, bool right) {
+    if (s.empty()) return false;
+    return (left && is_ascii_digit(s.front())) || (right && is_ascii_digit(s.back()));
+}
+
+std::u32string strip_space(const std::u32string& s, bool left, bool right) {
+    size_t b = 0, e = s.size();
+    if (left)
+        while (b < e && is_space(s[b])) ++b;
+    if (right)
+        while (e > b && is_space(s[e - 1])) --e;
+    return s.substr(b, e - b);
+}
+
+// re.sub(r'((\d) )?(\b\w) ?(?!\w{2})', r'\2\3', center)
+// 去掉单个字母之间的空格，比如 "c d r o m" 变成 "cdrom"
+std::u32string join_letters(const std::u32string& s) {
+    const size_t n = s.size();
+    auto word_at = [&](size_t i) { return i < n && is_word(s[i]); };
+    auto boundary = [&](size_t i) { return (i > 0 && is_word(s[i - 1])) != word_at(i); };
+
+    // 在 k 处尝试 " ?(?!\w{2})"，成功返回匹配结尾
+    auto tail = [&](size_t k, size_t& end) {
+        if (k < n && s[k] == U' ' && !(word_at(k + 1) && word_at(k + 2))) {
+            end = k + 1;
+            return true;
+        }
+        if (!(word_at(k) && word_at(k + 1))) {
+            end = k;
+            return true;
+        }
+        return false;
+    };
+
+    std::u32string out;
+    size_t i = 0;
+    while (i < n) {
+        size_t end;
+        // 带数字前缀的情形：(\d) 空格，然后是单词开头
+        if (is_ascii_digit(s[i]) && i + 1 < n && s[i + 1] == U' ' && boundary(i + 2) && word_at(i + 2) &&
+            tail(i + 3, end)) {
+            out += s[i];
+            out += s[i + 2];
+            i = end;
+            continue;
+        }
+        if (boundary(i) && word_at(i) && tail(i + 1, end)) {
+            out += s[i];
+            i = end;
+            continue;
+        }
+        out += s[i];
+        ++i;
+    }
+    return out;
+}
+
+}  // namespace
+
+std::u32string adjust_space(const std::u32string& text) {
+    const size_t n = text.size();
+    std::u32string out;
+    out.reserve(n + n / 8);
+
+    size_t p = 0;
+    while (p < n) {
+        // 依次尝试左侧分组的三种情形
+        size_t left_end = p;        // 左侧分组的结尾，等于 p 表示没有左侧
+        bool matched = false;
+        size_t center_begin = p;
+
+        if (is_cjk(text[p])) {
+            if (p + 1 < n && is_center(text[p + 1])) {
+                left_end = p + 1;
+                matched = true;
+            }
+        } else if (is_alnum(text[p]) || text[p] == U' ') {
+            if (is_alnum(text[p])) {
+                size_t q = p;
+                while (q < n && is_alnum(text[q])) ++q;
+                if (q < n && is_space(text[q]) && q + 1 < n && is_center(text[q + 1])) left_end = q + 1;
+            }
+            matched = true;
+        }
+
+        if (!matched) {
+            out += text[p];
+            ++p;
+            continue;
+        }
+
+        center_begin = left_end;
+        size_t center_end = center_begin;
+        while (center_end < n && is_center(text[center_end])) ++center_end;
+
+        // 右侧：中间已吃掉所有英文数字，只可能是一个汉字
+        size_t right_end = center_end;
+        if (center_end < n && is_cjk(text[center_end])) right_end = center_end + 1;
+
+        std::u32string left = text.substr(p, left_end - p);
+        std::u32string center = text.substr(center_begin, center_end - center_begin);
+        std::u32string right = text.substr(center_end, right_end - center_end);
+
+        std::u32string final_ = strip_space(join_letters(center), true, true);
+
+        if (!left.empty()) {
+            // left.strip(digits) == left and center.lstrip(digits) == center
+            if (!has_digit_edge(left, true, true) && !has_digit_edge(center, true, false))
+                final_ = U" " + final_;
+            final_ = strip_space(left, false, true) + final_;
+        } else {
+            // Python 中 start(2) 为 0 时，string[-1] 取到的是最后一个字符
+            char32_t before = center_begin > 0 ? text[center_begin - 1] : text[n - 1];
+            if (is_cjk(before) && !has_digit_edge(center, true, false)) final_ = U" " + final_;
+        }
+
+        if (!right.empty()) {
+            if (!has_digit_edge(center, false, true)) final_ += U' ';
+            final_ += strip_space(right, true, false);
+        }
+
+        out += final_;
+        p = right_end;
+    }
+    return out;
+}
+
+}  // namespace capswriter
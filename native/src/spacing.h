@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+namespace capswriter {
+
+// 调整中英文之间的空格，与 util/format_tools.adjust_space 行为一致
+std::u32string adjust_space(const std::u32string& text);
+
+}  // namespace capswriter
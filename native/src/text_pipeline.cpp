@@ -0,0 +1,130 @@
+#include "text_pipeline.h"
+
+#include <algorithm>
+
+#include "chinese_itn.h"
+#include "spacing.h"
+#include "unicode_chars.h"
+
+namespace capswriter {
+
+namespace {
+
+char32_t lower(char32_t c) { return (c >= U'A' && c <= U'Z') ? c + 32 : c; }
+
+// re 中的 \w：这里只需要区分英文标点，非 ASCII 字符都算
+bool is_word_char(char32_t c) { return c >= 0x80 || is_ascii_letter(c) || is_ascii_digit(c) || c == U'_'; }
+
+struct Span {
+    size_t begin;
+    size_t end;
+    int id;
+};
+
+// 从匹配位置中挑出最左最长、互不重叠的一组
+std::vector<Span> pick(std::vector<Span> spans) {
+    std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) {
+        return a.begin != b.begin ? a.begin < b.begin : a.end > b.end;
+    });
+    std::vector<Span> out;
+    size_t covered = 0;
+    for (const Span& s : spans) {
+        if (s.begin < covered) continue;
+        out.push_back(s);
+        covered = s.end;
+    }
+    return out;
+}
+
+std::u32string apply(const std::u32string& text, const std::vector<Span>& spans,
+                     const std::vector<std::u32string>& replacements) {
+    std::u32string out;
+    out.reserve(text.size());
+    size_t pos = 0;
+    for (const Span& s : spans) {
+        out.append(text, pos, s.begin - pos);
+        out += replacements[s.id];
+        pos = s.end;
+    }
+    out.append(text, pos, std::u32string::npos);
+    return out;
+}
+
+}  // namespace
+
+void TextPipeline::add_hotword(const std::u32string& hotword) {
+    std::u32string key;
+    for (char32_t c : hotword)
+        if (is_word_char(c)) key.push_back(lower(c));
+    if (key.empty()) return;
+    hotword_matcher_.add(key);
+    hotwords_.push_back(hotword);
+}
+
+void TextPipeline::add_rule(const std::u32string& from, const std::u32string& to) {
+    if (from.empty()) return;
+    rule_matcher_.add(from);
+    replacements_.push_back(to);
+}
+
+void TextPipeline::clear() {
+    hotword_matcher_.clear();
+    hotwords_.clear();
+    rule_matcher_.clear();
+    replacements_.clear();
+}
+
+std::u32string TextPipeline::replace_hotwords(const std::u32string& text) {
+    if (hotwords_.empty()) return text;
+
+    // 在去掉空格的小写文本上匹配，记下每个字在原文中的位置
+    std::u32string folded;
+    std::vector<size_t> origin;
+    folded.reserve(text.size());
+    origin.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == U' ') continue;
+        folded.push_back(lower(text[i]));
+        origin.push_back(i);
+    }
+
+    std::vector<Span> spans;
+    for (const auto& hit : hotword_matcher_.locate(folded)) {
+        size_t begin = origin[hit.first];
+        size_t end = origin[hit.first + hotword_matcher_.length(hit.second) - 1] + 1;
+        // 两侧不能紧接英文字母，避免替换单词的一部分
+        if (begin > 0 && is_ascii_letter(text[begin - 1])) continue;
+        if (end < text.size() && is_ascii_letter(text[end])) continue;
+        spans.push_back(Span{begin, end, hit.second});
+    }
+    return apply(text, pick(std::move(spans)), hotwords_);
+}
+
+std::u32string TextPipeline::replace_rules(const std::u32string& text) {
+    if (replacements_.empty()) return text;
+
+    std::vector<Span> spans;
+    for (const auto& hit : rule_matcher_.locate(text))
+        spans.push_back(Span{hit.first, hit.first + rule_matcher_.length(hit.second), hit.second});
+    return apply(text, pick(std::move(spans)), replacements_);
+}
+
+std::u32string TextPipeline::process(const std::u32string& text) {
+    std::u32string out = text;
+    if (options_.spacing) out = adjust_space(out);
+    if (options_.itn) {
+        try {
+            out = chinese_to_num(out);
+        } catch (const ItnOverflow&) {
+            // 超出范围的数字保持原样
+        }
+    }
+    if (options_.spacing) out = adjust_space(out);
+    if (options_.hotwords) {
+        out = replace_hotwords(out);
+        out = replace_rules(out);
+    }
+    return out;
+}
+
+}  // namespace capswriter
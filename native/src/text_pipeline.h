@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "hotword.h"
+
+namespace capswriter {
+
+// 识别结果的文本管线，客户端和服务端共用一份实现
+//
+// 顺序与服务端 format_text、客户端 hot_sub 一致：
+//     调空格 → 中文数字转阿拉伯数字 → 调空格 → 英文热词 → 字面替换规则
+// 加标点需要模型，由调用方在管线之前完成；中文热词按拼音匹配，需要拼音词典，仍由 Python 端处理
+class TextPipeline {
+public:
+    struct Options {
+        bool spacing = true;
+        bool itn = true;
+        bool hotwords = true;
+    };
+
+    explicit TextPipeline(const Options& options) : options_(options) {}
+
+    // 英文热词：忽略大小写和词内空格匹配，与 util/hot_sub_en 一致
+    void add_hotword(const std::u32string& hotword);
+
+    // 字面替换规则
+    void add_rule(const std::u32string& from, const std::u32string& to);
+
+    void clear();
+
+    std::u32string process(const std::u32string& text);
+
+    // 以下两步单独公开，便于测试
+    std::u32string replace_hotwords(const std::u32string& text);
+    std::u32string replace_rules(const std::u32string& text);
+
+private:
+    Options options_;
+
+    HotwordMatcher hotword_matcher_;
+    std::vector<std::u32string> hotwords_;      // 与匹配器中的模式编号一一对应
+
+    HotwordMatcher rule_matcher_;
+    std::vector<std::u32string> replacements_;
+};
+
+}  // namespace capswriter
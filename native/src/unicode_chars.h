@@ -0,0 +1,32 @@
+#pragma once
+
+// 与 Python re / str 方法一致的字符分类，只覆盖本模块用到的部分
+
+namespace capswriter {
+
+// str.isspace()，也是 re 中 \s 匹配的字符
+inline bool is_space(char32_t c) {
+    return (c >= 0x09 && c <= 0x0D) || (c >= 0x1C && c <= 0x20) || c == 0x85 || c == 0xA0 ||
+           c == 0x1680 || (c >= 0x2000 && c <= 0x200A) || c == 0x2028 || c == 0x2029 ||
+           c == 0x202F || c == 0x205F || c == 0x3000;
+}
+
+inline bool is_ascii_digit(char32_t c) { return c >= U'0' && c <= U'9'; }
+
+inline bool is_ascii_letter(char32_t c) { return (c >= U'a' && c <= U'z') || (c >= U'A' && c <= U'Z'); }
+
+// 忽略大小写时 [a-z] 匹配的字符：除了 ASCII 字母，还有 İ ı ſ K 四个
+inline bool is_letter_ignorecase(char32_t c) {
+    return is_ascii_letter(c) || c == 0x130 || c == 0x131 || c == 0x17F || c == 0x212A;
+}
+
+// 正则中的 [一-龥]
+inline bool is_cjk(char32_t c) { return c >= 0x4E00 && c <= 0x9FA5; }
+
+inline bool contains(const char32_t* set, char32_t c) {
+    for (; *set; ++set)
+        if (*set == c) return true;
+    return false;
+}
+
+}  // namespace capswriter
@@ -0,0 +1,68 @@
+#pragma once
+
+// UTF-8 与 UTF-32 互转，C 接口的字符串都是 UTF-8，文本处理在 UTF-32 上进行
+// 非法字节按 U+FFFD 处理，与 Python 的 errors='replace' 一致
+
+#include <string>
+
+namespace capswriter {
+
+inline std::u32string utf8_to_u32(const char* s, size_t len) {
+    std::u32string out;
+    out.reserve(len);
+    const auto* p = reinterpret_cast<const unsigned char*>(s);
+    size_t i = 0;
+    while (i < len) {
+        unsigned char c = p[i];
+        int extra = c < 0x80 ? 0 : (c >> 5) == 0x6 ? 1 : (c >> 4) == 0xE ? 2 : (c >> 3) == 0x1E ? 3 : -1;
+        if (extra < 0 || i + extra >= len) {
+            out.push_back(0xFFFD);
+            ++i;
+            continue;
+        }
+        char32_t cp = extra ? c & (0x3F >> extra) : c;
+        bool ok = true;
+        for (int k = 1; k <= extra; ++k) {
+            if ((p[i + k] & 0xC0) != 0x80) {
+                ok = false;
+                break;
+            }
+            cp = (cp << 6) | (p[i + k] & 0x3F);
+        }
+        if (!ok) {
+            out.push_back(0xFFFD);
+            ++i;
+            continue;
+        }
+        out.push_back(cp);
+        i += extra + 1;
+    }
+    return out;
+}
+
+inline std::u32string utf8_to_u32(const std::string& s) { return utf8_to_u32(s.data(), s.size()); }
+
+inline std::string u32_to_utf8(const std::u32string& s) {
+    std::string out;
+    out.reserve(s.size() * 3);
+    for (char32_t c : s) {
+        if (c < 0x80) {
+            out.push_back(char(c));
+        } else if (c < 0x800) {
+            out.push_back(char(0xC0 | (c >> 6)));
+            out.push_back(char(0x80 | (c & 0x3F)));
+        } else if (c < 0x10000) {
+            out.push_back(char(0xE0 | (c >> 12)));
+            out.push_back(char(0x80 | ((c >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (c & 0x3F)));
+        } else {
+            out.push_back(char(0xF0 | (c >> 18)));
+            out.push_back(char(0x80 | ((c >> 12) & 0x3F)));
+            out.push_back(char(0x80 | ((c >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (c & 0x3F)));
+        }
+    }
+    return out;
+}
+
+}  // namespace capswriter
@@ -0,0 +1,47 @@
+#pragma once
+
+// 测试用的最小断言，失败时打印位置并计数，main 返回失败数
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace check {
+
+inline int& failures() {
+    static int n = 0;
+    return n;
+}
+
+inline void fail(const char* file, int line, const std::string& message) {
+    std::fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+    ++failures();
+}
+
+}  // namespace check
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) check::fail(__FILE__, __LINE__, "CHECK(" #cond ") failed"); \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        if (!((a) == (b))) check::fail(__FILE__, __LINE__, "CHECK_EQ(" #a ", " #b ") failed"); \
+    } while (0)
+
+#define CHECK_NEAR(a, b, eps) \
+    do { \
+        if (std::fabs(double(a) - double(b)) > (eps)) \
+            check::fail(__FILE__, __LINE__, \
+                        "CHECK_NEAR(" #a ", " #b ") failed: " + std::to_string(double(a)) + " vs " + \
+                            std::to_string(double(b))); \
+    } while (0)
+
+#define TEST_MAIN(...) \
+    int main() { \
+        void (*tests[])() = {__VA_ARGS__}; \
+        for (auto test : tests) test(); \
+        if (check::failures()) std::fprintf(stderr, "%d check(s) failed\n", check::failures()); \
+        return check::failures() ? 1 : 0; \
+    }
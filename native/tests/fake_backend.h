@@ -0,0 +1,102 @@
+#pragma once
+
+// 测试用的模拟识别器，通过 cw_backend 回调接入引擎
+//
+// 每 0.1 秒音频解码一次，这 0.1 秒有声音就输出一个 a；
+// 识别出字之后连续 1 秒静音算作端点；结束输入之后再送入音频会报错
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "capswriter_engine.h"
+#include "check.h"
+
+namespace {
+
+const int kBlock = 1600;
+
+struct FakeStream {
+    std::vector<float> pending;
+    bool finished = false;
+    std::string text;
+    std::vector<float> timestamps;
+    int decoded = 0;
+    int trailing_silence = 0;
+};
+
+struct Fake {
+    int streams = 0;
+    int accepted = 0;
+    std::vector<int> batches;       // decode_multiple 每次的路数
+};
+
+FakeStream* fs(void* s) { return static_cast<FakeStream*>(s); }
+
+cw_backend fake_backend(Fake* fake) {
+    cw_backend b{};
+    b.user = fake;
+    b.create_stream = [](void* user) -> void* {
+        ++static_cast<Fake*>(user)->streams;
+        return new FakeStream();
+    };
+    b.destroy_stream = [](void* user, void* s) {
+        --static_cast<Fake*>(user)->streams;
+        delete fs(s);
+    };
+    b.accept_waveform = [](void* user, void* s, int32_t sample_rate, const float* samples, int32_t n) {
+        CHECK_EQ(sample_rate, 16000);
+        // 与 sherpa-onnx 一致：结束输入的流不能再接收音频
+        CHECK(!fs(s)->finished);
+        static_cast<Fake*>(user)->accepted += n;
+        fs(s)->pending.insert(fs(s)->pending.end(), samples, samples + n);
+    };
+    b.input_finished = [](void*, void* s) { fs(s)->finished = true; };
+    b.is_ready = [](void*, void* s) -> int32_t {
+        FakeStream* st = fs(s);
+        return st->pending.size() >= size_t(kBlock) || (st->finished && !st->pending.empty());
+    };
+    b.decode = [](void*, void* s) {
+        FakeStream* st = fs(s);
+        size_t n = std::min(st->pending.size(), size_t(kBlock));
+        float peak = 0;
+        for (size_t i = 0; i < n; ++i) peak = std::max(peak, std::abs(st->pending[i]));
+        st->pending.erase(st->pending.begin(), st->pending.begin() + n);
+        if (peak > 0.01f) {
+            st->text += "a";
+            st->timestamps.push_back(st->decoded * 0.1f);
+            st->trailing_silence = 0;
+        } else {
+            ++st->trailing_silence;
+        }
+        ++st->decoded;
+    };
+    b.is_endpoint = [](void*, void* s) -> int32_t {
+        return !fs(s)->text.empty() && fs(s)->trailing_silence >= 10;
+    };
+    // reset 不清除结束输入的状态
+    b.reset = [](void*, void* s) {
+        bool finished = fs(s)->finished;
+        *fs(s) = FakeStream();
+        fs(s)->finished = finished;
+    };
+    b.get_result = [](void*, void* s, const float** timestamps, int32_t* count) -> const char* {
+        *timestamps = fs(s)->timestamps.empty() ? nullptr : fs(s)->timestamps.data();
+        *count = int32_t(fs(s)->timestamps.size());
+        return fs(s)->text.c_str();
+    };
+    return b;
+}
+
+// 交错的多声道音频
+std::vector<float> audio(double seconds, int rate, int channels, bool speech) {
+    size_t frames = size_t(seconds * rate);
+    std::vector<float> s(frames * channels, 0.0f);
+    if (speech)
+        for (size_t i = 0; i < frames; ++i)
+            for (int c = 0; c < channels; ++c) s[i * channels + c] = (i / 8) % 2 ? 0.1f : -0.1f;
+    return s;
+}
+
+}  // namespace
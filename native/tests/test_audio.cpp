@@ -0,0 +1,125 @@
+// 音频：环形缓冲、重采样、能量检测和静音切分
+
+#include <vector>
+
+#include "check.h"
+#include "resampler.h"
+#include "ring_buffer.h"
+#include "segmenter.h"
+
+using namespace capswriter;
+
+namespace {
+
+std::vector<float> tone(size_t n, float amplitude) {
+    std::vector<float> s(n);
+    for (size_t i = 0; i < n; ++i) s[i] = (i % 16 < 8 ? amplitude : -amplitude);
+    return s;
+}
+
+void test_ring_buffer() {
+    RingBuffer ring(8, 2);
+    float in[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    CHECK_EQ(ring.write(in, 6), 6u);
+    float out[16];
+    CHECK_EQ(ring.read(out, 4), 4u);
+    CHECK_EQ(out[7], 7.0f);
+    // 绕回
+    CHECK_EQ(ring.write(in, 6), 6u);
+    CHECK_EQ(ring.available(), 8u);
+    CHECK_EQ(ring.write(in, 1), 0u);
+    CHECK_EQ(ring.overflow(), 1u);
+    CHECK_EQ(ring.read(out, 0), 8u);
+    CHECK_EQ(out[4], 0.0f);
+    CHECK_EQ(out[15], 11.0f);
+
+    // 只丢弃记下位置之前的数据
+    CHECK_EQ(ring.write(in, 3), 3u);
+    size_t mark = ring.written();
+    CHECK_EQ(ring.write(in + 6, 2), 2u);
+    ring.discard_until(mark);
+    CHECK_EQ(ring.available(), 2u);
+    ring.discard_until(0);
+    CHECK_EQ(ring.available(), 2u);
+    CHECK_EQ(ring.read(out, 0), 2u);
+    CHECK_EQ(out[0], 6.0f);
+}
+
+void test_decimate_across_chunks() {
+    // 48k 立体声 → 16k，分块结果与整块一致
+    const size_t frames = 1000;
+    std::vector<float> in(frames * 2);
+    for (size_t i = 0; i < in.size(); ++i) in[i] = float(i);
+
+    std::vector<float> whole(decimated_frames(frames, 3));
+    downmix_decimate(in.data(), frames, 2, 3, whole.data());
+
+    StreamResampler r(48000, 2, 16000);
+    std::vector<float> chunked;
+    for (size_t pos = 0; pos < frames; pos += 7) {
+        size_t n = std::min<size_t>(7, frames - pos);
+        r.process(in.data() + pos * 2, n, chunked);
+    }
+    CHECK(chunked == whole);
+}
+
+void test_linear_resample() {
+    // 44.1k → 16k：斜坡信号插值后仍是斜坡，长度按比例
+    const size_t frames = 44100;
+    std::vector<float> in(frames);
+    for (size_t i = 0; i < frames; ++i) in[i] = float(i);
+
+    StreamResampler r(44100, 1, 16000);
+    std::vector<float> out;
+    for (size_t pos = 0; pos < frames; pos += 441) r.process(in.data() + pos, 441, out);
+
+    CHECK_NEAR(double(out.size()), 16000.0, 1.0);
+    for (size_t i = 0; i < out.size(); i += 997) CHECK_NEAR(out[i], i * 44100.0 / 16000.0, 1e-2 * i + 1e-3);
+}
+
+void test_energy_vad() {
+    EnergyVad vad(16000, 12.0f, -50.0f);
+    std::vector<float> silence(1600, 0.0f);
+    std::vector<float> speech = tone(1600, 0.1f);
+    CHECK(!vad.is_speech(silence.data(), silence.size()));
+    CHECK(vad.is_speech(speech.data(), speech.size()));
+    // 不足一帧
+    CHECK(!vad.is_speech(speech.data(), 100));
+}
+
+void test_segmenter() {
+    Segmenter::Config config;
+    Segmenter seg(config);
+    std::vector<float> silence(1600, 0.0f);     // 0.1 秒
+    std::vector<float> speech = tone(1600, 0.1f);
+
+    for (int i = 0; i < 10; ++i) CHECK(seg.push(silence.data(), silence.size()) == Segmenter::Event::Idle);
+
+    // 0.3 秒语音确认开始说话，开头带上 0.3 秒预录
+    CHECK(seg.push(speech.data(), speech.size()) == Segmenter::Event::Idle);
+    CHECK(seg.push(speech.data(), speech.size()) == Segmenter::Event::Idle);
+    CHECK(seg.push(speech.data(), speech.size()) == Segmenter::Event::Begin);
+    CHECK_EQ(seg.take_pending().size(), size_t(4800 + 4800));
+
+    for (int i = 0; i < 20; ++i) CHECK(seg.push(speech.data(), speech.size()) == Segmenter::Event::Speaking);
+
+    // 静音 0.8 秒结束
+    for (int i = 0; i < 7; ++i) CHECK(seg.push(silence.data(), silence.size()) == Segmenter::Event::Speaking);
+    CHECK(seg.push(silence.data(), silence.size()) == Segmenter::Event::End);
+    CHECK(!seg.speaking());
+}
+
+void test_segmenter_ignores_clicks() {
+    Segmenter seg(Segmenter::Config{});
+    std::vector<float> silence(1600, 0.0f);
+    std::vector<float> click = tone(1600, 0.2f);
+    for (int i = 0; i < 20; ++i) {
+        Segmenter::Event e = seg.push(i % 3 ? silence.data() : click.data(), 1600);
+        CHECK(e == Segmenter::Event::Idle);
+    }
+}
+
+}  // namespace
+
+TEST_MAIN(test_ring_buffer, test_decimate_across_chunks, test_linear_resample, test_energy_vad, test_segmenter,
+          test_segmenter_ignores_clicks)
@@ -0,0 +1,190 @@
+// 批量调度：多个会话共用模拟识别器（见 fake_backend.h）
+
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "backend.h"
+#include "capswriter_engine.h"
+#include "check.h"
+#include "fake_backend.h"
+#include "scheduler.h"
+#include "session.h"
+
+namespace {
+
+// 在 fake_backend 的基础上提供批量解码，记录每批的路数
+cw_backend fake_batch_backend(Fake* fake) {
+    cw_backend b = fake_backend(fake);
+    b.decode_multiple = [](void* user, void* const* streams, int32_t n) {
+        static_cast<Fake*>(user)->batches.push_back(n);
+        cw_backend single = fake_backend(nullptr);
+        for (int32_t i = 0; i < n; ++i) single.decode(nullptr, streams[i]);
+    };
+    return b;
+}
+
+struct Polled {
+    std::vector<std::string> partials;
+    std::vector<std::string> finals;
+};
+
+void drain(cw_session* session, Polled& out) {
+    cw_result r;
+    while (cw_session_poll(session, &r)) (r.is_final ? out.finals : out.partials).push_back(r.text);
+}
+
+void test_batched_matches_single() {
+    Fake fake;
+    cw_backend backend = fake_batch_backend(&fake);
+    cw_engine* engine = cw_engine_create(&backend);
+
+    cw_scheduler_config config = cw_scheduler_config_default();
+    config.batch_size = 2;
+    config.tick_budget = 0;
+    cw_scheduler* scheduler = cw_scheduler_create(engine, &config);
+    CHECK(scheduler != nullptr);
+
+    const int kSessions = 5;
+    std::vector<cw_session*> sessions;
+    for (int i = 0; i < kSessions; ++i) {
+        sessions.push_back(cw_session_create(engine, nullptr));
+        CHECK_EQ(cw_scheduler_add(scheduler, sessions.back(), 0), 1);
+    }
+    CHECK_EQ(cw_scheduler_add(scheduler, sessions[0], 0), 0);
+
+    // 1 秒语音 + 1.2 秒静音，每 0.1 秒所有会话各写一块再调度一次
+    std::vector<float> speech = audio(1.0, 16000, 1, true), silence = audio(1.2, 16000, 1, false);
+    std::vector<float> input(speech);
+    input.insert(input.end(), silence.begin(), silence.end());
+    std::vector<Polled> out(kSessions);
+    int decoded = 0;
+    for (size_t pos = 0; pos < input.size(); pos += kBlock) {
+        for (auto* s : sessions) cw_session_write(s, input.data() + pos, kBlock);
+        decoded += cw_scheduler_tick(scheduler);
+        for (int i = 0; i < kSessions; ++i) drain(sessions[i], out[i]);
+    }
+
+    // 每块 5 路就绪，按 2、2、1 分批
+    CHECK_EQ(decoded, 22 * kSessions);
+    CHECK_EQ(fake.batches.size(), 22u * 3);
+    CHECK_EQ(std::accumulate(fake.batches.begin(), fake.batches.end(), 0), decoded);
+    for (int n : fake.batches) CHECK(n <= 2);
+
+    cw_scheduler_stats stats = cw_scheduler_get_stats(scheduler);
+    CHECK_EQ(stats.sessions, kSessions);
+    CHECK_EQ(stats.ticks, 22u);
+    CHECK_EQ(stats.batches, fake.batches.size());
+    CHECK_EQ(stats.decoded, uint64_t(decoded));
+
+    // 与各自解码的结果一致：10 个中间结果，静音 1 秒时端点切句
+    for (int i = 0; i < kSessions; ++i) {
+        CHECK_EQ(out[i].partials.size(), 10u);
+        CHECK_EQ(out[i].finals.size(), 1u);
+        if (!out[i].finals.empty()) CHECK_EQ(out[i].finals[0], "aaaaaaaaaa");
+    }
+
+    // 会话销毁时自动移出
+    cw_session_destroy(sessions[4]);
+    CHECK_EQ(cw_scheduler_get_stats(scheduler).sessions, kSessions - 1);
+
+    // 调度器销毁后会话恢复自己解码
+    cw_scheduler_destroy(scheduler);
+    cw_session_write(sessions[0], speech.data(), kBlock);
+    cw_session_process(sessions[0]);
+    drain(sessions[0], out[0]);
+    CHECK_EQ(out[0].partials.back(), "a");
+
+    for (int i = 0; i < kSessions - 1; ++i) cw_session_destroy(sessions[i]);
+    CHECK_EQ(fake.streams, 0);
+    cw_engine_destroy(engine);
+}
+
+void test_deadline_order() {
+    Fake fake;
+    std::unique_ptr<capswriter::Backend> backend = capswriter::make_callback_backend(fake_batch_backend(&fake));
+
+    // 模拟时钟：每解码一路用 10 毫秒
+    double offset = 0;
+    auto clock = [&] {
+        return offset + 0.01 * std::accumulate(fake.batches.begin(), fake.batches.end(), 0);
+    };
+    capswriter::Scheduler::Config config;
+    config.batch_size = 1;
+    config.tick_budget = 0.025;
+    capswriter::Scheduler scheduler(*backend, config, clock);
+
+    // 先加三路批量转录，最后加一路交互式听写
+    cw_session_config session_config = cw_session_config_default();
+    std::vector<std::unique_ptr<capswriter::Session>> sessions;
+    for (int i = 0; i < 4; ++i) {
+        sessions.emplace_back(new capswriter::Session(*backend, session_config));
+        CHECK(scheduler.add(sessions.back().get(), i < 3 ? 1.0 : 0.05));
+    }
+
+    std::vector<float> speech = audio(0.1, 16000, 1, true);
+    for (auto& s : sessions) s->write(speech.data(), speech.size());
+
+    auto has_partial = [](capswriter::Session& s) {
+        cw_result r;
+        return s.poll(r) && std::string(r.text) == "a";
+    };
+
+    // 预算只够解三路：交互式的截止时间最早，先解；批量的按加入顺序
+    CHECK_EQ(scheduler.tick(), 3);
+    CHECK(has_partial(*sessions[3]));
+    CHECK(has_partial(*sessions[0]));
+    CHECK(has_partial(*sessions[1]));
+    CHECK(!has_partial(*sessions[2]));
+    CHECK_EQ(scheduler.stats().missed, 0u);
+
+    // 剩下的一路留到下次，仍按原来开始等待的时刻算截止时间
+    offset = 2.0;
+    CHECK_EQ(scheduler.tick(), 1);
+    CHECK(has_partial(*sessions[2]));
+    CHECK_EQ(scheduler.stats().missed, 1u);
+    CHECK_NEAR(scheduler.stats().max_lateness, 1.03, 1e-9);
+
+    for (auto& s : sessions) scheduler.remove(s.get());
+    CHECK_EQ(scheduler.stats().sessions, 0);
+}
+
+void test_invalid_arguments() {
+    Fake fake;
+    cw_backend backend = fake_backend(&fake);
+    cw_engine* engine = cw_engine_create(&backend);
+    CHECK(cw_scheduler_create(nullptr, nullptr) == nullptr);
+
+    cw_scheduler_config config = cw_scheduler_config_default();
+    config.partial_deadline = 0;
+    CHECK(cw_scheduler_create(engine, &config) == nullptr);
+
+    // 没有 decode_multiple 时逐个解码；会话不能同时在两个调度器中
+    cw_scheduler* a = cw_scheduler_create(engine, nullptr);
+    cw_scheduler* b = cw_scheduler_create(engine, nullptr);
+    cw_session* session = cw_session_create(engine, nullptr);
+    CHECK_EQ(cw_scheduler_add(a, session, 0), 1);
+    CHECK_EQ(cw_scheduler_add(b, session, 0), 0);
+    cw_scheduler_remove(b, session);
+    CHECK_EQ(cw_scheduler_get_stats(a).sessions, 1);
+
+    std::vector<float> speech = audio(0.1, 16000, 1, true);
+    cw_session_write(session, speech.data(), kBlock);
+    CHECK_EQ(cw_scheduler_tick(a), 1);
+    Polled out;
+    drain(session, out);
+    CHECK_EQ(out.partials.size(), 1u);
+
+    cw_scheduler_remove(a, session);
+    CHECK_EQ(cw_scheduler_add(b, session, 0), 1);
+
+    cw_session_destroy(session);
+    cw_scheduler_destroy(a);
+    cw_scheduler_destroy(b);
+    cw_engine_destroy(engine);
+}
+
+}  // namespace
+
+TEST_MAIN(test_batched_matches_single, test_deadline_order, test_invalid_arguments)
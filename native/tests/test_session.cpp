@@ -0,0 +1,222 @@
+// 会话：通过 C 接口驱动模拟识别器（见 fake_backend.h）
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "capswriter_engine.h"
+#include "check.h"
+#include "fake_backend.h"
+
+namespace {
+
+// cw_result 中的指针只在下一次 poll 之前有效，要用的内容当场复制出来
+struct Collected {
+    std::vector<std::string> partials;
+    std::vector<cw_result> finals;
+    std::vector<std::string> final_texts;
+    std::vector<std::vector<float>> final_timestamps;
+};
+
+void drain(cw_session* session, Collected& out) {
+    cw_result r;
+    while (cw_session_poll(session, &r)) {
+        if (r.is_final) {
+            out.finals.push_back(r);
+            out.final_texts.push_back(r.text);
+            out.final_timestamps.emplace_back(r.timestamps, r.timestamps + r.count);
+        } else {
+            out.partials.push_back(r.text);
+        }
+    }
+}
+
+// 按 0.1 秒一块写入并处理
+void feed(cw_session* session, const std::vector<float>& samples, int rate, int channels, Collected& out) {
+    size_t frames = samples.size() / channels, step = size_t(rate / 10);
+    for (size_t pos = 0; pos < frames; pos += step) {
+        int32_t n = int32_t(std::min(step, frames - pos));
+        CHECK_EQ(cw_session_write(session, samples.data() + pos * channels, n), n);
+        cw_session_process(session);
+        drain(session, out);
+    }
+}
+
+void test_continuous_with_endpoint() {
+    Fake fake;
+    cw_backend backend = fake_backend(&fake);
+    cw_engine* engine = cw_engine_create(&backend);
+    CHECK(engine != nullptr);
+
+    cw_session_config config = cw_session_config_default();
+    config.input_sample_rate = 48000;
+    config.input_channels = 2;
+    cw_session* session = cw_session_create(engine, &config);
+    CHECK(session != nullptr);
+    CHECK_EQ(fake.streams, 1);
+
+    cw_text_pipeline* pipeline = cw_text_pipeline_create(nullptr);
+    cw_text_pipeline_add_rule(pipeline, "aaaaaaaaaa", "十个字");
+    cw_session_set_text_pipeline(session, pipeline);
+
+    Collected out;
+    feed(session, audio(1.0, 48000, 2, true), 48000, 2, out);
+    feed(session, audio(1.2, 48000, 2, false), 48000, 2, out);
+    cw_session_finish(session);
+    drain(session, out);
+
+    // 48k 立体声重采样到 16k 单声道
+    CHECK_EQ(fake.accepted, int(2.2 * 16000) + int(0.66 * 16000));
+    CHECK_EQ(out.partials.size(), 10u);
+    CHECK_EQ(out.partials.back(), "aaaaaaaaaa");
+    CHECK_EQ(out.finals.size(), 1u);
+    if (!out.finals.empty()) {
+        CHECK_EQ(out.final_texts[0], "十个字");
+        CHECK_EQ(out.finals[0].index, 0);
+        CHECK_NEAR(out.finals[0].start, 0.0, 1e-9);
+    }
+
+    cw_session_destroy(session);
+    CHECK_EQ(fake.streams, 0);
+    cw_text_pipeline_destroy(pipeline);
+    cw_engine_destroy(engine);
+}
+
+void test_segmented() {
+    Fake fake;
+    cw_backend backend = fake_backend(&fake);
+    cw_engine* engine = cw_engine_create(&backend);
+
+    cw_session_config config = cw_session_config_default();
+    config.segment = 1;
+    config.use_endpoint = 0;
+    cw_session* session = cw_session_create(engine, &config);
+
+    Collected out;
+    feed(session, audio(1.0, 16000, 1, false), 16000, 1, out);
+    feed(session, audio(1.0, 16000, 1, true), 16000, 1, out);
+    feed(session, audio(1.0, 16000, 1, false), 16000, 1, out);
+    CHECK_EQ(out.finals.size(), 1u);
+    feed(session, audio(0.5, 16000, 1, true), 16000, 1, out);
+    cw_session_finish(session);
+    drain(session, out);
+
+    CHECK_EQ(out.finals.size(), 2u);
+    if (out.finals.size() == 2) {
+        // 开头带 0.3 秒预录
+        CHECK_EQ(out.final_texts[0], "aaaaaaaaaa");
+        CHECK_NEAR(out.finals[0].start, 0.7, 1e-6);
+        CHECK_EQ(out.finals[0].count, 10);
+        if (out.finals[0].count) CHECK_NEAR(out.final_timestamps[0][0], 0.3, 1e-6);
+        CHECK_EQ(out.final_texts[1], "aaaaa");
+        CHECK_EQ(out.finals[1].index, 1);
+        // 上一段结束后只有 0.2 秒静音可作预录
+        CHECK_NEAR(out.finals[1].start, 2.8, 1e-6);
+    }
+
+    // 静音不送入识别器：第一段 0.6 秒开头 + 0.7 秒语音 + 0.8 秒静音，第二段 0.5 秒开头 + 0.2 秒语音，各补一次尾部静音
+    CHECK_EQ(fake.accepted, int((0.6 + 0.7 + 0.8 + 0.5 + 0.2) * 16000) + 2 * int(0.66f * 16000));
+
+    cw_session_destroy(session);
+    cw_engine_destroy(engine);
+}
+
+void test_finish_twice() {
+    Fake fake;
+    cw_backend backend = fake_backend(&fake);
+    cw_engine* engine = cw_engine_create(&backend);
+    cw_session* session = cw_session_create(engine, nullptr);
+
+    // 每次按键一句：finish 之后会话继续接收下一句
+    Collected out;
+    for (int i = 0; i < 3; ++i) {
+        feed(session, audio(0.5, 16000, 1, true), 16000, 1, out);
+        cw_session_finish(session);
+        drain(session, out);
+    }
+    CHECK_EQ(out.finals.size(), 3u);
+    for (const auto& text : out.final_texts) CHECK_EQ(text, "aaaaa");
+    CHECK_EQ(fake.streams, 1);
+
+    cw_session_destroy(session);
+    CHECK_EQ(fake.streams, 0);
+    cw_engine_destroy(engine);
+}
+
+void test_overflow_and_reset() {
+    Fake fake;
+    cw_backend backend = fake_backend(&fake);
+    cw_engine* engine = cw_engine_create(&backend);
+    cw_session_config config = cw_session_config_default();
+    config.ring_seconds = 0.5f;
+    cw_session* session = cw_session_create(engine, &config);
+
+    std::vector<float> speech = audio(1.0, 16000, 1, true);
+    CHECK_EQ(cw_session_write(session, speech.data(), 16000), 8000);
+    CHECK_EQ(cw_session_overflow(session), 8000u);
+
+    cw_session_reset(session);
+    CHECK_EQ(cw_session_overflow(session), 0u);
+    CHECK_EQ(cw_session_process(session), 0);
+    cw_result r;
+    CHECK_EQ(cw_session_poll(session, &r), 0);
+
+    cw_session_destroy(session);
+    cw_engine_destroy(engine);
+}
+
+void test_invalid_arguments() {
+    cw_backend empty{};
+    CHECK(cw_engine_create(&empty) == nullptr);
+    CHECK(cw_engine_create(nullptr) == nullptr);
+#ifndef CAPSWRITER_WITH_SHERPA
+    CHECK(cw_engine_create_sherpa(nullptr) == nullptr);
+#endif
+
+    Fake fake;
+    cw_backend backend = fake_backend(&fake);
+    cw_engine* engine = cw_engine_create(&backend);
+    cw_session_config config = cw_session_config_default();
+    config.input_channels = 0;
+    CHECK(cw_session_create(engine, &config) == nullptr);
+    cw_engine_destroy(engine);
+
+    CHECK_NEAR(cw_tail_padding("paraformer"), 0.66, 1e-6);
+    CHECK_NEAR(cw_tail_padding("zipformer2_ctc"), 0.3, 1e-6);
+    CHECK_NEAR(cw_tail_padding(nullptr), 0.66, 1e-6);
+}
+
+void test_seam_merge() {
+    const char* prev[] = {"你", "好"};
+    const char* tokens[] = {"你", "好", "世", "界"};
+    float timestamps[] = {0.1f, 0.2f, 5.0f, 6.0f};
+    int32_t begin = -1, end = -1;
+    cw_seam_merge(prev, 2, tokens, timestamps, 4, 0.0, 10.0, 1, 1, &begin, &end);
+    CHECK_EQ(begin, 2);
+    CHECK_EQ(end, 4);
+
+    // 参数无效时返回空区间
+    cw_seam_merge(prev, 2, tokens, nullptr, 4, 0.0, 10.0, 1, 1, &begin, &end);
+    CHECK_EQ(begin, 0);
+    CHECK_EQ(end, 0);
+    const char* holes[] = {"你", nullptr};
+    cw_seam_merge(holes, 2, tokens, timestamps, 4, 0.0, 10.0, 1, 1, &begin, &end);
+    CHECK_EQ(end, 0);
+    cw_seam_merge(nullptr, 0, nullptr, nullptr, 0, 0.0, 10.0, 0, 1, &begin, &end);
+    CHECK_EQ(end, 0);
+}
+
+void test_text_pipeline_c_api() {
+    cw_text_options options = cw_text_options_default();
+    cw_text_pipeline* pipeline = cw_text_pipeline_create(&options);
+    cw_text_pipeline_add_hotword(pipeline, "ChatGPT");
+    char* text = cw_text_pipeline_process(pipeline, "我问了chat gpt三个问题");
+    CHECK(text && std::strcmp(text, "我问了 ChatGPT 3个问题") == 0);
+    cw_string_free(text);
+    cw_text_pipeline_destroy(pipeline);
+}
+
+}  // namespace
+
+TEST_MAIN(test_continuous_with_endpoint, test_segmented, test_finish_twice, test_overflow_and_reset,
+          test_invalid_arguments, test_seam_merge, test_text_pipeline_c_api)
@@ -0,0 +1,65 @@
+// 文本管线：期望值取自 Python 端 format_text、hot_sub_en 的输出
+
+#include "check.h"
+#include "text_pipeline.h"
+#include "utf8.h"
+
+using namespace capswriter;
+
+namespace {
+
+std::string run(TextPipeline& p, const char* text) { return u32_to_utf8(p.process(utf8_to_u32(text))); }
+
+void test_format() {
+    TextPipeline p(TextPipeline::Options{});
+    CHECK_EQ(run(p, "我有一百二十三个苹果"), "我有123个苹果");
+    CHECK_EQ(run(p, "今天是二零二四年十月十八号"), "今天是2024年10月18号");
+    CHECK_EQ(run(p, "价格是三点五元"), "价格是3.5元");
+    CHECK_EQ(run(p, "百分之五十的人"), "50%的人");
+    CHECK_EQ(run(p, "用windows十一"), "用 windows 11");
+    CHECK_EQ(run(p, "打开chat gpt"), "打开 chat gpt");
+}
+
+void test_options() {
+    TextPipeline::Options options;
+    options.itn = false;
+    TextPipeline p(options);
+    CHECK_EQ(run(p, "我有一百二十三个苹果"), "我有一百二十三个苹果");
+}
+
+void test_hotwords() {
+    TextPipeline p(TextPipeline::Options{});
+    p.add_hotword(U"ChatGPT");
+    p.add_hotword(U"Microsoft");
+    p.add_hotword(U"7-Zip");
+    auto replace = [&](const char* text) { return u32_to_utf8(p.replace_hotwords(utf8_to_u32(text))); };
+    CHECK_EQ(replace("the chat gpt is by microsoft"), "the ChatGPT is by Microsoft");
+    CHECK_EQ(replace("打开7 zip测试"), "打开7-Zip测试");
+    // 单词的一部分不替换
+    CHECK_EQ(replace("chatgptx"), "chatgptx");
+    CHECK_EQ(replace("microsofts"), "microsofts");
+}
+
+void test_rules() {
+    TextPipeline p(TextPipeline::Options{});
+    p.add_rule(U"毫安时", U"mAh");
+    p.add_rule(U"毫安", U"mA");
+    p.add_rule(U"的的", U"的");
+    auto replace = [&](const char* text) { return u32_to_utf8(p.replace_rules(utf8_to_u32(text))); };
+    // 最左最长、不重叠
+    CHECK_EQ(replace("五千毫安时的的电池"), "五千mAh的电池");
+    CHECK_EQ(replace("两百毫安"), "两百mA");
+    p.clear();
+    CHECK_EQ(replace("两百毫安"), "两百毫安");
+}
+
+void test_utf8() {
+    CHECK(utf8_to_u32("a\xE4\xB8\xAD") == U"a中");
+    // 截断的多字节序列按 U+FFFD 处理
+    CHECK(utf8_to_u32("a\xE4\xB8") == U"a��");
+    CHECK_EQ(u32_to_utf8(U"a中😀"), "a中😀");
+}
+
+}  // namespace
+
+TEST_MAIN(test_format, test_options, test_hotwords, test_rules, test_utf8)
@@ -17,6 +17,7 @@ __all__ = ['chinese_to_num']
 
 import re
 from string import ascii_letters
+from util.native import native
 
 
 # 常见的跟在数字后面的单位
@@ -263,6 +264,11 @@ def replace(original):
 
 
 def chinese_to_num(original):
+    if native:
+        try:
+            return native.chinese_to_num(original)
+        except OverflowError:       # 数值超出 64 位整数，交给 Python 处理
+            pass
     return pattern.sub(replace, original)
 
 if __name__ == "__main__":
@@ -4,6 +4,7 @@ import sounddevice as sd
 import sys
 from pathlib import Path
 from typing import List, Union
+from util.client_ring_buffer import RingBuffer, NativeRingBuffer
 
 from rich.console import Console 
 from rich.theme import Theme
@@ -22,4 +23,5 @@ class Cosmic:
     websocket: websockets.WebSocketClientProtocol = None
     audio_files = {}
     stream: Union[None, sd.InputStream] = None
+    ring: Union[None, RingBuffer, NativeRingBuffer] = None
     kwd_list: List[str] = []
@@ -0,0 +1,172 @@
+import asyncio
+import uuid
+from collections import deque
+from typing import List, Tuple, Union
+
+import numpy as np
+
+from config import ClientConfig as Config
+from util.client_cosmic import Cosmic, console
+from util.client_create_file import create_file
+from util.client_finish_file import finish_file
+from util.client_send_audio import build_message, build_final_message, send_message, downsample
+from util.client_vad import EnergyVad, create_vad
+from util.client_write_file import write_file
+
+
+'''
+免提模式：麦克风常开，不用按住快捷键
+
+空闲时只运行能量检测，每个批次只是一次降采样和几次求均值，几乎不占 CPU；
+能量超过底噪时，再用 silero_vad（如果有）确认是不是说话，过滤掉敲键盘、关门之类的声音。
+
+确认开始说话后，连同之前 hands_free_preroll 秒的音频一起，作为一个新任务发给服务端；
+静音超过 hands_free_silence 秒，这段话结束，发送结束标志，服务端识别后照常上屏。
+服务端只在有语音的时候收到音频，识别模型平时完全空闲。
+
+音频以批次（mic_chunk_duration）为单位处理，每个批次是 (48k 原始音频, 16k 单声道, 时间)。
+'''
+
+
+Chunk = Tuple[np.ndarray, np.ndarray, float]
+
+
+class SpeechSegmenter:
+    """
+    输入音频批次，输出语音段事件：
+        ('begin', [chunks])     一段话开始，附带之前的 preroll 和已确认的语音
+        ('data', [chunk])       这段话中的音频
+        ('end', [])             这段话结束
+    """
+
+    def __init__(self):
+        self.energy = EnergyVad()
+        vad = create_vad()
+        self.confirm = None if isinstance(vad, EnergyVad) else vad
+        self.reset()
+
+    def reset(self):
+        self.preroll: deque = deque()       # 开始说话前的音频
+        self.preroll_len = 0.0
+        self.pending: List[Chunk] = []      # 疑似语音，还不够 min_speech 长
+        self.pending_len = 0.0
+        self.speaking = False
+        self.silence = 0.0                  # 这段话末尾连续静音的长度
+        self.length = 0.0                   # 这段话的长度
+
+    def push(self, chunk: Chunk) -> List[Tuple[str, List[Chunk]]]:
+        samples = chunk[1]
+        duration = len(samples) / 16000
+        if self.speaking:
+            return self._push_speaking(chunk, duration)
+
+        # 空闲：先用能量检测，超过底噪才交给模型确认
+        speech = self.energy.is_speech(samples)
+        if speech and self.confirm:
+            speech = self.confirm.is_speech(samples)
+
+        if not speech:
+            # 不连续的疑似语音当作噪声，并入 preroll
+            for c in self.pending:
+                self._hold(c, len(c[1]) / 16000)
+            self.pending.clear(); self.pending_len = 0.0
+            self._hold(chunk, duration)
+            return []
+
+        self.pending.append(chunk)
+        self.pending_len += duration
+        if self.pending_len < Config.hands_free_min_speech:
+            return []
+
+        # 确认开始说话
+        chunks = list(self.preroll) + self.pending
+        self.length = sum(len(c[1]) for c in chunks) / 16000
+        self.preroll.clear(); self.preroll_len = 0.0
+        self.pending = []; self.pending_len = 0.0
+        self.speaking = True
+        self.silence = 0.0
+        return [('begin', chunks)]
+
+    def _push_speaking(self, chunk: Chunk, duration: float) -> List[Tuple[str, List[Chunk]]]:
+        self.length += duration
+        if self.energy.is_speech(chunk[1]):
+            self.silence = 0.0
+        else:
+            self.silence += duration
+
+        events = [('data', [chunk])]
+        if self.silence >= Config.hands_free_silence or self.length >= Config.hands_free_max_segment:
+            events.append(('end', []))
+            self.speaking = False
+            self.silence = 0.0
+            self.length = 0.0
+        return events
+
+    def _hold(self, chunk: Chunk, duration: float):
+        self.preroll.append(chunk)
+        self.preroll_len += duration
+        while self.preroll and self.preroll_len - len(self.preroll[0][1]) / 16000 >= Config.hands_free_preroll:
+            self.preroll_len -= len(self.preroll.popleft()[1]) / 16000
+
+
+class Segment:
+    """一段话对应的识别任务"""
+
+    def __init__(self, time_start: float, channels: int):
+        self.task_id = str(uuid.uuid1())
+        self.time_start = time_start
+        self.duration = 0.0
+        self.file_path, self.file = '', None
+        if Config.save_audio:
+            self.file_path, self.file = create_file(channels, time_start)
+            Cosmic.audio_files[self.task_id] = self.file_path
+
+    def send(self, chunk: Chunk):
+        data, samples, time_frame = chunk
+        self.duration += len(samples) / 16000
+        if Config.save_audio:
+            write_file(self.file, data)
+        message = build_message(self.task_id, self.time_start, time_frame, samples)
+        asyncio.create_task(send_message(message))
+
+    def finish(self, time_frame: float):
+        if Config.save_audio:
+            finish_file(self.file)
+        console.print(f'任务标识：{self.task_id}')
+        console.print(f'    语音时长：{self.duration:.2f}s')
+        message = build_final_message(self.task_id, self.time_start, time_frame)
+        asyncio.create_task(send_message(message))
+
+
+async def hands_free_loop():
+    """免提模式下代替 send_audio，持续消费录音队列，按语音段创建识别任务"""
+    segmenter = SpeechSegmenter()
+    segment: Union[None, Segment] = None
+
+    while task := await Cosmic.queue_in.get():
+        Cosmic.queue_in.task_done()
+        try:
+            if task['type'] == 'finish':
+                # 暂停监听：结束正在说的这段话
+                if segment:
+                    segment.finish(task['time'])
+                    segment = None
+                segmenter.reset()
+                continue
+            if task['type'] != 'data':
+                continue
+
+            data = task['data']
+            chunk = (data, downsample(data), task['time'])
+            for kind, chunks in segmenter.push(chunk):
+                if kind == 'begin':
+                    first = chunks[0]
+                    segment = Segment(first[2] - len(first[1]) / 16000, data.shape[1])
+                if segment:
+                    for c in chunks:
+                        segment.send(c)
+                if kind == 'end' and segment:
+                    segment.finish(task['time'])
+                    segment = None
+        except Exception as e:
+            console.print(f'免提模式出错：{e}', style='bright_red')
@@ -8,6 +8,7 @@ from util.client_cosmic import Cosmic, console
 from util.client_check_websocket import check_websocket
 from util.client_hot_sub import hot_sub
 from util.client_rename_audio import rename_audio
+from util.client_search_index import index_result
 from util.client_strip_punc import strip_punc
 from util.client_write_md import write_md
 from util.client_type_result import type_result
@@ -45,6 +46,10 @@ async def recv_result():
                 # 记录写入 md 文件
                 write_md(text, message['time_start'], file_audio)
 
+                # 加入全文索引
+                index_result(text, message['time_start'], file_audio,
+                             message.get('tokens', []), message.get('timestamps', []))
+
             # 控制台输出
             console.print(f'    转录时延：{delay:.2f}s')
             console.print(f'    识别结果：[green]{text}')
@@ -0,0 +1,117 @@
+import numpy as np
+
+from util.native import native
+
+
+class RingBuffer:
+    """
+    单生产者、单消费者的音频环形缓冲区
+
+    PortAudio 回调线程只调用 write，事件循环只调用 read / reset / discard_until，
+    两端各自只修改自己的游标，依靠 GIL 下整数赋值的原子性，无需加锁。
+    缓冲区在创建时一次分配好，写入路径上不再分配音频内存。
+    """
+
+    def __init__(self, frames: int, channels: int):
+        self.capacity = frames
+        self.channels = channels
+        self.buffer = np.zeros((frames, channels), dtype=np.float32)
+        self.head = 0           # 累计写入帧数，只由写入端修改
+        self.tail = 0           # 累计读取帧数，只由读取端修改
+        self.overflow = 0       # 缓冲区满时被丢弃的帧数
+
+    def available(self) -> int:
+        return self.head - self.tail
+
+    def write(self, data: np.ndarray) -> None:
+        # 在回调线程中调用，满了就丢弃新数据，不去动读取端的游标
+        n = len(data)
+        free = self.capacity - (self.head - self.tail)
+        if n > free:
+            self.overflow += n - free
+            n = free
+        if n <= 0:
+            return
+
+        start = self.head % self.capacity
+        first = min(n, self.capacity - start)
+        self.buffer[start:start + first] = data[:first]
+        if first < n:
+            self.buffer[:n - first] = data[first:n]
+
+        # 数据写完后再移动游标，读取端才能看到
+        self.head += n
+
+    def read(self, max_frames: int = 0) -> np.ndarray:
+        # 在事件循环中调用，返回一段新数组，读取端可以自由持有
+        n = self.head - self.tail
+        if max_frames:
+            n = min(n, max_frames)
+        if n <= 0:
+            return self.buffer[:0].copy()
+
+        start = self.tail % self.capacity
+        first = min(n, self.capacity - start)
+        if first == n:
+            data = self.buffer[start:start + n].copy()
+        else:
+            data = np.concatenate((self.buffer[start:], self.buffer[:n - first]))
+
+        self.tail += n
+        return data
+
+    @property
+    def written(self) -> int:
+        # 累计写入的帧数，任何线程都可以读取，配合 discard_until 使用
+        return self.head
+
+    def discard_until(self, mark: int) -> None:
+        # 丢弃累计位置 mark 之前写入、尚未读取的数据，之后写入的保留（由读取端调用）
+        mark = min(mark, self.head)
+        if mark > self.tail:
+            self.tail = mark
+
+    def reset(self) -> None:
+        # 丢弃尚未读取的数据（由读取端调用）
+        self.tail = self.head
+        self.overflow = 0
+
+
+class NativeRingBuffer:
+    """capswriter_native.RingBuffer 的包装，接口与 RingBuffer 相同"""
+
+    def __init__(self, frames: int, channels: int):
+        self.ring = native.RingBuffer(frames, channels)
+        self.capacity = frames
+        self.channels = channels
+
+    @property
+    def overflow(self) -> int:
+        return self.ring.overflow
+
+    def available(self) -> int:
+        return self.ring.available()
+
+    def write(self, data: np.ndarray) -> None:
+        self.ring.write(data)
+
+    def read(self, max_frames: int = 0) -> np.ndarray:
+        data = np.frombuffer(self.ring.read(max_frames), dtype=np.float32)
+        return data.reshape(-1, self.channels)
+
+    @property
+    def written(self) -> int:
+        return self.ring.written
+
+    def discard_until(self, mark: int) -> None:
+        self.ring.discard_until(mark)
+
+    def reset(self) -> None:
+        self.ring.reset()
+
+
+def create_ring_buffer(frames: int, channels: int):
+    # 编译了 capswriter_native 时，改用 C++ 实现
+    if native:
+        return NativeRingBuffer(frames, channels)
+    return RingBuffer(frames, channels)
@@ -0,0 +1,368 @@
+"""
+识别结果的全文索引
+
+听写日记、转录字幕散落在成千上万个文件里，这里为它们建一个增量的倒排索引：
+
+    中文按相邻两字（bigram）建索引，英文、数字按整词建索引
+    倒排表的每一项是（文档编号, 位置），文档里记录了文字位置到音频秒数的对应，
+    搜到的每一处都能定位到录音文件里的具体时刻
+    短语查询：取各个词的倒排表求交，再核对相对位置，毫秒级返回
+
+磁盘上的结构（都在 index_dir 文件夹下）：
+
+    docs.jsonl          每行一个文档，只追加
+    postings-N.json     倒排表分段，新结果攒够一批写成一个新分段，分段多了合并成一个
+
+启动时载入所有分段，再把分段之后追加的文档补进内存，崩溃也不会漏。
+
+客户端收到结果时只把它放进队列，由后台线程载入索引、写文档和分段，
+首次载入和合并分段都不会卡住收发结果和音频的事件循环。
+
+命令行：
+
+    python -m util.client_search_index search 关键词      搜索
+    python -m util.client_search_index rebuild          从 年/月/日.md 日记重建索引
+    python -m util.client_search_index add a.json b.json  加入转录生成的 json 文件
+"""
+
+import atexit
+import glob
+import json
+import re
+import threading
+import time
+from bisect import bisect_right
+from pathlib import Path
+from queue import Queue
+from typing import Dict, List, Tuple, Union
+
+from config import ClientConfig as Config
+
+
+# 每个词及其在规范化文本中的位置
+Terms = List[Tuple[str, int]]
+
+
+def is_cjk(ch: str) -> bool:
+    return '\u3400' <= ch <= '\u9fff' or '\uf900' <= ch <= '\ufaff'
+
+
+def normalize(text: str) -> str:
+    # 只保留汉字和英文数字，英文小写，词与词之间一个空格
+    text = re.sub(r'[^\w\u3400-\u9fff]+', ' ', text.lower()).replace('_', ' ')
+    text = re.sub(r'(?<=[\u3400-\u9fff]) +|(?<=\w) +(?=[\u3400-\u9fff])', '', text)
+    return text.strip()
+
+
+def tokenize(norm: str) -> Terms:
+    # 连续汉字取 bigram（单字的一段取单字），英文数字取整词
+    terms = []
+    for m in re.finditer(r'[\u3400-\u9fff]+|[a-z0-9]+', norm):
+        run, start = m.group(), m.start()
+        if is_cjk(run[0]):
+            if len(run) == 1:
+                terms.append((run, start))
+            for i in range(len(run) - 1):
+                terms.append((run[i:i + 2], start + i))
+        else:
+            terms.append((run, start))
+    return terms
+
+
+def align(norm: str, tokens: List[str], timestamps: List[float]) -> List[Tuple[int, float]]:
+    """
+    把识别 token 的时间戳对应到规范化文本的位置，返回 [(位置, 秒数), ...]
+    加标点、转数字、热词替换之后文本会变，对不上的 token 直接跳过
+    """
+    marks, cursor = [], 0
+    for token, t in zip(tokens, timestamps):
+        token = normalize(token.replace('@@', '').replace('▁', ''))
+        if not token:
+            continue
+        pos = norm.find(token, cursor, cursor + len(token) + 10)
+        if pos >= 0:
+            marks.append((pos, t))
+            cursor = pos + len(token)
+    return marks
+
+
+class Hit:
+    def __init__(self, doc: dict, pos: int, norm: str):
+        self.doc = doc
+        self.time = doc['time']                 # 结果的时间（录音开始时刻）
+        self.audio = doc['audio']               # 录音或音视频文件
+        self.text = doc['text']
+        self.offset = 0.0                       # 命中处在音频中的秒数
+        marks = doc.get('marks') or []
+        i = bisect_right([p for p, _ in marks], pos) - 1
+        if i >= 0:
+            self.offset = marks[i][1]
+        self.snippet = norm[max(0, pos - 15):pos + 30]
+
+
+class SearchIndex:
+    def __init__(self, folder: Path):
+        self.folder = folder
+        folder.mkdir(parents=True, exist_ok=True)
+        self.path_docs = folder / 'docs.jsonl'
+        self.postings: Dict[str, List[int]] = {}    # 词 -> [文档, 位置, 文档, 位置, ...]
+        self.pending: Dict[str, List[int]] = {}     # 还没写入分段的倒排项
+        self.pending_docs = 0
+        self.offsets: List[int] = []                # 文档编号 -> docs.jsonl 中的字节偏移
+        self.segments: List[Path] = []
+        self.indexed = 0                            # 已写入分段的文档数
+        self.load()
+
+    # ---------- 载入 ----------
+
+    def load(self):
+        self.segments = sorted(self.folder.glob('postings-*.json'),
+                               key=lambda p: int(p.stem.split('-')[1]))
+        for segment in self.segments:
+            with open(segment, 'r', encoding='utf-8') as f:
+                data = json.load(f)
+            if data['first'] == 0:
+                self.postings = {}      # 合并后的分段包含之前所有分段（合并时崩溃会留下旧分段）
+            self.indexed = max(self.indexed, data['docs'])
+            for term, items in data['postings'].items():
+                self.postings.setdefault(term, []).extend(items)
+
+        # 文档偏移；分段之后追加的文档补进索引
+        if not self.path_docs.exists():
+            self.path_docs.touch()
+        with open(self.path_docs, 'rb') as f:
+            offset = 0
+            for line in f:
+                if not line.endswith(b'\n'):
+                    break               # 写到一半的行
+                doc_id = len(self.offsets)
+                self.offsets.append(offset)
+                offset += len(line)
+                if doc_id >= self.indexed:
+                    self.index_doc(doc_id, json.loads(line))
+
+    # ---------- 写入 ----------
+
+    def add(self, text: str, time_start: float, audio: Union[str, Path],
+            tokens: List[str] = (), timestamps: List[float] = (), source: str = 'mic') -> int:
+        norm = normalize(text)
+        if not norm:
+            return -1
+        doc = {
+            'time': time_start,
+            'source': source,
+            'audio': str(audio) if audio else '',
+            'text': text,
+            'marks': align(norm, list(tokens), list(timestamps)),
+        }
+        doc_id = len(self.offsets)
+        line = (json.dumps(doc, ensure_ascii=False) + '\n').encode('utf-8')
+        with open(self.path_docs, 'ab') as f:
+            self.offsets.append(f.tell())
+            f.write(line)
+        self.index_doc(doc_id, doc)
+        if self.pending_docs >= Config.index_batch:
+            self.flush()
+        return doc_id
+
+    def index_doc(self, doc_id: int, doc: dict):
+        for term, pos in tokenize(normalize(doc['text'])):
+            for table in (self.postings, self.pending):
+                table.setdefault(term, []).extend((doc_id, pos))
+        self.pending_docs += 1
+
+    def flush(self):
+        # 攒下的倒排项写成一个新分段，分段太多就合并
+        if not self.pending_docs:
+            return
+        n = int(self.segments[-1].stem.split('-')[1]) + 1 if self.segments else 0
+        self.write_segment(self.folder / f'postings-{n}.json', self.pending, self.indexed)
+        self.pending, self.pending_docs = {}, 0
+        if len(self.segments) > Config.index_segments:
+            self.merge()
+
+    def merge(self):
+        path = self.folder / f'postings-{int(self.segments[-1].stem.split("-")[1]) + 1}.json'
+        old = self.segments
+        self.segments = []
+        self.write_segment(path, self.postings, 0)
+        for segment in old:
+            segment.unlink()
+
+    def write_segment(self, path: Path, postings: Dict[str, List[int]], first: int):
+        # 分段覆盖文档 [first, docs)
+        tmp = path.with_suffix('.tmp')
+        with open(tmp, 'w', encoding='utf-8') as f:
+            json.dump({'first': first, 'docs': len(self.offsets), 'postings': postings}, f,
+                      ensure_ascii=False, separators=(',', ':'))
+        tmp.replace(path)
+        self.segments.append(path)
+        self.indexed = len(self.offsets)
+
+    # ---------- 查询 ----------
+
+    def doc(self, doc_id: int) -> dict:
+        with open(self.path_docs, 'rb') as f:
+            f.seek(self.offsets[doc_id])
+            return json.loads(f.readline())
+
+    def search(self, query: str, limit: int = 50) -> List[Hit]:
+        norm = normalize(query)
+        terms = tokenize(norm)
+        if not terms:
+            return []
+        if len(norm) == 1 and is_cjk(norm):
+            return self.scan(norm, limit)
+
+        # 从最短的倒排表出发，其余的词按相对位置核对
+        tables = []
+        for term, rel in terms:
+            items = self.postings.get(term)
+            if not items:
+                return []
+            tables.append((len(items), rel, items))
+        tables.sort(key=lambda t: t[0])
+        _, base_rel, base = tables[0]
+        others = [(rel, set(zip(items[::2], items[1::2]))) for _, rel, items in tables[1:]]
+
+        found = set()
+        for doc_id, pos in zip(base[::2], base[1::2]):
+            start = pos - base_rel
+            if all((doc_id, start + rel) in table for rel, table in others):
+                found.add((doc_id, start))
+
+        # 新的结果在前；英文短语还要核对词间的空格
+        hits = []
+        for doc_id, start in sorted(found, reverse=True):
+            doc = self.doc(doc_id)
+            text = normalize(doc['text'])
+            if text[start:start + len(norm)] == norm:
+                hits.append(Hit(doc, start, text))
+                if len(hits) >= limit:
+                    break
+        return hits
+
+    def scan(self, char: str, limit: int) -> List[Hit]:
+        # 单个汉字不在 bigram 里，直接从新到旧扫描文档
+        with open(self.path_docs, 'rb') as f:
+            lines = f.read().splitlines()[:len(self.offsets)]
+        hits = []
+        for line in reversed(lines):
+            doc = json.loads(line)
+            text = normalize(doc['text'])
+            pos = text.find(char)
+            if pos >= 0:
+                hits.append(Hit(doc, pos, text))
+                if len(hits) >= limit:
+                    break
+        return hits
+
+
+index: Union[None, SearchIndex] = None
+
+
+def get_index() -> SearchIndex:
+    global index
+    if index is None:
+        index = SearchIndex(Path(Config.index_dir))
+    return index
+
+
+class IndexWriter:
+    """
+    后台建索引的线程
+
+    index_result 只把结果放进队列就返回，载入索引、写文档、写分段和合并都在这个线程里进行。
+    退出时写完队列中剩下的结果。
+    """
+
+    def __init__(self):
+        self.queue: Queue = Queue()
+        self.thread = threading.Thread(target=self.run, daemon=True)
+        self.thread.start()
+        atexit.register(self.close)
+
+    def put(self, *args):
+        self.queue.put(args)
+
+    def run(self):
+        while True:
+            args = self.queue.get()
+            if args is None:                    # 退出信号
+                return
+            try:
+                get_index().add(*args)
+            except Exception as e:
+                print(f'加入全文索引出错：{e}')
+
+    def close(self):
+        if self.thread.is_alive():
+            self.queue.put(None)
+            self.thread.join(timeout=5)
+
+
+writer: Union[None, IndexWriter] = None
+
+
+def index_result(text: str, time_start: float, audio, tokens=(), timestamps=(), source='mic'):
+    global writer
+    if not Config.search_index:
+        return
+    if writer is None:
+        writer = IndexWriter()
+    writer.put(text, time_start, audio or '', tokens, timestamps, source)
+
+
+def rebuild():
+    # 从 年/月/日.md 的日记重建（关键词日记是日记的子集，不重复收录）
+    idx = get_index()
+    line_re = re.compile(r'^\[(\d\d:\d\d:\d\d)\]\((.+?)\) (.*)$')
+    count = 0
+    for md in sorted(Path().glob('[0-9][0-9][0-9][0-9]/[0-9][0-9]/[0-9][0-9].md')):
+        year, month, day = md.parts[-3], md.parts[-2], md.stem
+        with open(md, 'r', encoding='utf-8') as f:
+            for line in f:
+                m = line_re.match(line.strip())
+                if not m:
+                    continue
+                hms, audio, text = m.groups()
+                t = time.mktime(time.strptime(f'{year}{month}{day} {hms}', '%Y%m%d %H:%M:%S'))
+                audio = (md.parent / audio.replace('%20', ' ')).as_posix()
+                count += idx.add(text, t, audio) >= 0
+    idx.flush()
+    print(f'已收录 {count} 条日记')
+
+
+def add_json(files: List[Path]):
+    # 转录文件生成的 json（字级时间戳）和同名 txt
+    idx = get_index()
+    for file in files:
+        with open(file, 'r', encoding='utf-8') as f:
+            info = json.load(f)
+        merge = file.with_suffix('.merge.txt')
+        text = merge.read_text(encoding='utf-8') if merge.exists() else ''.join(info['tokens'])
+        media = [p for p in file.parent.glob(f'{glob.escape(file.stem)}.*')
+                 if p.suffix not in ('.json', '.txt', '.srt')]
+        audio = media[0].absolute() if media else file.absolute()
+        idx.add(text, file.stat().st_mtime, audio, info['tokens'], info['timestamps'], 'file')
+        print(f'已收录：{file}')
+    idx.flush()
+
+
+def main(command: str, args: List[str]):
+    if command == 'search':
+        t1 = time.time()
+        hits = get_index().search(' '.join(args))
+        for hit in hits:
+            when = time.strftime('%Y-%m-%d %H:%M:%S', time.localtime(hit.time))
+            print(f'{when}  {hit.audio}  @{hit.offset:.2f}s\n    {hit.snippet}')
+        print(f'共 {len(hits)} 条，用时 {(time.time() - t1) * 1000:.1f}ms')
+    elif command == 'rebuild':
+        rebuild()
+    elif command == 'add':
+        add_json([Path(a) for a in args])
+
+
+if __name__ == '__main__':
+    import typer
+    typer.run(main)
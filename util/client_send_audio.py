@@ -9,6 +9,8 @@ import websockets
 from util.client_create_file import create_file
 from util.client_write_file import write_file
 from util.client_finish_file import finish_file
+from util.client_vad import VadGate
+from util.native import native
 import uuid
 
 
@@ -30,6 +32,45 @@ async def send_message(message):
             print(e)
 
 
+def downsample(data: np.ndarray) -> np.ndarray:
+    # 48k 多声道 → 16k 单声道
+    if native and data.flags.c_contiguous:
+        return np.frombuffer(native.downmix_decimate(data, data.shape[1], 3), dtype=np.float32)
+    return np.mean(data[::3], axis=1)
+
+
+def build_message(task_id, time_start, time_frame, samples, is_pause=False):
+    # 发送音频数据用于识别
+    return {
+        'task_id': task_id,             # 任务 ID
+        'seg_duration': Config.mic_seg_duration,    # 分段长度
+        'seg_overlap': Config.mic_seg_overlap,      # 分段重叠
+        'is_final': False,              # 是否结束
+        'time_start': time_start,       # 录音起始时间
+        'time_frame': time_frame,       # 该帧时间
+        'source': 'mic',                # 数据来源：从麦克风收到的数据
+        'is_pause': is_pause,           # 此处有被丢弃的停顿，服务端可在此切分
+        'data': base64.b64encode(       # 数据
+                    samples.tobytes() if samples is not None else b''
+                ).decode('utf-8'),
+    }
+
+
+def build_final_message(task_id, time_start, time_frame):
+    # 告诉服务端音频片段结束了
+    return {
+        'task_id': task_id,
+        'seg_duration': 15,
+        'seg_overlap': 2,
+        'is_final': True,
+        'time_start': time_start,
+        'time_frame': time_frame,
+        'source': 'mic',
+        'is_pause': False,
+        'data': '',
+    }
+
+
 async def send_audio():
     try:
 
@@ -46,6 +87,9 @@ async def send_audio():
         # 保存音频文件
         file_path, file = '', None
 
+        # 语音活动检测
+        gate = VadGate() if Config.vad else None
+
         # 开始取数据
         # task: {'type', 'time', 'data'}
         while task := await Cosmic.queue_in.get():
@@ -75,39 +119,31 @@ async def send_audio():
                 if Config.save_audio:
                     write_file(file, data)
 
-                # 发送音频数据用于识别
-                message = {
-                    'task_id': task_id,             # 任务 ID
-                    'seg_duration': Config.mic_seg_duration,    # 分段长度
-                    'seg_overlap': Config.mic_seg_overlap,      # 分段重叠
-                    'is_final': False,              # 是否结束
-                    'time_start': time_start,       # 录音起始时间
-                    'time_frame': task['time'],     # 该帧时间
-                    'source': 'mic',                # 数据来源：从麦克风收到的数据
-                    'data': base64.b64encode(       # 数据
-                                np.mean(data[::3], axis=1).tobytes()
-                            ).decode('utf-8'),
-                }
-                task = asyncio.create_task(send_message(message))
+                # 降采样为 16k 单声道
+                samples = downsample(data)
+
+                # 经过 VAD 门控，丢弃多余的静音
+                items = gate.push(samples) if gate else [('data', samples)]
+                for kind, samples in items:
+                    message = build_message(task_id, time_start, task['time'], samples,
+                                            is_pause=(kind == 'pause'))
+                    asyncio.create_task(send_message(message))
             elif task['type'] ==  'finish':
                 # 完成写入本地文件
                 if Config.save_audio:
                     finish_file(file)
 
+                # 补上语音末尾的 padding，其余的静音不再上传
+                if gate:
+                    for kind, samples in gate.finish():
+                        message = build_message(task_id, time_start, task['time'], samples)
+                        asyncio.create_task(send_message(message))
+
                 console.print(f'任务标识：{task_id}')
                 console.print(f'    录音时长：{duration:.2f}s')
 
                 # 告诉服务端音频片段结束了
-                message = {
-                    'task_id': task_id,
-                    'seg_duration': 15,
-                    'seg_overlap': 2,
-                    'is_final': True,
-                    'time_start': time_start,
-                    'time_frame': task['time'],
-                    'source': 'mic',
-                    'data': '',
-                }
+                message = build_final_message(task_id, time_start, task['time'])
                 task = asyncio.create_task(send_message(message))
                 break
     except Exception as e:
@@ -7,6 +7,7 @@ import asyncio
 from threading import Event
 from concurrent.futures import ThreadPoolExecutor
 from util.client_send_audio import send_audio
+from util.client_stream import drain_ring
 from util.my_status import Status
 
 
@@ -42,7 +43,8 @@ def launch_task():
         Cosmic.loop
     )
 
-    # 通知录音线程可以向队列放数据了
+    # 丢弃环形缓冲区中上次残留的数据（如取消的录音），再通知录音线程可以写数据了
+    discard_ring()
     Cosmic.on = t1
 
     # 打印动画：正在录音
@@ -55,6 +57,16 @@ def launch_task():
     )
 
 
+def discard_ring():
+    """
+    丢弃此刻之前写入环形缓冲区、还没取走的数据
+    丢弃由读取端（事件循环）执行，排在上次 finish 的 drain_ring 之后，不会吞掉上一句的结尾；
+    只丢弃记下的位置之前的数据，之后开始录的音频保留
+    """
+    mark = Cosmic.ring.written
+    Cosmic.loop.call_soon_threadsafe(Cosmic.ring.discard_until, mark)
+
+
 def cancel_task():
     # 通知停止录音，关掉滚动条
     Cosmic.on = False
@@ -71,7 +83,9 @@ def finish_task():
     Cosmic.on = False
     status.stop()
 
-    # 通知结束任务
+    # 先取出环形缓冲区中剩余的音频，再通知结束任务
+    # 两者按提交顺序在事件循环中执行
+    Cosmic.loop.call_soon_threadsafe(drain_ring, True)
     asyncio.run_coroutine_threadsafe(
         Cosmic.queue_in.put(
             {'type': 'finish',
@@ -165,6 +179,40 @@ def hold_mode(e: keyboard.KeyboardEvent):
 
 
 
+# ======================免提模式==================================
+
+
+def hands_free_start():
+    """开始监听，麦克风数据持续流入队列，由 hands_free_loop 按语音段处理"""
+    discard_ring()
+    Cosmic.on = time.time()
+    console.print('[green]免提模式：正在监听\n')
+
+
+def hands_free_pause():
+    """暂停监听，正在说的这段话照常识别"""
+    Cosmic.on = False
+    Cosmic.loop.call_soon_threadsafe(drain_ring, True)
+    asyncio.run_coroutine_threadsafe(
+        Cosmic.queue_in.put({'type': 'finish', 'time': time.time(), 'data': None}),
+        Cosmic.loop
+    )
+    console.print('[yellow]免提模式：已暂停\n')
+
+
+def hands_free_mode(e: keyboard.KeyboardEvent):
+    """按一下快捷键，暂停或恢复监听"""
+    if e.event_type != 'down':
+        return
+    if Cosmic.on:
+        hands_free_pause()
+    else:
+        hands_free_start()
+
+
+
+
+
 # ==================== 绑定 handler ===============================
 
 
@@ -188,8 +236,21 @@ def click_handler(e: keyboard.KeyboardEvent) -> None:
     click_mode(e)
 
 
+def hands_free_handler(e: keyboard.KeyboardEvent) -> None:
+
+    # 验证按键名正确
+    if not shortcut_correct(e):
+        return
+
+    # 免提模式
+    hands_free_mode(e)
+
+
 def bond_shortcut():
-    if Config.hold_mode:
+    if Config.hands_free:
+        # 免提模式，快捷键只用于暂停和恢复，阻塞掉以免切换大小写
+        keyboard.hook_key(Config.shortcut, hands_free_handler, suppress=True)
+    elif Config.hold_mode:
         keyboard.hook_key(Config.shortcut, hold_handler, suppress=Config.suppress)
     else:
         # 单击模式，必须得阻塞快捷键
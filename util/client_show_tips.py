@@ -45,6 +45,8 @@ def show_mic_tips():
     console.print(f'\n当前基文件夹：[cyan underline]{os.getcwd()}')
     console.print(f'\n服务端地址： [cyan underline]{Config.addr}:{Config.port}')
     console.print(f'\n当前所用快捷键：[green4]{Config.shortcut}')
+    if Config.hands_free:
+        console.print(f'\n免提模式：[green4]已开启[/]，检测到说话自动识别，按 {Config.shortcut} 暂停或恢复')
 
     console.line()
 
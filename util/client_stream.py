@@ -1,5 +1,7 @@
 
 from util.client_cosmic import console, Cosmic
+from util.client_ring_buffer import create_ring_buffer
+from config import ClientConfig as Config
 import numpy as np 
 import sounddevice as sd
 import asyncio
@@ -13,17 +15,50 @@ def record_callback(indata: np.ndarray,
                     frames: int,
                     time_info,
                     status: sd.CallbackFlags) -> None:
+    # 回调线程只把数据写入环形缓冲区，不唤醒事件循环
     if not Cosmic.on:
         return
-    asyncio.run_coroutine_threadsafe(
-        Cosmic.queue_in.put(
+    Cosmic.ring.write(indata)
+
+
+overflow_reported = 0
+
+
+def drain_ring(flush: bool = False):
+    """
+    从环形缓冲区按固定批次长度取出音频，放入队列
+    flush 为真时，把不足一个批次的剩余数据也一并取出
+    """
+    global overflow_reported
+
+    ring = Cosmic.ring
+    if ring is None:
+        return
+
+    # 事件循环被阻塞太久，缓冲区满了，新录的音频被丢弃
+    overflow = ring.overflow
+    if overflow < overflow_reported:        # 缓冲区重建或重置过
+        overflow_reported = 0
+    if overflow > overflow_reported:
+        lost = (overflow - overflow_reported) / 48000
+        console.print(f'[yellow]录音缓冲区已满，丢弃了 {lost:.2f} 秒音频，可调大 mic_ring_duration')
+        overflow_reported = overflow
+    chunk = int(Config.mic_chunk_duration * 48000)
+    while ring.available() >= chunk or (flush and ring.available()):
+        Cosmic.queue_in.put_nowait(
             {'type': 'data',
              'time': time.time(),
-             'data': indata.copy(),
+             'data': ring.read(chunk),
              },
-        ),
-        Cosmic.loop
-    )
+        )
+
+
+async def stream_drain():
+    """按批次间隔定时搬运录音数据，录音时事件循环每个批次才被唤醒一次"""
+    while True:
+        await asyncio.sleep(Config.mic_chunk_duration)
+        if Cosmic.on:
+            drain_ring()
 
 
 def stream_close(signum, frame):
@@ -61,6 +96,9 @@ def stream_open():
         console.print("没有找到麦克风设备", end='\n\n', style='bright_red')
         input('按回车键退出'); sys.exit()
 
+    # 预先分配好环形缓冲区，回调中不再分配内存
+    Cosmic.ring = create_ring_buffer(int(Config.mic_ring_duration * 48000), channels)
+
     stream = sd.InputStream(
         samplerate=48000,
         blocksize=int(0.05 * 48000),  # 0.05 seconds
@@ -18,10 +18,17 @@ import colorama
 from util import srt_from_txt
 from util.client_cosmic import console, Cosmic
 from util.client_check_websocket import check_websocket
+from util.client_search_index import index_result
 from config import ClientConfig as Config
 
 
 
+class Job:
+    """正在转录的文件，连接中断后续传要用"""
+    task_id = ''
+    data = b''
+
+
 async def transcribe_check(file: Path):
     # 检查连接
     if not await check_websocket():
@@ -38,7 +45,7 @@ async def transcribe_send(file: Path):
     websocket = Cosmic.websocket
 
     # 生成任务 id
-    task_id = str(uuid.uuid1())
+    task_id = Job.task_id = str(uuid.uuid1())
     console.print(f'\n任务标识：{task_id}')
     console.print(f'    处理文件：{file}')
 
@@ -53,12 +60,17 @@ async def transcribe_send(file: Path):
     ]
     process = subprocess.Popen(ffmpeg_cmd, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
     console.print(f'    正在提取音频', end='\r')
-    data = process.stdout.read()
+    data = Job.data = process.stdout.read()
     audio_duration = len(data) / 4 / 16000
     console.print(f'    音频长度：{audio_duration:.2f}s')
 
-    # 构建分段消息，发送给服务端
-    offset = 0
+    await send_chunks(websocket, 0)
+
+
+async def send_chunks(websocket, offset: int):
+    # 从 offset 字节处开始，构建分段消息，发送给服务端
+    task_id, data = Job.task_id, Job.data
+    audio_duration = len(data) / 4 / 16000
     while True:
         chunk_end = offset + 16000*4*60
         is_final = False if chunk_end < len(data) else True
@@ -70,28 +82,58 @@ async def transcribe_send(file: Path):
             'time_start': time.time(),              # 录音起始时间
             'time_frame': time.time(),              # 该帧时间
             'source': 'file',                       # 数据来源：从文件读的数据
+            'diarize': Config.file_diarize,         # 是否标注说话人
             'data': base64.b64encode(
                         data[offset: chunk_end]
                     ).decode('utf-8'),
         }
         offset = chunk_end
         progress = min(offset / 4 / 16000, audio_duration)
-        await websocket.send(json.dumps(message))
+        try:
+            await websocket.send(json.dumps(message))
+        except websockets.ConnectionClosed:
+            return      # 连接中断时停止发送，由 transcribe_recv 重连后续传
         console.print(f'    发送进度：{progress:.2f}s', end='\r')
         if is_final:
             break
 
-async def transcribe_recv(file: Path):
+async def transcribe_resume():
+    # 重连服务端，询问任务状态
+    console.print(f'\n    连接中断，正在重连', end='\r')
+    while not await check_websocket():
+        await asyncio.sleep(2)
+    await Cosmic.websocket.send(json.dumps({'type': 'resume', 'task_id': Job.task_id}))
 
-    # 获取连接
-    websocket = Cosmic.websocket
 
-    # 接收结果
-    async for message in websocket:
-        message = json.loads(message)
-        console.print(f'    转录进度: {message["duration"]:.2f}s', end='\r')
-        if message['is_final']:
-            break
+async def transcribe_recv(file: Path):
+
+    # 接收结果，连接中断就重连，服务端重启后也能接着转录
+    message = {}
+    while not message.get('is_final'):
+        try:
+            async for message in Cosmic.websocket:
+                message = json.loads(message)
+
+                # 服务端告知已接收到哪里，缺的部分补发
+                if message.get('type') == 'state':
+                    console.print(f'    已重连，服务端已接收 {message["received"]:.2f}s')
+                    if not message['complete']:
+                        start = int(message['received'] * 16000) * 4
+                        asyncio.create_task(send_chunks(Cosmic.websocket, start))
+                    continue
+
+                # 说话人分离的进度
+                if message.get('type') == 'diarize':
+                    console.print(f'    说话人分离进度: {message["progress"]:.0%}', end='\r')
+                    continue
+
+                console.print(f'    转录进度: {message["duration"]:.2f}s', end='\r')
+                if message['is_final']:
+                    break
+        except websockets.ConnectionClosed:
+            pass
+        if not message.get('is_final'):
+            await transcribe_resume()
 
     # 解析结果
     text_merge = message['text']
@@ -110,8 +152,16 @@ async def transcribe_recv(file: Path):
     with open(txt_filename, "w", encoding="utf-8") as f:
         f.write(text_split)
     with open(json_filename, "w", encoding="utf-8") as f:
-        json.dump({'timestamps': timestamps, 'tokens': tokens}, f, ensure_ascii=False)
+        info = {'timestamps': timestamps, 'tokens': tokens}
+        if 'speakers' in message:
+            info['speakers'] = message['speakers']      # 每个 token 的说话人编号
+            info['segments'] = message['segments']      # 说话片段：[开始, 结束, 说话人编号]
+            info['speaker_names'] = message.get('speaker_names', {})  # 认出的说话人：{编号: 名字}
+        if message.get('skipped'):
+            info['skipped'] = message['skipped']        # 没有人声、未识别的区间：[开始, 结束]
+        json.dump(info, f, ensure_ascii=False)
     srt_from_txt.one_task(txt_filename)
+    index_result(text_merge, message['time_start'], Path(file).absolute(), tokens, timestamps, 'file')
 
     process_duration = message['time_complete'] - message['time_start']
     console.print(f'\033[K    处理耗时：{process_duration:.2f}s')
@@ -0,0 +1,155 @@
+from pathlib import Path
+from typing import List, Tuple, Union
+
+import numpy as np
+
+from config import ClientConfig as Config
+from util.client_cosmic import console
+
+
+'''
+客户端语音活动检测，用于在上传前丢弃多余的静音
+
+有 silero_vad 模型且装了 sherpa_onnx 时，用 sherpa_onnx 的 VoiceActivityDetector；
+否则退回到基于能量的检测。
+
+VadGate 在检测结果之上决定哪些音频要上传：
+    语音前后各保留 vad_padding 秒静音
+    更长的停顿只保留两端的 padding，中间丢弃，并在此处插入一个停顿标记，
+    服务端可以在停顿标记处切分片段，提前开始识别
+    松开按键时，末尾多余的静音直接丢弃
+'''
+
+
+samplerate = 16000
+
+
+class EnergyVad:
+    """基于能量的语音检测，噪声底噪自适应跟踪"""
+
+    frame = int(0.02 * samplerate)      # 20ms 一帧
+
+    def __init__(self):
+        self.noise_db = -60.0
+
+    def is_speech(self, samples: np.ndarray) -> bool:
+        n = len(samples) // self.frame * self.frame
+        if not n:
+            return False
+        frames = samples[:n].reshape(-1, self.frame)
+        energy = np.mean(frames * frames, axis=1) + 1e-10
+        db = 10 * np.log10(energy)
+
+        # 噪声估计：遇到更安静的帧立即下调，否则缓慢上调
+        quiet = float(db.min())
+        if quiet < self.noise_db:
+            self.noise_db = quiet
+        else:
+            self.noise_db += 0.05 * (quiet - self.noise_db)
+
+        threshold = max(self.noise_db + Config.vad_energy_margin, Config.vad_energy_floor)
+        return bool(np.any(db > threshold))
+
+
+class SileroVad:
+    """sherpa_onnx 的 VoiceActivityDetector"""
+
+    def __init__(self, model: Path):
+        import sherpa_onnx
+        config = sherpa_onnx.VadModelConfig()
+        config.silero_vad.model = str(model)
+        config.silero_vad.min_silence_duration = Config.vad_padding
+        config.sample_rate = samplerate
+        self.vad = sherpa_onnx.VoiceActivityDetector(config, buffer_size_in_seconds=30)
+
+    def is_speech(self, samples: np.ndarray) -> bool:
+        self.vad.accept_waveform(samples)
+        speech = self.vad.is_speech_detected()
+
+        # 分段结果由服务端处理，这里只需要检测状态，及时清掉缓存的分段
+        while not self.vad.empty():
+            self.vad.pop()
+        return speech
+
+
+def create_vad() -> Union[EnergyVad, SileroVad]:
+    model = Path(Config.vad_model)
+    if model.exists():
+        try:
+            return SileroVad(model)
+        except Exception as e:
+            console.print(f'载入 VAD 模型失败，改用能量检测：{e}', style='bright_red')
+    return EnergyVad()
+
+
+class VadGate:
+    """
+    输入 16k 单声道音频块，输出要上传的内容：
+        ('data', samples)   要发送的音频
+        ('pause', None)     此处有被丢弃的长停顿
+    """
+
+    def __init__(self):
+        self.vad = create_vad()
+        self.padding = int(Config.vad_padding * samplerate)
+        self.spoken = False             # 是否已经出现过语音
+        self.head = []                  # 停顿开头的静音，最多 padding 长
+        self.head_len = 0
+        self.tail = []                  # 停顿末尾的静音，最多 padding 长
+        self.tail_len = 0
+        self.dropped = 0                # 停顿中被丢弃的采样数
+
+    def push(self, samples: np.ndarray) -> List[Tuple[str, Union[None, np.ndarray]]]:
+        if not self.vad.is_speech(samples):
+            self._hold(samples)
+            return []
+
+        out = []
+        if self.head:
+            out.append(('data', np.concatenate(self.head)))
+        if self.dropped:
+            out.append(('pause', None))
+        if self.tail:
+            out.append(('data', np.concatenate(self.tail)))
+        out.append(('data', samples))
+
+        self.spoken = True
+        self.head.clear(); self.head_len = 0
+        self.tail.clear(); self.tail_len = 0
+        self.dropped = 0
+        return out
+
+    def finish(self) -> List[Tuple[str, Union[None, np.ndarray]]]:
+        # 松开按键：只补上语音后的 padding，末尾其余静音丢弃
+        out = []
+        if self.head:
+            out.append(('data', np.concatenate(self.head)))
+        self.head.clear(); self.head_len = 0
+        self.tail.clear(); self.tail_len = 0
+        self.dropped = 0
+        return out
+
+    def _hold(self, samples: np.ndarray):
+        # 语音之后的静音先放到 head，直到 padding 填满
+        if self.spoken and self.head_len < self.padding:
+            take = min(len(samples), self.padding - self.head_len)
+            self.head.append(samples[:take])
+            self.head_len += take
+            samples = samples[take:]
+            if not len(samples):
+                return
+
+        # 其余静音放到 tail，只保留最后 padding 长度，超出的部分丢弃
+        self.tail.append(samples)
+        self.tail_len += len(samples)
+        while self.tail and self.tail_len - len(self.tail[0]) >= self.padding:
+            first = self.tail.pop(0)
+            self.tail_len -= len(first)
+            if self.spoken:
+                self.dropped += len(first)
+        if self.tail_len > self.padding:
+            cut = self.tail_len - self.padding
+            self.tail[0] = self.tail[0][cut:]
+            self.tail_len -= cut
+            if self.spoken:
+                self.dropped += cut
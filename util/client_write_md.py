@@ -1,8 +1,14 @@
-from util.hot_kwds import kwd_list
+from util import hot_kwds
 import time
+import atexit
+import threading
+from queue import Queue, Empty
+from collections import OrderedDict
 from pathlib import Path
 from os import makedirs
 
+from config import ClientConfig as Config
+
 # def do_updata_kwd(kwd_text: str):
 #     """
 #     把关键词文本中的每一行去除多余空格后添加到列表，
@@ -30,35 +36,96 @@ header_md = r'''```txt
 '''
 
 
-def create_md(file_md):
-    with open(file_md, 'w', encoding="utf-8") as f:
-        f.write(header_md)
+class DiaryWriter:
+    """
+    后台写日记的线程
+
+    write_md 只把要写的行放进队列就返回，打字不必等待文件读写。
+    线程保持最近用过的 md 文件处于打开状态，每隔 diary_flush 秒、或退出时刷新到磁盘。
+    """
+
+    def __init__(self):
+        self.queue: Queue = Queue()
+        self.files: OrderedDict = OrderedDict()     # md 路径 -> 打开的文件，最近用过的在后
+        self.dirty = False
+        self.thread = threading.Thread(target=self.run, daemon=True)
+        self.thread.start()
+        atexit.register(self.close)
+
+    def put(self, file_md: Path, line: str):
+        self.queue.put((file_md, line))
+
+    def run(self):
+        last_flush = time.time()
+        while True:
+            try:
+                item = self.queue.get(timeout=Config.diary_flush)
+            except Empty:
+                item = None
+            if item is not None:
+                file_md, line = item
+                if file_md is None:             # 退出信号
+                    self.flush()
+                    self.queue.task_done()
+                    return
+                self.open(file_md).write(line)
+                self.dirty = True
+                self.queue.task_done()
+            if time.time() - last_flush >= Config.diary_flush:
+                self.flush()
+                last_flush = time.time()
+
+    def open(self, file_md: Path):
+        if file_md in self.files:
+            self.files.move_to_end(file_md)
+            return self.files[file_md]
+
+        # 同时打开的文件太多，关掉最久没用的
+        while len(self.files) >= Config.diary_open_files:
+            _, f = self.files.popitem(last=False)
+            f.close()
+
+        makedirs(file_md.parent, exist_ok=True)
+        f = open(file_md, 'a', encoding='utf-8')
+        if f.tell() == 0:
+            f.write(header_md)
+        self.files[file_md] = f
+        return f
+
+    def flush(self):
+        if not self.dirty:
+            return
+        for f in self.files.values():
+            f.flush()
+        self.dirty = False
+
+    def close(self):
+        # 写完队列中剩下的行再退出
+        if self.thread.is_alive():
+            self.queue.put((None, None))
+            self.thread.join(timeout=5)
+        for f in self.files.values():
+            f.close()
+        self.files.clear()
+
+
+writer = None
 
 
 def write_md(text: str, time_start: float, file_audio: Path):
-
+    global writer
+    if writer is None:
+        writer = DiaryWriter()
 
     time_year = time.strftime('%Y', time.localtime(time_start))
     time_month = time.strftime('%m', time.localtime(time_start))
     time_day = time.strftime('%d', time.localtime(time_start))
     time_hms = time.strftime('%H:%M:%S', time.localtime(time_start))
     folder_path = Path() / time_year / time_month
-    makedirs(folder_path, exist_ok=True)
-
-    # 列表内的元素是元组，元组内包含了：关键词、md路径
-    md_list = [(kwd, folder_path / f'{kwd + "-" if kwd else ""}{time_day}.md')
-               for kwd in kwd_list
-               if text.startswith(kwd)]
-
-    # 为 md 文件写入识别记录
-    for kwd, file_md in md_list:
-
-        # 确保 md 文件存在
-        if not file_md.exists():
-            create_md(file_md)
 
-        # 写入 md
-        with open(file_md, 'a', encoding="utf-8") as f:
-            path_ = file_audio.relative_to(file_md.parent).as_posix().replace(" ", "%20")
-            text_ = text[len(kwd):].lstrip("，。,.")
-            f.write(f'[{time_hms}]({path_}) {text_}\n\n')
+    # 一次前缀树查找得到所有匹配的关键词，空关键词对应当天的日记
+    for kwd in hot_kwds.match_kwds(text):
+        file_md = folder_path / f'{kwd + "-" if kwd else ""}{time_day}.md'
+        path_ = file_audio.relative_to(file_md.parent).as_posix().replace(" ", "%20")
+        text_ = text[len(kwd):].lstrip("，。,.")
+        writer.put(file_md, f'[{time_hms}]({path_}) {text_}\n\n')
@@ -1,5 +1,6 @@
 import re
 from string import digits, ascii_letters
+from util.native import native
 
 en_in_zh = re.compile(r"""(?ix)    # i 表示忽略大小写，x 表示开启注释模式
     ([\u4e00-\u9fa5]|[a-z0-9]+\s)?      # 左侧是中文，或者英文加空格
@@ -37,6 +38,8 @@ def replacer(original: re.Match):
     return final
 
 def adjust_space(txt):
+    if native:
+        return native.adjust_space(txt)
     return en_in_zh.sub(replacer, txt)
 
 if __name__ == '__main__':
@@ -0,0 +1,295 @@
+import re
+import struct
+import subprocess
+import time
+from pathlib import Path
+from typing import Dict, List, Tuple
+
+import numpy as np
+
+
+'''
+领域语法解码图
+
+把领域语法（或词表）和模型的 token 表编译成 CTC 解码图（TLG），
+交给 sherpa-onnx 的 CTC FST 解码器（ctc_fst_decoder_config 的 graph），
+只在语法允许的句子里搜索，口令、零件号、医嘱这类窄领域的识别又快又准。
+
+语法文件每行一条，支持：
+    (甲|乙|丙)      多选一
+    [请]            可省略
+    # 注释
+例如：[请]打开(浏览器|终端|系统设置)
+
+L∘G：语法展开成短语后，按 token 序列建一棵前缀树（相当于确定化后的 L∘G）
+T：  在前缀树上展开 CTC 拓扑：每个节点分「刚输出某 token」和「刚输出 blank」两个状态，
+     blank 可以自环，刚输出的 token 可以重复（合并为一个），相同 token 连续出现时中间必须隔一个 blank
+
+输出 OpenFst 的 VectorFst 二进制格式，输入标签是 token id + 1（0 留给 epsilon），与 sherpa-onnx 一致。
+
+用法：
+    python -m util.grammar_graph compile 语法.txt tokens.txt graph.fst [--bpe-model bpe.model] [--loop]
+    python -m util.grammar_graph bench 测试集.tsv tokens.txt model.onnx graph.fst
+测试集每行：音频路径<Tab>参考文本，bench 分别用自由解码和语法图解码，比较字错率和实时率。
+'''
+
+
+max_phrases = 200000        # 语法展开的短语数上限
+
+
+# ==================== 语法展开 ====================
+
+
+def expand(rule: str) -> List[str]:
+    """展开 (a|b) 和 [a]，返回所有短语"""
+    def parse(s: str, i: int, end: str) -> Tuple[List[str], int]:
+        # 解析到 end 字符（或 '|'）为止，返回 (展开结果, 位置)
+        alternatives, current = [], ['']
+        while i < len(s):
+            c = s[i]
+            if c in '([':
+                close = ')' if c == '(' else ']'
+                inner, i = parse(s, i + 1, close)
+                if c == '[':
+                    inner = inner + ['']
+                current = [a + b for a in current for b in inner]
+                if len(current) > max_phrases:
+                    raise ValueError(f'展开的短语超过 {max_phrases} 条：{s}')
+            elif c == '|':
+                alternatives += current
+                current = ['']
+            elif c == end:
+                return alternatives + current, i
+            else:
+                current = [a + c for a in current]
+            i += 1
+        if end:
+            raise ValueError(f'括号不匹配：{s}')
+        return alternatives + current, i
+
+    phrases, _ = parse(rule, 0, '')
+    return [p.strip() for p in phrases if p.strip()]
+
+
+def load_grammar(file: Path) -> List[str]:
+    phrases = []
+    for line in file.read_text(encoding='utf-8').splitlines():
+        line = line.split('#', 1)[0].strip()
+        if line:
+            phrases += expand(line)
+    return list(dict.fromkeys(phrases))
+
+
+# ==================== 词典 ====================
+
+
+def load_tokens(file: Path) -> Dict[str, int]:
+    tokens = {}
+    for line in file.read_text(encoding='utf-8').splitlines():
+        parts = line.split()
+        if len(parts) == 2:
+            tokens[parts[0]] = int(parts[1])
+        elif len(parts) == 1:
+            # 空格本身作为 token 时，行里只剩 id
+            tokens[' '] = int(parts[0])
+    return tokens
+
+
+def tokenize(phrase: str, tokens: Dict[str, int], sp=None) -> List[int]:
+    """短语转 token id，有 token 不在表中时返回空"""
+    if sp:
+        pieces = sp.encode(phrase, out_type=str)
+    else:
+        # 按字切分，连续的英文字母和数字视为一个词，按原样、大写、加词首标记 ▁ 去词表中找
+        pieces = []
+        for word in re.findall(r'[A-Za-z0-9]+|\S', phrase):
+            candidates = [word, f'▁{word}', word.upper(), f'▁{word.upper()}']
+            pieces.append(next((c for c in candidates if c in tokens), word))
+    if any(p not in tokens for p in pieces):
+        return []
+    return [tokens[p] for p in pieces]
+
+
+# ==================== 建图 ====================
+
+
+class Graph:
+    def __init__(self):
+        self.arcs: List[List[Tuple[int, int, float, int]]] = []     # 状态 -> [(输入, 输出, 权重, 下一状态)]
+        self.finals: Dict[int, float] = {}
+
+    def add_state(self) -> int:
+        self.arcs.append([])
+        return len(self.arcs) - 1
+
+    def add_arc(self, src: int, ilabel: int, olabel: int, dst: int, weight: float = 0.0):
+        self.arcs[src].append((ilabel, olabel, weight, dst))
+
+    def write(self, file: Path):
+        """OpenFst VectorFst 二进制格式（tropical 半环）"""
+        def string(s: str) -> bytes:
+            b = s.encode()
+            return struct.pack('<i', len(b)) + b
+
+        num_arcs = sum(len(a) for a in self.arcs)
+        with open(file, 'wb') as f:
+            f.write(struct.pack('<i', 2125659606))          # magic
+            f.write(string('vector') + string('standard'))
+            f.write(struct.pack('<ii', 2, 0))               # version, flags
+            f.write(struct.pack('<Q', 0x1))                 # properties: kExpanded
+            f.write(struct.pack('<qqq', 0, len(self.arcs), num_arcs))
+            for state, arcs in enumerate(self.arcs):
+                f.write(struct.pack('<f', self.finals.get(state, float('inf'))))
+                f.write(struct.pack('<q', len(arcs)))
+                for ilabel, olabel, weight, dst in arcs:
+                    f.write(struct.pack('<iifi', ilabel, olabel, weight, dst))
+
+    def write_text(self, file: Path):
+        """OpenFst 文本格式，便于检查或用 fstcompile 转换"""
+        with open(file, 'w', encoding='utf-8') as f:
+            for state, arcs in enumerate(self.arcs):
+                for ilabel, olabel, weight, dst in arcs:
+                    f.write(f'{state}\t{dst}\t{ilabel}\t{olabel}\t{weight}\n')
+                if state in self.finals:
+                    f.write(f'{state}\t{self.finals[state]}\n')
+
+
+def build_graph(sequences: List[List[int]], blank: int = 0, loop: bool = False) -> Graph:
+    """
+    在 token 前缀树上展开 CTC 拓扑，标签都是 token id + 1
+    loop 为真时，一条短语结束后可以接着说下一条
+    """
+    # 前缀树：节点 -> {token: 子节点}
+    children: List[Dict[int, int]] = [{}]
+    ends = set()
+    for seq in sequences:
+        node = 0
+        for t in seq:
+            if t not in children[node]:
+                children[node][t] = len(children)
+                children.append({})
+            node = children[node][t]
+        ends.add(node)
+
+    # 每个节点两个状态：刚输出 blank，刚输出 token（根节点只有前者）
+    g = Graph()
+    after_blank = [g.add_state() for _ in children]
+    after_token = [g.add_state() if n else -1 for n in range(len(children))]
+    last_token = {child: t for node in children for t, child in node.items()}
+
+    b = blank + 1
+    for n, kids in enumerate(children):
+        # 短语结尾可以接着从根节点开始
+        targets = dict(kids)
+        if loop and n in ends:
+            targets.update({t: c for t, c in children[0].items() if t not in targets})
+
+        # 刚输出 blank：blank 自环，任意子节点
+        g.add_arc(after_blank[n], b, 0, after_blank[n])
+        for t, c in targets.items():
+            g.add_arc(after_blank[n], t + 1, t + 1, after_token[c])
+
+        if n:
+            # 刚输出 token：同一个 token 重复（合并），blank 转过去，不同的 token 直接到子节点
+            t0 = last_token[n]
+            g.add_arc(after_token[n], t0 + 1, 0, after_token[n])
+            g.add_arc(after_token[n], b, 0, after_blank[n])
+            for t, c in targets.items():
+                if t != t0:
+                    g.add_arc(after_token[n], t + 1, t + 1, after_token[c])
+
+        if n in ends:
+            g.finals[after_blank[n]] = 0.0
+            g.finals[after_token[n]] = 0.0
+    return g
+
+
+def compile_grammar(grammar: Path, tokens_file: Path, output: Path,
+                    bpe_model: str = '', loop: bool = False, text: bool = False):
+    tokens = load_tokens(tokens_file)
+    sp = None
+    if bpe_model:
+        import sentencepiece
+        sp = sentencepiece.SentencePieceProcessor(model_file=bpe_model)
+
+    phrases = load_grammar(grammar)
+    sequences, oov = [], []
+    for phrase in phrases:
+        seq = tokenize(phrase, tokens, sp)
+        (sequences if seq else oov).append(seq or phrase)
+    for phrase in oov[:10]:
+        print(f'跳过含有模型词表外 token 的短语：{phrase}')
+    if not sequences:
+        raise SystemExit('没有可用的短语')
+
+    g = build_graph(sequences, blank=tokens.get('<blk>', tokens.get('<blank>', 0)), loop=loop)
+    g.write(output)
+    if text:
+        g.write_text(output.with_suffix('.txt'))
+    num_arcs = sum(len(a) for a in g.arcs)
+    print(f'短语 {len(sequences)} 条（跳过 {len(oov)} 条），状态 {len(g.arcs)}，弧 {num_arcs}：{output}')
+
+
+# ==================== 对比测试 ====================
+
+
+def read_audio(file: Path) -> np.ndarray:
+    # ffmpeg 输出采样率 16000，单声道，float32 格式
+    ffmpeg_cmd = ["ffmpeg", "-i", file, "-f", "f32le", "-ac", "1", "-ar", "16000", "-"]
+    process = subprocess.Popen(ffmpeg_cmd, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+    return np.frombuffer(process.stdout.read(), dtype=np.float32)
+
+
+def edit_distance(a: str, b: str) -> int:
+    row = list(range(len(b) + 1))
+    for i, ca in enumerate(a, 1):
+        prev, row[0] = row[0], i
+        for j, cb in enumerate(b, 1):
+            prev, row[j] = row[j], min(row[j] + 1, row[j - 1] + 1, prev + (ca != cb))
+    return row[-1]
+
+
+def decode_all(recognizer, samples: List[np.ndarray]) -> Tuple[List[str], float]:
+    texts, t1 = [], time.time()
+    for s in samples:
+        stream = recognizer.create_stream()
+        stream.accept_waveform(16000, s)
+        stream.accept_waveform(16000, np.zeros(int(0.3 * 16000), dtype=np.float32))
+        stream.input_finished()
+        while recognizer.is_ready(stream):
+            recognizer.decode_stream(stream)
+        texts.append(recognizer.get_result(stream).strip())
+    return texts, time.time() - t1
+
+
+def bench(testset: Path, tokens: Path, model: Path, graph: Path, max_active: int = 3000, num_threads: int = 2):
+    import sherpa_onnx
+
+    pairs = [line.split('\t', 1) for line in testset.read_text(encoding='utf-8').splitlines() if '\t' in line]
+    samples = [read_audio(Path(a)) for a, _ in pairs]
+    refs = [r.strip().replace(' ', '') for _, r in pairs]
+    duration = sum(len(s) for s in samples) / 16000
+
+    for name, kwargs in (('自由解码', {}), ('语法解码', {'ctc_graph': str(graph), 'ctc_max_active': max_active})):
+        recognizer = sherpa_onnx.OnlineRecognizer.from_zipformer2_ctc(
+            tokens=str(tokens), model=str(model), num_threads=num_threads, **kwargs)
+        texts, elapsed = decode_all(recognizer, samples)
+        errors = sum(edit_distance(h.replace(' ', ''), r) for h, r in zip(texts, refs))
+        exact = sum(h.replace(' ', '') == r for h, r in zip(texts, refs))
+        print(f'{name}：字错率 {errors / max(1, sum(map(len, refs))):.2%}，'
+              f'整句正确 {exact}/{len(refs)}，实时率 {elapsed / max(duration, 1e-9):.3f}')
+
+
+def main(command: str, args: List[str], bpe_model: str = '', loop: bool = False, text: bool = False,
+         max_active: int = 3000):
+    if command == 'compile':
+        grammar, tokens, output = map(Path, args)
+        compile_grammar(grammar, tokens, output, bpe_model, loop, text)
+    elif command == 'bench':
+        testset, tokens, model, graph = map(Path, args)
+        bench(testset, tokens, model, graph, max_active)
+
+
+if __name__ == '__main__':
+    import typer
+    typer.run(main)
@@ -1,16 +1,51 @@
+from typing import List
+
 from config import ClientConfig as Config
 
 kwd_list = []
 
+# 关键词前缀树：每个节点是 {字: 子节点}，节点中 END 键的值是以该节点结尾的关键词
+END = ''
+kwd_trie = {END: ''}
+
+
+def build_trie(kwds: List[str]) -> dict:
+    root = {}
+    for kwd in kwds:
+        node = root
+        for char in kwd:
+            node = node.setdefault(char, {})
+        node[END] = kwd
+    return root
+
+
+def match_kwds(text: str) -> List[str]:
+    '''
+    沿前缀树走一遍，返回所有是 text 前缀的关键词（空关键词总在最前）
+    耗时只与最长关键词的长度有关，与关键词数量无关
+    '''
+    node = kwd_trie
+    matched = [node[END]] if END in node else []
+    for char in text:
+        node = node.get(char)
+        if node is None:
+            break
+        if END in node:
+            matched.append(node[END])
+    return matched
+
+
 def do_updata_kwd(kwd_text: str):
     '''
     把关键词文本中的每一行去除多余空格后添加到列表，
     '''
+    global kwd_trie
     kwd_list.clear()
     kwd_list.append('')
 
     # 如果不启用关键词功能，直接返回
     if not Config.hot_kwd:
+        kwd_trie = build_trie(kwd_list)
         return len(kwd_list)
 
     # 更新关键词
@@ -20,4 +55,6 @@ def do_updata_kwd(kwd_text: str):
             continue
         kwd_list.append(kwd)
 
+    # 整棵树建好后再替换，识别线程不会看到建了一半的树
+    kwd_trie = build_trie(kwd_list)
     return len(kwd_list)
@@ -1,4 +1,5 @@
 import re
+from util.native import native
 
 
 
@@ -25,6 +26,8 @@ print(res)
 __all__ = ['更新热词词典', '热词替换']
 
 热词词典 = {}       
+热词列表 = []       # 与匹配器中的模式编号一一对应
+匹配器 = native.HotwordMatcher() if native else None
 
 
 def 更新热词词典(热词文本: str):
@@ -38,6 +41,14 @@ def 更新热词词典(热词文本: str):
         热词 = 热词.strip()
         if not 热词 or 热词.startswith('#'): continue
         热词词典[热词] = re.sub('[^\w]', '', 热词.lower())
+
+    # 把所有热词编译进匹配器，匹配时一次扫描即可
+    if 匹配器 is not None:
+        匹配器.clear()
+        热词列表.clear()
+        for 词, 小写 in 热词词典.items():
+            热词列表.append(词)
+            匹配器.add(小写)
     return len(热词词典)
 
 
@@ -49,6 +60,8 @@ def 匹配热词(句子:str):
 
     所有匹配 = []
     小写无空格句子 = 句子.lower().replace(' ', '')
+    if 匹配器 is not None:
+        return [热词列表[i] for i in 匹配器.find(小写无空格句子)]
     for 词 in 热词词典:
         if 热词词典[词] in 小写无空格句子:
             所有匹配.append(词)
@@ -1,5 +1,6 @@
 from pypinyin import pinyin
 from time import time
+from util.native import native
 
 '''
 热词是每行一个的文本，先更新热词词典，然后再替换句子中的热词。
@@ -31,6 +32,8 @@ __all__ = ['更新热词词典', '热词替换', '多音字', '声调']
 
 
 热词词典 = {}
+匹配表 = []         # (热词, 拼音序列)，与匹配器中的模式编号一一对应
+匹配器 = native.HotwordMatcher() if native else None
 多音字 = True
 声调 = False     # 是否要求匹配声调
 
@@ -85,6 +88,15 @@ def 更新热词词典(热词文本: str):
                 for x in 拼音列表: x.append(多音[0])
         
         热词词典[热词] = 拼音列表
+
+    # 把所有热词的拼音编译进匹配器，匹配时一次扫描即可
+    if 匹配器 is not None:
+        匹配器.clear()
+        匹配表.clear()
+        for 词, 拼音列表 in 热词词典.items():
+            for 拼音序列 in 拼音列表:
+                匹配表.append((词, 拼音序列))
+                匹配器.add(''.join(拼音序列))
     return len(热词词典)
 
 
@@ -97,6 +109,8 @@ def 匹配热词(句子:str):
 
     所有匹配 = []
     句子拼音 = ''.join([x[0] for x in pinyin(句子, 风格, 多音字)])  # 字符串形式的句子拼音
+    if 匹配器 is not None:
+        return [匹配表[i] for i in 匹配器.find(句子拼音)]
     for 词 in 热词词典.keys():
         for 拼音序列 in 热词词典[词]:
             if ''.join(拼音序列) in 句子拼音: 
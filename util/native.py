@@ -0,0 +1,18 @@
+'''
+载入 native 文件夹中编译好的 capswriter_native 扩展模块
+
+编译方法见 native/setup.py。没有编译时 native 为 None，
+各模块会退回到纯 Python 实现，功能不受影响。
+'''
+
+import sys
+from pathlib import Path
+
+native_dir = Path(__file__).resolve().parent.parent / 'native'
+if str(native_dir) not in sys.path:
+    sys.path.append(str(native_dir))
+
+try:
+    import capswriter_native as native
+except ImportError:
+    native = None
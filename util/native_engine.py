@@ -0,0 +1,383 @@
+import ctypes
+import sys
+from pathlib import Path
+from typing import Iterator, List, NamedTuple, Sequence, Tuple
+
+import numpy as np
+
+
+'''
+capswriter_engine 的 Python 绑定（ctypes）
+
+capswriter_engine 是为客户端和服务端共用准备的 C++ 识别引擎，见 native/include/capswriter_engine.h：
+会话管理、环形缓冲、重采样、静音切分、片段拼接、文本管线都在这一份实现里，
+Mac 客户端可以通过 Swift 绑定（NativeEngine.swift）调用同一个库。
+
+目前还没有调用方接入引擎：服务端用离线识别器，只通过 capswriter_native 扩展模块
+（util/native.py）使用同一份 src 中的片段拼接、数字转换、调空格、热词匹配；
+Mac 客户端仍用自己的 Swift 实现（StreamFinalizer 等），改为调用引擎是另一项迁移工作。
+
+编译方法：
+    cmake -S native -B native/build
+    cmake --build native/build
+
+识别后端用 sherpa_onnx 的 OnlineRecognizer，通过回调接入引擎：
+    engine = Engine(recognizer)
+    session = Session(engine, segment=True)
+    session.write(samples); session.process()
+    for result in session.poll(): ...
+
+服务端同时跑大量会话时，用 Scheduler 把各会话凑成批一起解码。
+
+没有编译引擎时 engine_lib 为 None。
+'''
+
+
+vp, i32, f32p = ctypes.c_void_p, ctypes.c_int32, ctypes.POINTER(ctypes.c_float)
+create_stream_fn = ctypes.CFUNCTYPE(vp, vp)
+stream_fn = ctypes.CFUNCTYPE(None, vp, vp)
+stream_flag_fn = ctypes.CFUNCTYPE(i32, vp, vp)
+accept_waveform_fn = ctypes.CFUNCTYPE(None, vp, vp, i32, f32p, i32)
+get_result_fn = ctypes.CFUNCTYPE(vp, vp, vp, ctypes.POINTER(f32p), ctypes.POINTER(i32))
+destroy_fn = ctypes.CFUNCTYPE(None, vp)
+decode_multiple_fn = ctypes.CFUNCTYPE(None, vp, ctypes.POINTER(vp), i32)
+
+
+class cw_backend(ctypes.Structure):
+    _fields_ = [
+        ('user', vp),
+        ('create_stream', create_stream_fn),
+        ('destroy_stream', stream_fn),
+        ('accept_waveform', accept_waveform_fn),
+        ('input_finished', stream_fn),
+        ('is_ready', stream_flag_fn),
+        ('decode', stream_fn),
+        ('is_endpoint', stream_flag_fn),
+        ('reset', stream_fn),
+        ('get_result', get_result_fn),
+        ('destroy', destroy_fn),
+        ('decode_multiple', decode_multiple_fn),
+    ]
+
+
+class cw_text_options(ctypes.Structure):
+    _fields_ = [('spacing', ctypes.c_int32), ('itn', ctypes.c_int32), ('hotwords', ctypes.c_int32)]
+
+
+class cw_session_config(ctypes.Structure):
+    _fields_ = [
+        ('input_sample_rate', ctypes.c_int32),
+        ('input_channels', ctypes.c_int32),
+        ('sample_rate', ctypes.c_int32),
+        ('ring_seconds', ctypes.c_float),
+        ('tail_padding', ctypes.c_float),
+        ('use_endpoint', ctypes.c_int32),
+        ('segment', ctypes.c_int32),
+        ('vad_energy_margin', ctypes.c_float),
+        ('vad_energy_floor', ctypes.c_float),
+        ('preroll', ctypes.c_float),
+        ('min_speech', ctypes.c_float),
+        ('max_silence', ctypes.c_float),
+        ('max_segment', ctypes.c_float),
+    ]
+
+
+class cw_result(ctypes.Structure):
+    _fields_ = [
+        ('is_final', ctypes.c_int32),
+        ('index', ctypes.c_int32),
+        ('start', ctypes.c_double),
+        ('text', ctypes.c_char_p),
+        ('timestamps', ctypes.POINTER(ctypes.c_float)),
+        ('count', ctypes.c_int32),
+    ]
+
+
+class cw_scheduler_config(ctypes.Structure):
+    _fields_ = [('batch_size', ctypes.c_int32), ('partial_deadline', ctypes.c_float), ('tick_budget', ctypes.c_float)]
+
+
+class cw_scheduler_stats(ctypes.Structure):
+    _fields_ = [
+        ('sessions', ctypes.c_int32),
+        ('ticks', ctypes.c_uint64),
+        ('batches', ctypes.c_uint64),
+        ('decoded', ctypes.c_uint64),
+        ('missed', ctypes.c_uint64),
+        ('max_lateness', ctypes.c_double),
+    ]
+
+
+def load_library():
+    names = {'win32': ['capswriter_engine.dll'], 'darwin': ['libcapswriter_engine.dylib']}
+    native_dir = Path(__file__).resolve().parent.parent / 'native'
+    for folder in (native_dir / 'build', native_dir / 'build' / 'Release', native_dir):
+        for name in names.get(sys.platform, ['libcapswriter_engine.so']):
+            if (folder / name).exists():
+                return ctypes.CDLL(str(folder / name))
+    return None
+
+
+def declare(lib):
+    c = ctypes
+    signatures = {
+        'cw_engine_create': (c.c_void_p, [c.POINTER(cw_backend)]),
+        'cw_engine_destroy': (None, [c.c_void_p]),
+        'cw_tail_padding': (c.c_float, [c.c_char_p]),
+        'cw_text_options_default': (cw_text_options, []),
+        'cw_text_pipeline_create': (c.c_void_p, [c.POINTER(cw_text_options)]),
+        'cw_text_pipeline_destroy': (None, [c.c_void_p]),
+        'cw_text_pipeline_add_hotword': (None, [c.c_void_p, c.c_char_p]),
+        'cw_text_pipeline_add_rule': (None, [c.c_void_p, c.c_char_p, c.c_char_p]),
+        'cw_text_pipeline_clear': (None, [c.c_void_p]),
+        'cw_text_pipeline_process': (c.c_void_p, [c.c_void_p, c.c_char_p]),
+        'cw_string_free': (None, [c.c_void_p]),
+        'cw_session_config_default': (cw_session_config, []),
+        'cw_session_create': (c.c_void_p, [c.c_void_p, c.POINTER(cw_session_config)]),
+        'cw_session_destroy': (None, [c.c_void_p]),
+        'cw_session_set_text_pipeline': (None, [c.c_void_p, c.c_void_p]),
+        'cw_session_write': (c.c_int32, [c.c_void_p, c.POINTER(c.c_float), c.c_int32]),
+        'cw_session_process': (c.c_int32, [c.c_void_p]),
+        'cw_session_finish': (c.c_int32, [c.c_void_p]),
+        'cw_session_reset': (None, [c.c_void_p]),
+        'cw_session_poll': (c.c_int32, [c.c_void_p, c.POINTER(cw_result)]),
+        'cw_session_overflow': (c.c_uint64, [c.c_void_p]),
+        'cw_scheduler_config_default': (cw_scheduler_config, []),
+        'cw_scheduler_create': (c.c_void_p, [c.c_void_p, c.POINTER(cw_scheduler_config)]),
+        'cw_scheduler_destroy': (None, [c.c_void_p]),
+        'cw_scheduler_add': (c.c_int32, [c.c_void_p, c.c_void_p, c.c_float]),
+        'cw_scheduler_remove': (None, [c.c_void_p, c.c_void_p]),
+        'cw_scheduler_tick': (c.c_int32, [c.c_void_p]),
+        'cw_scheduler_get_stats': (cw_scheduler_stats, [c.c_void_p]),
+        'cw_seam_merge': (None, [c.POINTER(c.c_char_p), c.c_int32, c.POINTER(c.c_char_p), c.POINTER(c.c_float),
+                                 c.c_int32, c.c_double, c.c_double, c.c_int32, c.c_int32,
+                                 c.POINTER(c.c_int32), c.POINTER(c.c_int32)]),
+    }
+    for name, (restype, argtypes) in signatures.items():
+        f = getattr(lib, name)
+        f.restype, f.argtypes = restype, argtypes
+    return lib
+
+
+try:
+    engine_lib = load_library()
+    if engine_lib:
+        declare(engine_lib)
+except (OSError, AttributeError):
+    engine_lib = None
+
+
+# ==================== 文本管线 ====================
+
+
+class TextPipeline:
+    """调空格 → 中文数字转阿拉伯数字 → 调空格 → 英文热词 → 字面替换规则"""
+
+    def __init__(self, spacing=True, itn=True, hotwords=True):
+        options = cw_text_options(int(spacing), int(itn), int(hotwords))
+        self.handle = engine_lib.cw_text_pipeline_create(ctypes.byref(options))
+
+    def __del__(self):
+        if getattr(self, 'handle', None):
+            engine_lib.cw_text_pipeline_destroy(self.handle)
+
+    def add_hotword(self, hotword: str):
+        engine_lib.cw_text_pipeline_add_hotword(self.handle, hotword.encode())
+
+    def add_rule(self, src: str, dst: str):
+        engine_lib.cw_text_pipeline_add_rule(self.handle, src.encode(), dst.encode())
+
+    def clear(self):
+        engine_lib.cw_text_pipeline_clear(self.handle)
+
+    def process(self, text: str) -> str:
+        p = engine_lib.cw_text_pipeline_process(self.handle, text.encode())
+        if not p:
+            return text
+        try:
+            return ctypes.string_at(p).decode()
+        finally:
+            engine_lib.cw_string_free(p)
+
+
+# ==================== 引擎 ====================
+
+
+class Engine:
+    """用 sherpa_onnx.OnlineRecognizer 作为识别后端"""
+
+    def __init__(self, recognizer):
+        self.recognizer = recognizer
+        # 回调对象要一直持有，否则会被回收；回调不引用 Engine 自身，避免循环引用让析构顺序不确定
+        self.backend = make_backend(recognizer)
+        self.handle = engine_lib.cw_engine_create(ctypes.byref(self.backend))
+
+    def __del__(self):
+        if getattr(self, 'handle', None) and not sys.is_finalizing():
+            engine_lib.cw_engine_destroy(self.handle)
+
+
+def make_backend(recognizer) -> cw_backend:
+    streams = {}            # 句柄 -> [stream, 文字缓存, 时间戳缓存]
+    next_id = [1]
+
+    def create_stream(_):
+        sid = next_id[0]
+        next_id[0] += 1
+        streams[sid] = [recognizer.create_stream(), None, None]
+        return sid
+
+    def accept_waveform(_, sid, sample_rate, samples, n):
+        data = np.ctypeslib.as_array(samples, shape=(n,)).copy()
+        streams[sid][0].accept_waveform(sample_rate, data)
+
+    def get_result(_, sid, timestamps, count):
+        entry = streams[sid]
+        if hasattr(recognizer, 'get_result_all'):
+            result = recognizer.get_result_all(entry[0])
+            text, times = result.text, list(getattr(result, 'timestamps', []))
+        else:
+            text, times = recognizer.get_result(entry[0]), []
+
+        # 缓存到下一次调用，保证返回的指针有效
+        entry[1] = ctypes.create_string_buffer(text.encode())
+        entry[2] = (ctypes.c_float * len(times))(*times) if times else None
+        timestamps[0] = ctypes.cast(entry[2], f32p) if times else f32p()
+        count[0] = len(times)
+        return ctypes.cast(entry[1], ctypes.c_void_p).value
+
+    return cw_backend(
+        create_stream=create_stream_fn(create_stream),
+        destroy_stream=stream_fn(lambda _, sid: streams.pop(sid, None)),
+        accept_waveform=accept_waveform_fn(accept_waveform),
+        input_finished=stream_fn(lambda _, sid: streams[sid][0].input_finished()),
+        is_ready=stream_flag_fn(lambda _, sid: int(recognizer.is_ready(streams[sid][0]))),
+        decode=stream_fn(lambda _, sid: recognizer.decode_stream(streams[sid][0])),
+        is_endpoint=stream_flag_fn(lambda _, sid: int(recognizer.is_endpoint(streams[sid][0]))),
+        # reset 只用于端点切句；结束输入（input_finished）的流，引擎会销毁后重新创建
+        reset=stream_fn(lambda _, sid: recognizer.reset(streams[sid][0])),
+        get_result=get_result_fn(get_result),
+        decode_multiple=decode_multiple_fn(
+            lambda _, sids, n: recognizer.decode_streams([streams[sids[i]][0] for i in range(n)])),
+    )
+
+
+# ==================== 会话 ====================
+
+
+class Result(NamedTuple):
+    is_final: bool
+    index: int
+    start: float
+    text: str
+    timestamps: List[float]
+
+
+class Session:
+    """
+    一路识别会话，参数与 cw_session_config 同名，例如：
+        Session(engine, input_sample_rate=48000, input_channels=2, segment=True)
+    write 可以在录音回调中调用，其他方法在同一个处理线程上调用
+    """
+
+    def __init__(self, engine: Engine, pipeline: TextPipeline = None, **kwargs):
+        config = engine_lib.cw_session_config_default()
+        for key, value in kwargs.items():
+            setattr(config, key, value)
+        self.config = config
+        self.engine = engine
+        self.pipeline = pipeline
+        self.handle = engine_lib.cw_session_create(engine.handle, ctypes.byref(config))
+        if not self.handle:
+            raise ValueError('会话配置无效')
+        if pipeline:
+            engine_lib.cw_session_set_text_pipeline(self.handle, pipeline.handle)
+
+    def __del__(self):
+        # 退出解释器时回调可能已经被回收，销毁会话会回调 destroy_stream，交给进程退出释放
+        if getattr(self, 'handle', None) and not sys.is_finalizing():
+            engine_lib.cw_session_destroy(self.handle)
+
+    def write(self, data: np.ndarray) -> int:
+        data = np.ascontiguousarray(data, dtype=np.float32)
+        frames = len(data) if data.ndim > 1 else len(data) // self.config.input_channels
+        return engine_lib.cw_session_write(
+            self.handle, data.ctypes.data_as(ctypes.POINTER(ctypes.c_float)), frames)
+
+    def process(self) -> int:
+        return engine_lib.cw_session_process(self.handle)
+
+    def finish(self) -> int:
+        return engine_lib.cw_session_finish(self.handle)
+
+    def reset(self):
+        engine_lib.cw_session_reset(self.handle)
+
+    @property
+    def overflow(self) -> int:
+        return engine_lib.cw_session_overflow(self.handle)
+
+    def poll(self) -> Iterator[Result]:
+        r = cw_result()
+        while engine_lib.cw_session_poll(self.handle, ctypes.byref(r)):
+            times = [r.timestamps[i] for i in range(r.count)] if r.timestamps else []
+            yield Result(bool(r.is_final), r.index, r.start, r.text.decode(), times)
+
+
+# ==================== 批量调度 ====================
+
+
+class Scheduler:
+    """
+    多个会话共用一个识别器时，把就绪的音频流凑成批一起解码（decode_streams）
+    参数与 cw_scheduler_config 同名，例如：
+        scheduler = Scheduler(engine, batch_size=8)
+        scheduler.add(session, partial_deadline=0.1)
+        while True:
+            scheduler.tick()            # 每隔几毫秒调用一次
+            for result in session.poll(): ...
+    加入调度器的会话不要再调用 process，调度器和会话都在同一个线程上调用
+    """
+
+    def __init__(self, engine: Engine, **kwargs):
+        config = engine_lib.cw_scheduler_config_default()
+        for key, value in kwargs.items():
+            setattr(config, key, value)
+        self.engine = engine
+        self.handle = engine_lib.cw_scheduler_create(engine.handle, ctypes.byref(config))
+        if not self.handle:
+            raise ValueError('调度器配置无效')
+
+    def __del__(self):
+        if getattr(self, 'handle', None) and not sys.is_finalizing():
+            engine_lib.cw_scheduler_destroy(self.handle)
+
+    def add(self, session: Session, partial_deadline: float = 0) -> bool:
+        """partial_deadline 为这路会话的中间结果截止时间（秒），0 为默认值"""
+        return bool(engine_lib.cw_scheduler_add(self.handle, session.handle, partial_deadline))
+
+    def remove(self, session: Session):
+        engine_lib.cw_scheduler_remove(self.handle, session.handle)
+
+    def tick(self) -> int:
+        return engine_lib.cw_scheduler_tick(self.handle)
+
+    @property
+    def stats(self) -> dict:
+        s = engine_lib.cw_scheduler_get_stats(self.handle)
+        return {name: getattr(s, name) for name, _ in s._fields_}
+
+
+# ==================== 片段拼接 ====================
+
+
+def seam_merge(prev_tokens: Sequence[str], tokens: Sequence[str], timestamps: Sequence[float],
+               overlap, duration, has_prev, is_final) -> Tuple[int, int]:
+    """与 util/server_recognize.seam_merge 一致"""
+    prev = (ctypes.c_char_p * len(prev_tokens))(*[t.encode() for t in prev_tokens])
+    toks = (ctypes.c_char_p * len(tokens))(*[t.encode() for t in tokens])
+    times = (ctypes.c_float * len(timestamps))(*timestamps)
+    m, n = ctypes.c_int32(), ctypes.c_int32()
+    engine_lib.cw_seam_merge(prev, len(prev_tokens), toks, times, len(timestamps), overlap, duration,
+                             int(has_prev), int(is_final), ctypes.byref(m), ctypes.byref(n))
+    return m.value, n.value
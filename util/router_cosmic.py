@@ -0,0 +1,12 @@
+from typing import Dict, Set, TYPE_CHECKING
+from rich.console import Console
+console = Console(highlight=False)
+
+if TYPE_CHECKING:
+    from util.router_nodes import Node
+    from util.router_ws import Session
+
+
+class Cosmic:
+    nodes: Dict[str, 'Node'] = {}       # 节点 id -> 节点
+    sessions: Set['Session'] = set()    # 正在连接的客户端
@@ -0,0 +1,52 @@
+import bisect
+from hashlib import md5
+from typing import Dict, Iterable, List, Union
+
+
+class HashRing:
+    """
+    一致性哈希环
+
+    每个节点在环上放 replicas 个虚拟节点，任务按 task_id 的哈希值顺时针找到第一个节点。
+    节点加入或离开时，只有落在它附近的任务会换节点，其余任务的归属不变。
+    """
+
+    def __init__(self, replicas: int):
+        self.replicas = replicas
+        self.keys: List[int] = []           # 排好序的虚拟节点哈希值
+        self.owners: Dict[int, str] = {}    # 虚拟节点哈希值 -> 节点 id
+
+    @staticmethod
+    def hash(key: str) -> int:
+        return int.from_bytes(md5(key.encode('utf-8')).digest()[:8], 'big')
+
+    def __contains__(self, node_id: str) -> bool:
+        return self.hash(f'{node_id}#0') in self.owners
+
+    def add(self, node_id: str) -> None:
+        for i in range(self.replicas):
+            h = self.hash(f'{node_id}#{i}')
+            if h not in self.owners:
+                bisect.insort(self.keys, h)
+            self.owners[h] = node_id
+
+    def remove(self, node_id: str) -> None:
+        for i in range(self.replicas):
+            h = self.hash(f'{node_id}#{i}')
+            if self.owners.get(h) == node_id:
+                del self.owners[h]
+                self.keys.pop(bisect.bisect_left(self.keys, h))
+
+    def rebuild(self, node_ids: Iterable[str]) -> None:
+        node_ids = set(node_ids)
+        for node_id in set(self.owners.values()) - node_ids:
+            self.remove(node_id)
+        for node_id in node_ids:
+            if node_id not in self:
+                self.add(node_id)
+
+    def get(self, key: str) -> Union[None, str]:
+        if not self.keys:
+            return None
+        i = bisect.bisect(self.keys, self.hash(key)) % len(self.keys)
+        return self.owners[self.keys[i]]
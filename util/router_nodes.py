@@ -0,0 +1,168 @@
+import asyncio
+from pathlib import Path
+from typing import Dict, Set, Tuple, Union
+
+from config import RouterConfig as Config
+from util.router_cosmic import console, Cosmic
+from util.router_hash_ring import HashRing
+
+
+'''
+服务端节点的管理
+
+节点列表写在 router-nodes.txt 里，每行一个节点：
+
+    地址:端口    流量类型    [drain]
+
+流量类型是 mic、file，用逗号分隔，表示这个节点接收麦克风听写还是文件转录。
+行尾加上 drain 表示排空：不再分配新任务，已有任务继续完成。
+从文件中删掉的节点同样先排空，任务全部结束后才移除。
+
+路由进程定时检查文件的修改时间并重新载入，同时对每个节点做健康检查，
+不健康、排空中的节点都不在哈希环上，新任务会落到其余节点。
+'''
+
+
+path_nodes = Path() / Config.nodes_file
+traffic_classes = ('mic', 'file')
+
+
+class Node:
+    def __init__(self, addr: str, port: str, classes: Tuple[str, ...]):
+        self.addr = addr
+        self.port = port
+        self.classes = classes
+        self.healthy = False
+        self.draining = False       # 文件中标记了 drain
+        self.removed = False        # 已从文件中删除
+        self.tasks: Set[str] = set()
+
+    @property
+    def id(self) -> str:
+        return f'{self.addr}:{self.port}'
+
+    @property
+    def url(self) -> str:
+        return f'ws://{self.addr}:{self.port}'
+
+    @property
+    def available(self) -> bool:
+        return self.healthy and not self.draining and not self.removed
+
+
+rings: Dict[str, HashRing] = {c: HashRing(Config.replicas) for c in traffic_classes}
+
+
+def rebuild_rings():
+    for c, ring in rings.items():
+        ring.rebuild(n.id for n in Cosmic.nodes.values()
+                     if n.available and c in n.classes)
+
+
+def pick(task_id: str, source: str) -> Union[None, Node]:
+    # 优先在对应流量类型的节点中选择，没有可用节点时借用另一类的节点
+    for c in (source, *traffic_classes):
+        node_id = rings[c].get(task_id)
+        if node_id:
+            return Cosmic.nodes[node_id]
+    return None
+
+
+def mark_unhealthy(node: Node):
+    if node.healthy:
+        node.healthy = False
+        rebuild_rings()
+        console.print(f'节点离线：{node.id}', style='bright_red')
+
+
+def parse_nodes(text: str) -> Dict[str, Tuple[Tuple[str, ...], bool]]:
+    nodes = {}
+    for line in text.splitlines():
+        line = line.split('#')[0].strip()
+        if not line:
+            continue
+        parts = line.split()
+        node_id = parts[0]
+        classes = tuple(c for c in parts[1].split(',') if c in traffic_classes) \
+            if len(parts) > 1 else traffic_classes
+        draining = 'drain' in parts[2:]
+        nodes[node_id] = (classes, draining)
+    return nodes
+
+
+def load_nodes():
+    if not path_nodes.exists():
+        with open(path_nodes, 'w', encoding='utf-8') as f:
+            f.write('# 在此文件放置服务端节点，每行一个：地址:端口  流量类型（mic、file，逗号分隔）  [drain]\n'
+                    '# 开头带井号表示注释，会被省略；行尾加上 drain 表示排空该节点\n'
+                    '127.0.0.1:6016  mic,file\n')
+    with open(path_nodes, 'r', encoding='utf-8') as f:
+        wanted = parse_nodes(f.read())
+
+    for node_id, (classes, draining) in wanted.items():
+        node = Cosmic.nodes.get(node_id)
+        if node is None:
+            addr, port = node_id.rsplit(':', 1)
+            node = Cosmic.nodes[node_id] = Node(addr, port, classes)
+            console.print(f'添加节点：{node_id}  {",".join(classes)}')
+        if draining and not node.draining:
+            console.print(f'开始排空节点：{node_id}，剩余任务 {len(node.tasks)} 个', style='yellow')
+        node.classes = classes
+        node.draining = draining
+        node.removed = False
+
+    for node in Cosmic.nodes.values():
+        if node.id not in wanted and not node.removed:
+            node.removed = True
+            console.print(f'移除节点：{node.id}，剩余任务 {len(node.tasks)} 个', style='yellow')
+
+    rebuild_rings()
+
+
+async def probe(node: Node) -> bool:
+    # 服务端对 /health 直接返回 200，不升级为 websocket
+    try:
+        reader, writer = await asyncio.wait_for(
+            asyncio.open_connection(node.addr, int(node.port)), Config.health_timeout)
+        try:
+            writer.write(f'GET /health HTTP/1.1\r\nHost: {node.id}\r\n\r\n'.encode())
+            line = await asyncio.wait_for(reader.readline(), Config.health_timeout)
+        finally:
+            writer.close()
+        return line.split(b' ')[1:2] == [b'200']
+    except (OSError, asyncio.TimeoutError):
+        return False
+
+
+async def health_check():
+    mtime = 0
+    while True:
+        # 节点文件被修改就重新载入
+        try:
+            if path_nodes.stat().st_mtime != mtime:
+                mtime = path_nodes.stat().st_mtime
+                load_nodes()
+        except Exception as e:
+            console.print(f'载入节点列表失败：{e}', style='bright_red')
+
+        nodes = list(Cosmic.nodes.values())
+        results = await asyncio.gather(*(probe(n) for n in nodes))
+        changed = False
+        for node, healthy in zip(nodes, results):
+            if healthy != node.healthy:
+                node.healthy = healthy
+                changed = True
+                if healthy:
+                    console.print(f'节点上线：{node.id}', style='green4')
+                else:
+                    console.print(f'节点离线：{node.id}', style='bright_red')
+
+            # 已删除的节点排空后移除
+            if node.removed and not node.tasks:
+                Cosmic.nodes.pop(node.id)
+                changed = True
+                console.print(f'节点已排空并移除：{node.id}')
+        if changed:
+            rebuild_rings()
+
+        await asyncio.sleep(Config.health_interval)
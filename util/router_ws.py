@@ -0,0 +1,209 @@
+import json
+import asyncio
+from typing import Dict, List, Tuple, Union
+
+import websockets
+
+from config import RouterConfig as Config
+from util.router_cosmic import console, Cosmic
+from util.router_nodes import Node, pick, mark_unhealthy
+
+
+'''
+路由进程与客户端、服务端之间的消息转发
+
+每个客户端连接对应一个 Session，Session 为用到的每个节点各开一条上游连接。
+同一个 task_id 的全部消息都发往同一个节点（首条消息按一致性哈希选定后固定下来），
+节点返回的结果原样转发给客户端。
+
+每个任务缓存已转发的消息（不超过 replay_limit），节点掉线时，
+把未完成的任务改派到哈希环上的下一个节点，并重放缓存的消息，从头识别。
+
+服务端按连接缓存音频，一条上游连接同时只能有一个未完成的任务。
+任务分到的节点上，本连接的共用上游已被别的任务占用时（例如故障转移后两个任务落到同一节点），
+为它单独开一条上游连接，任务结束后关闭。
+'''
+
+
+connection_errors = (OSError, asyncio.TimeoutError, websockets.ConnectionClosed,
+                     websockets.InvalidHandshake)
+
+
+class Route:
+    # 一个任务的路由状态
+    def __init__(self, task_id: str, source: str):
+        self.task_id = task_id
+        self.source = source
+        self.node: Union[None, Node] = None
+        self.link: Union[None, Tuple[str, str]] = None    # 所用上游连接：(节点, '') 为共用，(节点, task_id) 为单独
+        self.replay: List[str] = []
+        self.replay_size = 0
+        self.overflow = False       # 缓存超限，无法再重放
+
+    def remember(self, raw: str):
+        if self.overflow:
+            return
+        self.replay_size += len(raw)
+        if self.replay_size > Config.replay_limit * 1024 * 1024:
+            self.overflow = True
+            self.replay.clear()
+        else:
+            self.replay.append(raw)
+
+
+class Session:
+    def __init__(self, websocket):
+        self.websocket = websocket
+        self.upstreams: Dict[Tuple[str, str], websockets.WebSocketClientProtocol] = {}
+        self.readers: Dict[Tuple[str, str], asyncio.Task] = {}
+        self.routes: Dict[str, Route] = {}
+
+        # 客户端消息与故障转移时的重放都要持有锁，保证发往节点的消息顺序不乱
+        self.lock = asyncio.Lock()
+
+    async def forward(self, raw: str):
+        message = json.loads(raw)
+        task_id = message['task_id']
+
+        async with self.lock:
+            route = self.routes.get(task_id)
+            if route is None:
+                route = self.routes[task_id] = Route(task_id, message.get('source', 'file'))
+            route.remember(raw)
+
+            if route.node is None:
+                # 新任务，或者之前没有可用节点：选定节点后重放已缓存的消息
+                if not self.assign(route):
+                    console.print(f'没有可用的节点，任务 {task_id} 暂存', style='bright_red')
+                    if message.get('is_final'):
+                        self.drop(route)
+                    return
+                await self.replay(route)
+            else:
+                await self.send(route, raw)
+
+    def assign(self, route: Route) -> bool:
+        if route.overflow:
+            return False
+        route.node = pick(route.task_id, route.source)
+        if route.node is None:
+            return False
+        route.node.tasks.add(route.task_id)
+
+        # 共用连接上还有别的任务，就单独开一条，免得两个任务的音频混在一起
+        link = (route.node.id, '')
+        if any(r is not route and r.link == link for r in self.routes.values()):
+            link = (route.node.id, route.task_id)
+        route.link = link
+        return True
+
+    async def replay(self, route: Route):
+        node = route.node
+        for raw in list(route.replay):
+            await self.send(route, raw)
+            if route.node is not node:      # 重放途中节点又掉线，已由下一层改派并重放
+                break
+
+    async def send(self, route: Route, raw: str):
+        node = route.node
+        try:
+            ws = await self.upstream(node, route.link)
+            await ws.send(raw)
+        except connection_errors:
+            await self.node_lost(node)
+
+    async def upstream(self, node: Node, link: Tuple[str, str]) -> websockets.WebSocketClientProtocol:
+        ws = self.upstreams.get(link)
+        if ws is None:
+            ws = await asyncio.wait_for(
+                websockets.connect(node.url, subprotocols=['binary'], max_size=None),
+                Config.health_timeout)
+            self.upstreams[link] = ws
+            self.readers[link] = asyncio.create_task(self.read(node, link, ws))
+        return ws
+
+    async def read(self, node: Node, link: Tuple[str, str], ws: websockets.WebSocketClientProtocol):
+        # 把节点返回的结果转发给客户端
+        try:
+            async for raw in ws:
+                message = json.loads(raw)
+                if message.get('is_final'):
+                    route = self.routes.get(message['task_id'])
+                    if route and route.node is node:
+                        self.finish(route)
+                try:
+                    await self.websocket.send(raw)
+                except websockets.ConnectionClosed:
+                    pass
+        except websockets.ConnectionClosed:
+            pass
+
+        # 连接意外断开，视为节点掉线
+        async with self.lock:
+            if self.upstreams.get(link) is ws:
+                await self.node_lost(node)
+
+    async def node_lost(self, node: Node):
+        # 调用者须持有 self.lock
+        for link in [k for k in self.upstreams if k[0] == node.id]:
+            ws = self.upstreams.pop(link)
+            self.readers.pop(link, None)
+            await ws.close()
+        mark_unhealthy(node)
+
+        for route in [r for r in self.routes.values() if r.node is node]:
+            node.tasks.discard(route.task_id)
+            route.node = None
+            if not self.assign(route):
+                console.print(f'任务 {route.task_id} 无法转移，已丢弃', style='bright_red')
+                self.drop(route)
+                continue
+            console.print(f'任务 {route.task_id} 从 {node.id} 转移到 {route.node.id}', style='yellow')
+            await self.replay(route)
+
+    def finish(self, route: Route):
+        node = route.node
+        self.drop(route)
+        if (node.draining or node.removed) and not node.tasks:
+            console.print(f'节点已排空：{node.id}', style='green4')
+
+    def drop(self, route: Route):
+        self.routes.pop(route.task_id, None)
+        if route.node:
+            route.node.tasks.discard(route.task_id)
+
+        # 单独的上游连接随任务关闭；读取协程把最终结果转发完之后自然退出，不取消它
+        link, route.link = route.link, None
+        if link and link[1]:
+            self.readers.pop(link, None)
+            ws = self.upstreams.pop(link, None)
+            if ws:
+                asyncio.create_task(ws.close())
+
+    async def close(self):
+        for route in list(self.routes.values()):
+            self.drop(route)
+        for reader in self.readers.values():
+            reader.cancel()
+        for ws in self.upstreams.values():
+            await ws.close()
+        self.readers.clear()
+        self.upstreams.clear()
+
+
+async def ws_router(websocket):
+    session = Session(websocket)
+    Cosmic.sessions.add(session)
+    console.print(f'接客了：{websocket.remote_address}', style='yellow')
+
+    try:
+        async for raw in websocket:
+            await session.forward(raw)
+        console.print("ConnectionClosed...", )
+    except websockets.ConnectionClosed:
+        console.print("ConnectionClosed...", )
+    except Exception as e:
+        console.print("Exception:", e)
+    finally:
+        Cosmic.sessions.discard(session)
+        await session.close()
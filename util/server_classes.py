@@ -7,7 +7,9 @@ class Task:
                  socket_id: str,
                  is_final: bool,
                  time_start: float,
-                 time_submit: float) -> None:
+                 time_submit: float,
+                 journaled: bool = False,
+                 resume: dict = None) -> None:
         self.source = source
         self.data = data
         self.offset = offset
@@ -18,6 +20,19 @@ class Task:
         self.time_start = time_start
         self.time_submit = time_submit
         self.samplerate = 16000
+        self.journaled = journaled      # 是否已写入任务日志，连接断开也要继续识别
+        self.resume = resume            # 从日志恢复时，此前已得到的结果
+        self.time_denoise = 0.0         # 识别等待降噪的时间
+
+
+class Diarization:
+    def __init__(self, task_id, socket_id) -> None:
+        self.task_id = task_id          # 任务 id
+        self.socket_id = socket_id      # socket id
+        self.progress = 0.0             # 说话人分离进度，0 到 1
+        self.segments = []              # [(开始, 结束, 说话人编号), ...]
+        self.names = {}                 # 从声纹库认出的说话人：{说话人编号: 名字}
+        self.is_final = False           # 是否已完成
 
 
 class Result:
@@ -27,11 +42,15 @@ class Result:
         self.source = source            # 是从 'file' 还是 'mic' 的音频流得到的结果
 
         self.duration = 0               # 全部音频时长
+        self.offset = 0                 # 最近识别的片段的偏移
         self.time_start = 0             # 录音开始的时刻
         self.time_submit = 0            # 片段提交时间
         self.time_complete = 0          # 识别完成时间
+        self.time_denoise = 0           # 降噪增加的延迟（累计）
 
         self.tokens = []                # 字级 token
         self.timestamps = []            # 字级 token 的时间戳
         self.text = ''                  # 合并的文字
+        self.language = ''              # 识别出的语种，未做语种识别时为空
+        self.skipped = []               # 音频事件预筛跳过的区间：[[开始, 结束], ...]
         self.is_final = False           # 是否已完成所有片段识别
@@ -1,11 +1,15 @@
 import sys
 from pathlib import Path
 from multiprocessing import Queue
-from typing import Dict, List
+from typing import Dict, List, Union, TYPE_CHECKING
 import websockets
 from rich.console import Console 
 console = Console(highlight=False)
 
+if TYPE_CHECKING:
+    from util.server_journal import Journal
+    from util.server_classes import Diarization
+
 
 
 
@@ -15,3 +19,9 @@ class Cosmic:
     sockets_id: List
     queue_in = Queue()
     queue_out = Queue()
+    journal: Union[None, 'Journal'] = None      # 文件转录任务的日志
+    owners: Dict[str, str] = {}                 # 客户端重连后接管的任务：task_id -> socket id
+    queue_diarize: Union[None, Queue] = None    # 说话人分离进程的输入队列，未开启时为 None
+    diarizations: Dict[str, Union[None, 'Diarization']] = {}  # 等待说话人分离的任务：task_id -> 分离结果
+    finals: Dict[str, tuple] = {}               # 说话人分离还没完成，先扣下的最终结果：task_id -> (结果, 消息, 扣下的时刻)
+    diarize_seen: Dict[str, float] = {}         # 等待说话人分离的任务最近一次有音频或进度的时刻，用于丢弃过期任务
@@ -0,0 +1,104 @@
+import time
+import threading
+from queue import Queue as ThreadQueue
+from concurrent.futures import ThreadPoolExecutor, Future
+from multiprocessing import Queue
+from pathlib import Path
+
+import numpy as np
+
+from config import ServerConfig as Config
+from config import DenoiseArgs
+from util.server_cosmic import console
+from util.server_classes import Task
+
+
+'''
+降噪前处理
+
+识别进程的主循环不再直接读 queue_in，而是由一个预取线程读取片段，
+交给降噪线程池处理，主循环按原顺序取出降噪后的片段识别。
+降噪与识别在不同线程上重叠进行，只有降噪比识别慢时主循环才需要等待，
+这段等待就是降噪增加的延迟，记入结果的 time_denoise。
+
+估计的信噪比已经足够高时跳过降噪。
+'''
+
+
+def estimate_snr(samples: np.ndarray) -> float:
+    # 20ms 一帧，响的帧当作语音、静的帧当作噪声，估算信噪比（dB）
+    frame = 320
+    n = len(samples) // frame * frame
+    if not n:
+        return float('inf')
+    energy = np.mean(samples[:n].reshape(-1, frame) ** 2, axis=1) + 1e-10
+    noise = np.percentile(energy, 10)
+    speech = np.percentile(energy, 90)
+    return float(10 * np.log10(speech / noise))
+
+
+class Denoiser:
+    def __init__(self):
+        import sherpa_onnx
+        config = sherpa_onnx.OfflineSpeechDenoiserConfig(
+            model=sherpa_onnx.OfflineSpeechDenoiserModelConfig(
+                gtcrn=sherpa_onnx.OfflineSpeechDenoiserGtcrnModelConfig(model=DenoiseArgs.model),
+                num_threads=DenoiseArgs.num_threads,
+            ),
+        )
+        self.denoiser = sherpa_onnx.OfflineSpeechDenoiser(config)
+
+    def process(self, task: Task) -> Task:
+        if task.source not in Config.denoise_sources or not task.data:
+            return task
+        samples = np.frombuffer(task.data, dtype=np.float32)
+        if estimate_snr(samples) >= Config.denoise_snr:
+            return task
+        # 降噪出错时用原始音频识别，不能让异常传到识别主循环，那里会把片段当作没取到而丢掉
+        try:
+            denoised = self.denoiser.run(samples, task.samplerate)
+        except Exception as e:
+            console.print(f'降噪出错，使用原始音频：{e}', style='bright_red')
+            return task
+        task.data = np.asarray(denoised.samples, dtype=np.float32).tobytes()
+        return task
+
+
+class DenoisePipeline:
+    """按顺序输出降噪后的片段，接口与 multiprocessing.Queue 的 get 一样"""
+
+    def __init__(self, queue_in: Queue):
+        self.queue_in = queue_in
+        self.denoiser = Denoiser()
+        self.executor = ThreadPoolExecutor(DenoiseArgs.threads)
+        self.futures: ThreadQueue = ThreadQueue(maxsize=DenoiseArgs.threads * 2)
+        threading.Thread(target=self.prefetch, daemon=True).start()
+
+    def prefetch(self):
+        # 预取线程：提交降噪，按提交顺序排队
+        while True:
+            task = self.queue_in.get()
+            self.futures.put(self.executor.submit(self.denoiser.process, task))
+
+    def get(self, timeout: float) -> Task:
+        future: Future = self.futures.get(timeout=timeout)
+        t1 = time.time()
+        task = future.result()
+        task.time_denoise = time.time() - t1
+        return task
+
+
+def create_source(queue_in: Queue):
+    # 返回识别主循环读取片段的来源：开启降噪时是降噪流水线，否则就是 queue_in
+    if not Config.denoise:
+        return queue_in
+    if not Path(DenoiseArgs.model).exists():
+        console.print(f'[yellow]未找到降噪模型：{DenoiseArgs.model}，不做降噪')
+        return queue_in
+    try:
+        source = DenoisePipeline(queue_in)
+        console.print('[green4]降噪模型载入完成', end='\n\n')
+        return source
+    except Exception as e:
+        console.print(f'降噪模型载入失败：{e}', style='bright_red')
+        return queue_in
@@ -0,0 +1,163 @@
+import time
+import signal
+import bisect
+from pathlib import Path
+from multiprocessing import Queue
+from typing import Dict, List, Tuple
+
+import numpy as np
+
+from config import ServerConfig as Config
+from config import DiarizationArgs
+from util.server_cosmic import console
+from util.server_classes import Task, Diarization
+from util.server_speaker_index import SpeakerIndex, load_extractor, label_speakers
+
+
+'''
+说话人分离子进程
+
+与识别进程并行：主进程把文件任务收到的音频原样转发过来，这里按任务累积，
+收到最后一块后对整段音频做说话人分离（分段模型 + 声纹聚类），
+连接断开等原因等不到最后一块的任务，task_expire 秒没有新音频就丢弃，
+再与声纹库比对，认出已知的说话人，
+进度和结果都放入 queue_out，由 ws_send 与识别结果按字级时间戳合并。
+'''
+
+
+def load_diarizer():
+    import sherpa_onnx
+    config = sherpa_onnx.OfflineSpeakerDiarizationConfig(
+        segmentation=sherpa_onnx.OfflineSpeakerSegmentationModelConfig(
+            pyannote=sherpa_onnx.OfflineSpeakerSegmentationPyannoteModelConfig(
+                model=DiarizationArgs.segmentation),
+            num_threads=DiarizationArgs.num_threads,
+        ),
+        embedding=sherpa_onnx.SpeakerEmbeddingExtractorConfig(
+            model=DiarizationArgs.embedding,
+            num_threads=DiarizationArgs.num_threads,
+        ),
+        clustering=sherpa_onnx.FastClusteringConfig(
+            num_clusters=DiarizationArgs.num_clusters,
+            threshold=DiarizationArgs.threshold,
+        ),
+        min_duration_on=DiarizationArgs.min_duration_on,
+        min_duration_off=DiarizationArgs.min_duration_off,
+    )
+    if not config.validate():
+        raise RuntimeError('说话人分离模型配置有误，请检查 DiarizationArgs 中的模型路径')
+    return sherpa_onnx.OfflineSpeakerDiarization(config)
+
+
+class Speakers:
+    """声纹模型和声纹库，声纹库文件更新后自动重新载入"""
+
+    def __init__(self):
+        self.path = Path(DiarizationArgs.speaker_index)
+        self.mtime = 0
+        self.index = SpeakerIndex(self.path)
+        self.extractor = None
+
+    def label(self, samples, segments):
+        if not self.path.exists():
+            return {}
+        if self.path.stat().st_mtime != self.mtime:
+            self.mtime = self.path.stat().st_mtime
+            self.index = SpeakerIndex(self.path)
+        if self.extractor is None:
+            self.extractor = load_extractor()
+        return label_speakers(self.extractor, self.index, samples, segments)
+
+
+def diarize(diarizer, speakers: Speakers, task: Task, data: bytes, queue_out: Queue) -> Diarization:
+    result = Diarization(task.task_id, task.socket_id)
+    samples = np.frombuffer(data, dtype=np.float32)
+    if diarizer is None or not len(samples):
+        result.is_final = True
+        return result
+
+    # 进度回调由 sherpa_onnx 逐块调用，限制发送频率
+    last = [0.0]
+    def progress_callback(num_processed_chunk: int, num_total_chunks: int) -> int:
+        if time.time() - last[0] > 1:
+            last[0] = time.time()
+            progress = Diarization(task.task_id, task.socket_id)
+            progress.progress = num_processed_chunk / max(num_total_chunks, 1)
+            queue_out.put(progress)
+        return 0
+
+    segments = diarizer.process(samples, callback=progress_callback).sort_by_start_time()
+    result.segments = [(s.start, s.end, s.speaker) for s in segments]
+    result.names = speakers.label(samples, result.segments)
+    result.progress = 1.0
+    result.is_final = True
+    return result
+
+
+def init_diarizer(queue_in: Queue, queue_out: Queue):
+
+    # Ctrl-C 退出
+    signal.signal(signal.SIGINT, lambda signum, frame: exit())
+
+    # 载入失败时仍然回复空结果，避免等待说话人的任务卡住
+    diarizer = None
+    try:
+        diarizer = load_diarizer()
+        console.print('[green4]说话人分离模型载入完成', end='\n\n')
+    except Exception as e:
+        console.print(f'说话人分离模型载入失败：{e}', style='bright_red')
+
+    speakers = Speakers()
+
+    # 各任务累积的音频、最近一次收到音频的时刻
+    caches: Dict[str, bytearray] = {}
+    seen: Dict[str, float] = {}
+
+    while True:
+        deadline = time.time() - Config.task_expire
+        for task_id in [k for k, t in seen.items() if t < deadline]:
+            caches.pop(task_id)
+            seen.pop(task_id)
+
+        try:
+            task: Task = queue_in.get(timeout=1)
+        except:
+            continue
+
+        cache = caches.setdefault(task.task_id, bytearray())
+        cache += task.data
+        seen[task.task_id] = time.time()
+        if not task.is_final:
+            continue
+
+        data = caches.pop(task.task_id)
+        seen.pop(task.task_id)
+        try:
+            result = diarize(diarizer, speakers, task, bytes(data), queue_out)
+        except Exception as e:
+            console.print(f'说话人分离出错：{e}', style='bright_red')
+            result = Diarization(task.task_id, task.socket_id)
+            result.is_final = True
+        queue_out.put(result)
+
+
+def assign_speakers(timestamps: List[float], segments: List[Tuple[float, float, int]]) -> List[int]:
+    """
+    为每个字找到说话人：落在某个说话片段内就取它，
+    落在片段之间就取距离最近的片段；没有片段时为 -1
+    """
+    if not segments:
+        return [-1] * len(timestamps)
+
+    starts = [s[0] for s in segments]
+    speakers = []
+    for t in timestamps:
+        i = bisect.bisect_right(starts, t) - 1
+        candidates = [j for j in (i - 1, i, i + 1) if 0 <= j < len(segments)]
+
+        def distance(j):
+            start, end, _ = segments[j]
+            return 0 if start <= t <= end else min(abs(t - start), abs(t - end))
+
+        speakers.append(segments[min(candidates, key=distance)][2])
+    return speakers
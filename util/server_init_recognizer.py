@@ -7,6 +7,10 @@ from config import ServerConfig as Config
 from config import ParaformerArgs, ModelPaths
 from util.server_cosmic import console
 from util.server_recognize import recognize
+from util.server_language import LanguageRouter
+from util.server_denoise import create_source
+from util.server_tagging import create_filter
+from util.server_tier import create_tier
 from util.empty_working_set import empty_current_working_set
 
 
@@ -37,6 +41,9 @@ def init_recognizer(queue_in: Queue, queue_out: Queue, sockets_id):
     )
     console.print(f'[green4]语音模型载入完成', end='\n\n')
 
+    # 按语种选择模型，未开启语种识别时总是用上面的模型
+    router = LanguageRouter(recognizer)
+
     # 载入标点模型
     punc_model = None
     if Config.format_punc:
@@ -44,6 +51,15 @@ def init_recognizer(queue_in: Queue, queue_out: Queue, sockets_id):
         punc_model = CT_Transformer(ModelPaths.punc_model_dir, quantize=True)
         console.print(f'[green4]标点模型载入完成', end='\n\n')
 
+    # 音频事件预筛，跳过没有人声的区间
+    speech_filter = create_filter()
+
+    # 两级解码，置信度低的片段用慢速模型重新识别
+    tier = create_tier()
+
+    # 降噪在单独的线程中与识别重叠进行，未开启时直接从 queue_in 读取
+    source = create_source(queue_in)
+
     console.print(f'模型加载耗时 {time.time() - t1 :.2f}s', end='\n\n')
 
     # 清空物理内存工作集
@@ -56,13 +72,14 @@ def init_recognizer(queue_in: Queue, queue_out: Queue, sockets_id):
         # 从队列中获取任务消息
         # 阻塞最多1秒，便于中断退出
         try:
-            task = queue_in.get(timeout=1)       
+            task = source.get(timeout=1)
         except:
             continue
 
-        if task.socket_id not in sockets_id:    # 检查任务所属的连接是否存活
+        # 检查任务所属的连接是否存活，写入日志的任务可以等客户端重连后再取结果
+        if task.socket_id not in sockets_id and not task.journaled:
             continue
 
-        result = recognize(recognizer, punc_model, task)   # 执行识别
+        result = recognize(router, punc_model, task, speech_filter, tier)   # 执行识别
         queue_out.put(result)      # 返回结果
 
@@ -0,0 +1,291 @@
+import json
+import mmap
+import os
+import struct
+import time
+import zlib
+from pathlib import Path
+from typing import Dict, List, Union
+
+from config import ServerConfig as Config
+from util.server_classes import Task
+from util.asyncio_to_thread import to_thread
+
+
+'''
+文件转录任务的预写日志
+
+服务端或识别子进程崩溃时，队列中的片段和已识别的部分结果都会丢失，
+客户端会一直等不到最终结果。这里把已接收的片段和已发出的结果追加写入
+一个内存映射的日志文件，重启后据此恢复：
+
+    片段记录：片段的音频和位置，入队之前写入
+    结果记录：识别进程返回的结果，确认偏移不超过它的片段
+    完成记录：最终结果已送达客户端，任务可以丢弃
+    快照记录：压缩日志时，一个任务的状态（最近结果、可续传的位置）
+
+写入只是一次内存拷贝，不等待磁盘，由后台定时刷盘。
+日志写满时扩大文件；大部分记录已过时，就只保留未完成任务的快照和未确认片段，重写日志。
+刷盘和重写日志要写大量音频，放在线程中进行，不阻塞服务麦克风连接的事件循环。
+
+麦克风任务很短，而且音频无法重发，不写日志，不给听写增加任何延迟。
+'''
+
+
+# 记录头：载荷长度、载荷 crc32、记录类型
+header = struct.Struct('<IIB')
+meta_header = struct.Struct('<I')
+
+SEGMENT, RESULT, DONE, SNAPSHOT = 1, 2, 3, 4
+
+
+class Job:
+    """一个文件转录任务在日志中的状态"""
+
+    def __init__(self, task_id: str, source: str, time_active: float):
+        self.task_id = task_id
+        self.source = source
+        self.segments: List[Task] = []      # 已入队、还没有结果的片段
+        self.result: Union[None, dict] = None   # 最近一次发出的结果消息
+        self.resume_offset = 0.0            # 客户端续传时，从音频的第几秒开始发送
+        self.complete = False               # 是否已收到最后一个片段
+        self.time_active = time_active      # 最近一次收到片段或发出结果的时刻，取自日志记录
+
+
+class Journal:
+    def __init__(self, path: Path, size: int):
+        self.path = path
+        self.size = size
+        self.jobs: Dict[str, Job] = {}
+
+        path.parent.mkdir(parents=True, exist_ok=True)
+        if not path.exists():
+            path.touch()
+        self._open()
+        self.tail = self._load()
+
+    # ---------- 写入 ----------
+
+    def append_segment(self, task: Task, resume_offset: float):
+        meta = {
+            'task_id': task.task_id,
+            'source': task.source,
+            'socket_id': task.socket_id,
+            'offset': task.offset,
+            'overlap': task.overlap,
+            'is_final': task.is_final,
+            'time_start': task.time_start,
+            'time_submit': task.time_submit,
+            'resume_offset': resume_offset,
+        }
+        self._write(SEGMENT, meta, task.data)
+        self._apply_segment(meta, task)
+
+    def append_result(self, message: dict, offset: float):
+        meta = {'message': message, 'offset': offset, 'time': time.time()}
+        self._write(RESULT, meta)
+        self._apply_result(meta)
+
+    def append_done(self, task_id: str):
+        meta = {'task_id': task_id}
+        self._write(DONE, meta)
+        self._apply_done(meta)
+
+    def pending_tasks(self) -> List[Task]:
+        # 需要重新识别的片段，每个任务的第一个片段带上此前的结果
+        tasks = []
+        for job in self.jobs.values():
+            for i, segment in enumerate(job.segments):
+                tasks.append(Task(source=segment.source,
+                                  data=segment.data, offset=segment.offset,
+                                  overlap=segment.overlap, task_id=segment.task_id,
+                                  socket_id=segment.socket_id, is_final=segment.is_final,
+                                  time_start=segment.time_start,
+                                  time_submit=segment.time_submit,
+                                  journaled=True,
+                                  resume=job.result if i == 0 else None))
+        return tasks
+
+    # ---------- 维护 ----------
+
+    async def flush(self):
+        # mmap.flush 执行时不释放 GIL，改为在线程中对文件描述符 fsync，
+        # 复制一份描述符，刷盘期间日志扩大或压缩时关闭原文件也不受影响
+        fd = os.dup(self.file.fileno())
+        try:
+            await to_thread(os.fsync, fd)
+        finally:
+            os.close(fd)
+
+    async def maintain(self):
+        # 定时调用：丢弃过期任务，日志过半且大多已过时就压缩，然后刷盘
+        expire = time.time() - Config.journal_expire * 3600
+        for task_id in [j.task_id for j in self.jobs.values() if j.time_active < expire]:
+            self.append_done(task_id)
+        if self.tail > self.size // 2 and self._live_size() < self.tail // 2:
+            await self.compact()
+        await self.flush()
+
+    async def compact(self):
+        # 只保留未完成任务的快照和未确认片段，写入新文件后替换
+        # 在事件循环中记下各任务的状态和此刻的日志末尾，在线程中写新文件，
+        # 写的期间照常追加的记录，替换前原样补到新文件末尾，重放结果不变
+        mark = self.tail
+        jobs = [({
+            'task_id': job.task_id,
+            'source': job.source,
+            'result': job.result,
+            'resume_offset': job.resume_offset,
+            'complete': job.complete,
+            'time_active': job.time_active,
+        }, list(job.segments)) for job in self.jobs.values()]
+        tmp = self.path.with_suffix('.tmp')
+        await to_thread(self._write_snapshot, tmp, jobs)
+
+        with open(tmp, 'ab') as f:
+            f.write(self.map[mark:self.tail])
+            tail = f.tell()
+        self._close()
+        os.replace(tmp, self.path)
+        self._open(max(self.size, tail * 2))
+        self.tail = tail
+
+    def close(self):
+        self.map.flush()
+        self._close()
+
+    # ---------- 内部 ----------
+
+    def _open(self, size: int = 0):
+        self.file = open(self.path, 'r+b')
+        self.size = max(self.size, size, os.fstat(self.file.fileno()).st_size)
+        self.file.truncate(self.size)
+        self.map = mmap.mmap(self.file.fileno(), self.size)
+
+    def _close(self):
+        self.map.close()
+        self.file.close()
+
+    def _grow(self, need: int):
+        # 不刷盘：关闭映射后已写入的内容仍在系统缓存中，由定时刷盘写到磁盘
+        # 扩大文件不写入数据，只是重新映射，在事件循环中进行也很快
+        size = self.size
+        while size - self.tail < need:
+            size *= 2
+        self._close()
+        self._open(size)
+
+    @classmethod
+    def _write_snapshot(cls, path: Path, jobs: list):
+        # 在线程中执行，只读取压缩开始时记下的状态
+        with open(path, 'wb') as f:
+            for meta, segments in jobs:
+                f.write(cls._pack(SNAPSHOT, meta))
+                for task in segments:
+                    f.write(cls._pack(SEGMENT, {
+                        'task_id': task.task_id,
+                        'source': task.source,
+                        'socket_id': task.socket_id,
+                        'offset': task.offset,
+                        'overlap': task.overlap,
+                        'is_final': task.is_final,
+                        'time_start': task.time_start,
+                        'time_submit': task.time_submit,
+                        'resume_offset': meta['resume_offset'],
+                    }, task.data))
+
+    @staticmethod
+    def _pack(kind: int, meta: dict, data: bytes = b'') -> bytes:
+        meta = json.dumps(meta, ensure_ascii=False).encode('utf-8')
+        payload = meta_header.pack(len(meta)) + meta + data
+        return header.pack(len(payload), zlib.crc32(payload), kind) + payload
+
+    def _write(self, kind: int, meta: dict, data: bytes = b''):
+        record = self._pack(kind, meta, data)
+
+        # 留出一个空记录头的位置，作为日志末尾的标记
+        # 写满时只扩大文件，压缩留给定时维护在线程中进行
+        need = len(record) + header.size
+        if self.size - self.tail < need:
+            self._grow(need)
+
+        self.map[self.tail:self.tail + len(record)] = record
+        self.map[self.tail + len(record):self.tail + need] = bytes(header.size)
+        self.tail += len(record)
+
+    def _load(self) -> int:
+        # 逐条读取记录，遇到空记录或校验失败（写到一半时崩溃）就停止
+        pos = 0
+        while pos + header.size <= self.size:
+            length, crc, kind = header.unpack_from(self.map, pos)
+            start, end = pos + header.size, pos + header.size + length
+            if not length or end > self.size:
+                break
+            payload = self.map[start:end]
+            if zlib.crc32(payload) != crc:
+                break
+
+            meta_len, = meta_header.unpack_from(payload, 0)
+            meta = json.loads(payload[meta_header.size:meta_header.size + meta_len])
+            data = payload[meta_header.size + meta_len:]
+            if kind == SEGMENT:
+                self._apply_segment(meta, None, data)
+            elif kind == RESULT:
+                self._apply_result(meta)
+            elif kind == DONE:
+                self._apply_done(meta)
+            elif kind == SNAPSHOT:
+                self._apply_snapshot(meta)
+            pos = end
+        return pos
+
+    def _job(self, task_id: str, source: str, time_active: float) -> Job:
+        # 活跃时间取自记录本身，重启后读日志不会把早已无人过问的任务当成刚活跃过
+        if task_id not in self.jobs:
+            self.jobs[task_id] = Job(task_id, source, time_active)
+        job = self.jobs[task_id]
+        job.time_active = max(job.time_active, time_active)
+        return job
+
+    def _apply_segment(self, meta: dict, task: Union[None, Task], data: bytes = b''):
+        if task is None:
+            task = Task(source=meta['source'],
+                        data=data, offset=meta['offset'],
+                        overlap=meta['overlap'], task_id=meta['task_id'],
+                        socket_id=meta['socket_id'], is_final=meta['is_final'],
+                        time_start=meta['time_start'],
+                        time_submit=meta['time_submit'],
+                        journaled=True)
+        job = self._job(meta['task_id'], meta['source'], meta['time_submit'])
+        job.segments.append(task)
+        job.resume_offset = meta['resume_offset']
+        job.complete = job.complete or meta['is_final']
+
+    def _apply_result(self, meta: dict):
+        # 识别进程重启前后，同一片段可能有两个结果，按偏移确认，而不是按个数
+        message = meta['message']
+        job = self.jobs.get(message['task_id'])
+        if not job:
+            return
+        job.result = message
+        job.time_active = max(job.time_active, meta.get('time', 0))
+        while job.segments and job.segments[0].offset <= meta['offset']:
+            job.segments.pop(0)
+
+    def _apply_done(self, meta: dict):
+        self.jobs.pop(meta['task_id'], None)
+
+    def _apply_snapshot(self, meta: dict):
+        job = self._job(meta['task_id'], meta['source'], meta['time_active'])
+        job.result = meta['result']
+        job.resume_offset = meta['resume_offset']
+        job.complete = meta['complete']
+
+    def _live_size(self) -> int:
+        return sum(len(t.data) for j in self.jobs.values() for t in j.segments)
+
+
+def open_journal() -> Union[None, Journal]:
+    if not Config.journal:
+        return None
+    return Journal(Path(Config.journal_path), Config.journal_size * 1024 * 1024)
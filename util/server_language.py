@@ -0,0 +1,90 @@
+import time
+from pathlib import Path
+from typing import Dict, Tuple
+
+import numpy as np
+
+from config import ServerConfig as Config
+from config import LanguageArgs
+from util.server_cosmic import console
+from util.server_classes import Task
+
+
+'''
+按语种选择识别模型
+
+每个任务只在开头的 lid_seconds 秒音频上做一次语种识别（whisper 的语种识别头），
+结果按任务缓存，之后的片段都交给同一个模型，语种识别的开销与任务时长无关。
+连接断开等原因等不到最后一个片段的任务，缓存 task_expire 秒没有新片段就丢弃。
+识别出的语种在 LanguageArgs.models 中没有对应模型时，使用默认的 Paraformer。
+'''
+
+
+# 模型参数中表示文件路径的键
+model_keys = ('tokens', 'paraformer', 'encoder', 'decoder', 'joiner', 'model')
+
+
+class LanguageRouter:
+    def __init__(self, default):
+        self.default = default
+        self.models: Dict[str, object] = {}     # 语种 -> 识别器
+        self.decisions: Dict[str, str] = {}     # task_id -> 语种
+        self.seen: Dict[str, float] = {}        # task_id -> 最近一次收到片段的时刻
+        self.slid = None
+
+        if not Config.lid:
+            return
+        import sherpa_onnx
+
+        # 载入各语种的模型，模型文件不存在就跳过
+        for lang, (factory, kwargs) in LanguageArgs.models.items():
+            missing = [v for k, v in kwargs.items() if k in model_keys and not Path(v).exists()]
+            if missing:
+                console.print(f'[yellow]未找到 {lang} 模型：{missing[0]}，该语种使用默认模型')
+                continue
+            self.models[lang] = getattr(sherpa_onnx.OfflineRecognizer, factory)(**kwargs)
+            console.print(f'[green4]{lang} 模型载入完成')
+
+        # 语种识别模型
+        if not self.models:
+            return
+        if not Path(LanguageArgs.encoder).exists():
+            console.print(f'[yellow]未找到语种识别模型：{LanguageArgs.encoder}，不做语种识别')
+            return
+        config = sherpa_onnx.SpokenLanguageIdentificationConfig(
+            whisper=sherpa_onnx.SpokenLanguageIdentificationWhisperConfig(
+                encoder=LanguageArgs.encoder,
+                decoder=LanguageArgs.decoder,
+            ),
+            num_threads=LanguageArgs.num_threads,
+        )
+        self.slid = sherpa_onnx.SpokenLanguageIdentification(config)
+        console.print(f'[green4]语种识别模型载入完成', end='\n\n')
+
+    def identify(self, task: Task, samples: np.ndarray) -> str:
+        # 每个任务只识别一次，只看开头一小段；没有音频的片段不作判断
+        if task.task_id in self.decisions:
+            return self.decisions[task.task_id]
+        if not self.slid or not len(samples):
+            return ''
+        stream = self.slid.create_stream()
+        stream.accept_waveform(task.samplerate, samples[:int(Config.lid_seconds * task.samplerate)])
+        lang = self.decisions[task.task_id] = self.slid.compute(stream)
+        return lang
+
+    def pick(self, task: Task, samples: np.ndarray) -> Tuple[object, str]:
+        # 返回 (识别器, 语种)
+        self.expire()
+        lang = self.identify(task, samples)
+        if task.is_final:
+            self.decisions.pop(task.task_id, None)
+            self.seen.pop(task.task_id, None)
+        elif task.task_id in self.decisions:
+            self.seen[task.task_id] = time.time()
+        return self.models.get(lang, self.default), lang
+
+    def expire(self):
+        deadline = time.time() - Config.task_expire
+        for task_id in [k for k, t in self.seen.items() if t < deadline]:
+            self.decisions.pop(task_id, None)
+            self.seen.pop(task_id)
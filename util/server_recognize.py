@@ -8,6 +8,8 @@ from config import ServerConfig as Config
 from util.server_classes import Task, Result
 from util.chinese_itn import chinese_to_num
 from util.format_tools import adjust_space
+from util.native import native
+from util.server_tagging import merge_spans
 from rich import inspect
 
 
@@ -26,7 +28,37 @@ def format_text(text, punc_model):
     return text
 
 
-def recognize(recognizer, punc_model, task: Task):
+def seam_merge(prev_tokens, tokens, timestamps, overlap, duration, has_prev, is_final):
+    """
+    返回本片段要保留的 token 区间 [m, n)
+    prev_tokens 是已有结果末尾的两个 token
+    """
+
+    # 先粗去重，依据：字级时间戳
+    m = n = len(timestamps)
+    for i, timestamp in enumerate(timestamps, start=0):
+        if timestamp > overlap / 2: 
+            m = i
+            break
+    for i, timestamp in enumerate(timestamps, start=1):
+        n = i
+        if timestamp > duration - overlap / 2:
+            break
+    if not has_prev:
+        m = 0
+    if is_final:
+        n = len(timestamps)
+
+    # 再细去重，依据：在端点是否有重复的字
+    if prev_tokens and prev_tokens[-2:] == tokens[m:n][:2]:
+        m += 2
+    elif prev_tokens and prev_tokens[-1:] == tokens[m:n][:1]:
+        m += 1
+
+    return m, n
+
+
+def recognize(router, punc_model, task: Task, speech_filter=None, tier=None):
 
     # inspect({key:value for key, value in task.__dict__.items() if not key.startswith('_') and key != 'data'})
     # todo 清空遗存的任务结果
@@ -35,6 +67,15 @@ def recognize(recognizer, punc_model, task: Task):
     if task.task_id not in results:
         results[task.task_id] = Result(task.task_id, task.socket_id, task.source)
 
+        # 从日志恢复的任务，接上崩溃前已得到的结果
+        if task.resume:
+            result = results[task.task_id]
+            result.duration = task.resume['duration']
+            result.tokens = task.resume['tokens']
+            result.timestamps = task.resume['timestamps']
+            result.text = task.resume['text']
+            result.skipped = task.resume.get('skipped', [])
+
     # 取出结果容器
     result = results[task.task_id]
 
@@ -45,43 +86,63 @@ def recognize(recognizer, punc_model, task: Task):
     if task.is_final:
         result.duration += task.overlap
 
-    # 识别片段
-    stream = recognizer.create_stream()
-    stream.accept_waveform(task.samplerate, samples)
-    recognizer.decode_stream(stream)
+    # 按语种选择模型
+    recognizer, lang = router.pick(task, samples)
+    result.language = lang or result.language
+
+    # 音频事件预筛，只识别有人声的区间（客户端 VAD 可能把整段静音都丢弃了，此时没有音频）
+    spans = [(0, len(samples))] if len(samples) else []
+    if speech_filter and task.source in Config.tagging_sources and len(samples):
+        spans, skipped = speech_filter.split(samples, task.samplerate)
+        result.skipped = merge_spans(result.skipped,
+                                     [[task.offset + a / task.samplerate, task.offset + b / task.samplerate]
+                                      for a, b in skipped])
+
+    # 识别各区间
+    streams = []
+    for a, b in spans:
+        stream = recognizer.create_stream()
+        stream.accept_waveform(task.samplerate, samples[a:b])
+        streams.append(stream)
+    if len(streams) == 1:
+        recognizer.decode_stream(streams[0])
+    elif streams:
+        recognizer.decode_streams(streams)
+
+    # 两级解码：置信度低的区间用慢速模型重新识别（慢速模型只对应默认语种）
+    span_results = [(stream.result.tokens, stream.result.timestamps) for stream in streams]
+    if tier and recognizer is router.default:
+        span_results = tier.refine(task, spans, [stream.result for stream in streams], samples)
+
+    # 拼回片段内的时间；有的模型不输出字级时间戳，就把 token 均匀铺在区间上，以便后面去重
+    tokens, timestamps = [], []
+    for (a, b), (span_tokens, span_timestamps) in zip(spans, span_results):
+        if len(span_timestamps) != len(span_tokens):
+            span_timestamps = [(b - a) / task.samplerate * i / len(span_tokens)
+                               for i in range(len(span_tokens))]
+        tokens += span_tokens
+        timestamps += [t + a / task.samplerate for t in span_timestamps]
 
     # 记录识别时间
+    result.offset = task.offset
     result.time_start = task.time_start
     result.time_submit = task.time_submit
     result.time_complete = time.time()
+    result.time_denoise += task.time_denoise
 
-    # 先粗去重，依据：字级时间戳
-    m = n = len(stream.result.timestamps)
-    for i, timestamp in enumerate(stream.result.timestamps, start=0):
-        if timestamp > task.overlap / 2: 
-            m = i
-            break
-    for i, timestamp in enumerate(stream.result.timestamps, start=1):
-        n = i
-        if timestamp > duration - task.overlap / 2:
-            break
-    if not result.timestamps:
-        m = 0
-    if task.is_final:
-        n = len(stream.result.timestamps)
-
-    # 再细去重，依据：在端点是否有重复的字
-    if result.tokens and result.tokens[-2:] == stream.result.tokens[m:n][:2]:
-        m += 2
-    elif result.tokens and result.tokens[-1:] == stream.result.tokens[m:n][:1]:
-        m += 1
+    # 去重：先依据字级时间戳粗去重，再依据端点处重复的字细去重
+    merge = native.seam_merge if native else seam_merge
+    m, n = merge(result.tokens[-2:], tokens, timestamps,
+                 task.overlap, duration, bool(result.timestamps), task.is_final)
 
     # 最后与先前的结果合并
-    result.timestamps += [t + task.offset for t in stream.result.timestamps[m:n]]
-    result.tokens += [token for token in stream.result.tokens[m:n]]
+    result.timestamps += [t + task.offset for t in timestamps[m:n]]
+    result.tokens += [token for token in tokens[m:n]]
 
-    # token 合并为文本
+    # token 合并为文本，sentencepiece 的 token 以 ▁ 表示词首
     text = ' '.join(result.tokens).replace('@@ ', '')
+    if '▁' in text:
+        text = text.replace(' ', '').replace('▁', ' ').strip()
     text = re.sub('([^a-zA-Z0-9]) (?![a-zA-Z0-9])', r'\1', text)
 
     result.text = text
@@ -0,0 +1,161 @@
+"""
+已知说话人的声纹库
+
+说话人分离只能分出「说话人1、说话人2」，这里把常见参会人的声纹登记到库里，
+分离完成后为每个说话人（聚类）提取一条声纹，与库中的声纹比对，认出名字。
+
+    每个聚类只提取一次：取该说话人最长的若干片段拼接，一次送入声纹模型，
+    所以耗时只与说话人数量有关，与录音时长几乎无关
+    声纹库存为一个 npz 文件：名字列表、归一化后的声纹矩阵、登记次数
+    比对时所有聚类与所有已知说话人一次矩阵乘法算出余弦相似度
+
+登记说话人（音频可以是任何 ffmpeg 能读的格式，可以给多段）：
+
+    python -m util.server_speaker_index 张三 张三-1.mp3 张三-2.wav
+"""
+
+import subprocess
+from pathlib import Path
+from typing import Dict, List, Tuple
+
+import numpy as np
+
+from config import DiarizationArgs
+
+
+samplerate = 16000
+
+
+class SpeakerIndex:
+    def __init__(self, path: Path):
+        self.path = path
+        self.names: List[str] = []
+        self.vectors = np.zeros((0, 0), dtype=np.float32)   # 每行一个归一化的声纹
+        self.counts = np.zeros(0, dtype=np.int32)           # 每个声纹由几段音频平均而来
+        if path.exists():
+            with np.load(path) as f:
+                self.names = [str(n) for n in f['names']]
+                self.vectors = f['vectors'].astype(np.float32)
+                self.counts = f['counts']
+
+    def __len__(self):
+        return len(self.names)
+
+    def save(self):
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        np.savez_compressed(self.path, names=np.array(self.names),
+                            vectors=self.vectors.astype(np.float16),
+                            counts=self.counts)
+
+    def add(self, name: str, embedding: np.ndarray):
+        # 同名的说话人取各次登记的平均
+        v = normalize(embedding)
+        if name in self.names:
+            i = self.names.index(name)
+            n = self.counts[i]
+            self.vectors[i] = normalize(self.vectors[i] * n + v)
+            self.counts[i] = n + 1
+            return
+        if not len(self.names):
+            self.vectors = v[None, :]
+        else:
+            self.vectors = np.vstack([self.vectors, v])
+        self.names.append(name)
+        self.counts = np.append(self.counts, 1)
+
+    def best_matches(self, embeddings: np.ndarray, threshold: float) -> List[str]:
+        """
+        为每条声纹找到名字，找不到时为空字符串
+        按相似度从高到低分配，同一个名字只给一个聚类
+        """
+        names = [''] * len(embeddings)
+        if not len(self.names) or not len(embeddings):
+            return names
+
+        scores = normalize(embeddings) @ self.vectors.T
+        used = set()
+        for flat in np.argsort(scores, axis=None)[::-1]:
+            i, j = np.unravel_index(flat, scores.shape)
+            if scores[i, j] < threshold:
+                break
+            if names[i] or j in used:
+                continue
+            names[i] = self.names[j]
+            used.add(j)
+        return names
+
+
+def normalize(v: np.ndarray) -> np.ndarray:
+    norm = np.linalg.norm(v, axis=-1, keepdims=True)
+    return (v / np.maximum(norm, 1e-10)).astype(np.float32)
+
+
+def load_extractor():
+    import sherpa_onnx
+    config = sherpa_onnx.SpeakerEmbeddingExtractorConfig(
+        model=DiarizationArgs.embedding,
+        num_threads=DiarizationArgs.num_threads,
+    )
+    return sherpa_onnx.SpeakerEmbeddingExtractor(config)
+
+
+def compute_embedding(extractor, samples: np.ndarray) -> np.ndarray:
+    stream = extractor.create_stream()
+    stream.accept_waveform(samplerate, samples)
+    stream.input_finished()
+    return np.array(extractor.compute(stream), dtype=np.float32)
+
+
+def cluster_embeddings(extractor, samples: np.ndarray,
+                       segments: List[Tuple[float, float, int]]) -> Dict[int, np.ndarray]:
+    # 每个说话人取最长的片段拼接，最多 speaker_seconds 秒，只提取一次声纹
+    clusters: Dict[int, List[Tuple[float, float]]] = {}
+    for start, end, speaker in segments:
+        clusters.setdefault(speaker, []).append((start, end))
+
+    embeddings = {}
+    for speaker, spans in clusters.items():
+        pieces, total = [], 0
+        for start, end in sorted(spans, key=lambda s: s[0] - s[1]):
+            piece = samples[int(start * samplerate):int(end * samplerate)]
+            pieces.append(piece)
+            total += len(piece)
+            if total >= DiarizationArgs.speaker_seconds * samplerate:
+                break
+        if total:
+            embeddings[speaker] = compute_embedding(extractor, np.concatenate(pieces))
+    return embeddings
+
+
+def label_speakers(extractor, index: SpeakerIndex, samples: np.ndarray,
+                   segments: List[Tuple[float, float, int]]) -> Dict[int, str]:
+    # 返回 {说话人编号: 名字}，只包含认出来的说话人
+    if extractor is None or not len(index) or not segments:
+        return {}
+    embeddings = cluster_embeddings(extractor, samples, segments)
+    speakers = list(embeddings)
+    names = index.best_matches(np.stack([embeddings[s] for s in speakers]),
+                               DiarizationArgs.speaker_threshold)
+    return {s: n for s, n in zip(speakers, names) if n}
+
+
+def read_audio(file: Path) -> np.ndarray:
+    # ffmpeg 输出采样率 16000，单声道，float32 格式
+    ffmpeg_cmd = ["ffmpeg", "-i", file, "-f", "f32le", "-ac", "1", "-ar", "16000", "-"]
+    process = subprocess.Popen(ffmpeg_cmd, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+    return np.frombuffer(process.stdout.read(), dtype=np.float32)
+
+
+def main(name: str, files: List[Path]):
+    extractor = load_extractor()
+    index = SpeakerIndex(Path(DiarizationArgs.speaker_index))
+    for file in files:
+        index.add(name, compute_embedding(extractor, read_audio(file)))
+        print(f'已登记：{name}  {file}')
+    index.save()
+    print(f'声纹库共 {len(index)} 人：{"、".join(index.names)}')
+
+
+if __name__ == '__main__':
+    import typer
+    typer.run(main)
@@ -0,0 +1,94 @@
+from pathlib import Path
+from typing import List, Tuple, Union
+
+import numpy as np
+
+from config import ServerConfig as Config
+from config import TaggingArgs
+from util.server_cosmic import console
+
+
+'''
+音频事件预筛
+
+把片段切成 tagging_window 秒的粗粒度窗口，用音频事件模型（AudioSet 标签）判断每个窗口
+是不是人声。没有人声的窗口（音乐、等待音、纯静音……）不送入识别，
+只把有人声的区间分别解码，跳过的区间记入结果的 skipped。
+'''
+
+
+Span = Tuple[int, int]      # 采样点区间 [开始, 结束)
+
+
+def is_speech_label(name: str) -> bool:
+    return 'speech' in name.lower() or name in ('Conversation', 'Narration, monologue', 'Whispering')
+
+
+class SpeechFilter:
+    def __init__(self):
+        import sherpa_onnx
+        config = sherpa_onnx.AudioTaggingConfig(
+            model=sherpa_onnx.AudioTaggingModelConfig(
+                zipformer=sherpa_onnx.OfflineZipformerAudioTaggingModelConfig(model=TaggingArgs.model),
+                num_threads=TaggingArgs.num_threads,
+            ),
+            labels=TaggingArgs.labels,
+            top_k=TaggingArgs.top_k,
+        )
+        self.tagger = sherpa_onnx.AudioTagging(config)
+
+    def speech_prob(self, samples: np.ndarray, samplerate: int) -> float:
+        stream = self.tagger.create_stream()
+        stream.accept_waveform(samplerate, samples)
+        events = self.tagger.compute(stream, TaggingArgs.top_k)
+        return max((e.prob for e in events if is_speech_label(e.name)), default=0.0)
+
+    def split(self, samples: np.ndarray, samplerate: int) -> Tuple[List[Span], List[Span]]:
+        """返回 (有人声的区间, 跳过的区间)，人声区间两端各留出 tagging_padding 秒"""
+        window = int(Config.tagging_window * samplerate)
+        padding = int(Config.tagging_padding * samplerate)
+        speech = []
+        for start in range(0, len(samples), window):
+            end = min(start + window, len(samples))
+            if self.speech_prob(samples[start:end], samplerate) < Config.tagging_threshold:
+                continue
+            start, end = max(0, start - padding), min(len(samples), end + padding)
+            if speech and start <= speech[-1][1]:
+                speech[-1] = (speech[-1][0], end)
+            else:
+                speech.append((start, end))
+
+        skipped, cursor = [], 0
+        for start, end in speech:
+            if start > cursor:
+                skipped.append((cursor, start))
+            cursor = end
+        if cursor < len(samples):
+            skipped.append((cursor, len(samples)))
+        return speech, skipped
+
+
+def create_filter() -> Union[None, SpeechFilter]:
+    if not Config.tagging:
+        return None
+    if not Path(TaggingArgs.model).exists():
+        console.print(f'[yellow]未找到音频事件模型：{TaggingArgs.model}，不做预筛')
+        return None
+    try:
+        speech_filter = SpeechFilter()
+        console.print('[green4]音频事件模型载入完成', end='\n\n')
+        return speech_filter
+    except Exception as e:
+        console.print(f'音频事件模型载入失败：{e}', style='bright_red')
+        return None
+
+
+def merge_spans(spans: List[List[float]], new: List[List[float]]) -> List[List[float]]:
+    # 合并秒数区间，片段重叠部分会被报告两次
+    out = []
+    for start, end in sorted(spans + new):
+        if out and start <= out[-1][1]:
+            out[-1][1] = max(out[-1][1], end)
+        else:
+            out.append([start, end])
+    return out
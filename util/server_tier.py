@@ -0,0 +1,203 @@
+import time
+from pathlib import Path
+from typing import Dict, List, Sequence, Tuple, Union
+
+import numpy as np
+
+from config import ServerConfig as Config
+from config import TierArgs
+from util.server_classes import Task
+from util.server_cosmic import console
+
+
+'''
+置信度分级的两级解码
+
+所有区间先用快速模型识别，再按 token 级信号给每个区间打置信度：
+    模型输出 token 概率时（Transducer、CTC），用平均概率和低概率 token 的比例
+    否则（Paraformer）用结构性信号：语速是否在正常范围、有没有同一个词反复出现、有没有未知字
+
+置信度低于 tier_threshold 的区间，用 TierArgs 中更慢更准的模型重新识别。
+打分和重新识别都以约 TierArgs.window 秒的窗口为单位，在字间停顿处切开。
+每个任务重新识别的音频不超过已收到音频的 tier_budget，超出预算的低置信度窗口保留快速结果。
+大部分区间只走快速路径，慢速模型只花在最可能出错的少数区间上。
+连接断开等原因等不到最后一个片段的任务，预算记录 task_expire 秒没有新片段就丢弃。
+'''
+
+
+model_keys = ('tokens', 'paraformer', 'encoder', 'decoder', 'joiner', 'model', 'lm')
+
+
+def repeat_ratio(tokens: Sequence[str]) -> float:
+    """落在连续重复 repeat_min 次以上的 n-gram（n ≤ 4）中的 token 比例，识别出错时常见这种循环"""
+    n_tokens = len(tokens)
+    marked = [False] * n_tokens
+    for n in range(1, 5):
+        i = 0
+        while i + n <= n_tokens:
+            gram = tokens[i:i + n]
+            j = i + n
+            while j + n <= n_tokens and tokens[j:j + n] == gram:
+                j += n
+            if (j - i) // n >= TierArgs.repeat_min:
+                for k in range(i, j):
+                    marked[k] = True
+                i = j
+            else:
+                i += 1
+    return sum(marked) / n_tokens if n_tokens else 0.0
+
+
+def confidence(tokens: Sequence[str], timestamps: Sequence[float], log_probs=None) -> float:
+    """区间识别结果的置信度，0 到 1"""
+    if not tokens:
+        # 没有识别出字，慢速模型多半也没有，不值得花预算
+        return 1.0
+
+    # 有 token 概率就直接用
+    if log_probs is not None and len(log_probs) == len(tokens):
+        probs = np.exp(np.asarray(log_probs, dtype=np.float64))
+        low = float(np.mean(probs < 0.5))
+        return float(np.mean(probs)) * (1 - low)
+
+    penalty = 0.0
+
+    # 语速：字之间的平均间隔换算成每秒字数
+    if len(timestamps) >= 2 and timestamps[-1] > timestamps[0]:
+        rate = (len(timestamps) - 1) / (timestamps[-1] - timestamps[0])
+        if rate > TierArgs.rate_max:
+            penalty += min(1.0, rate / TierArgs.rate_max - 1)
+        elif rate < TierArgs.rate_min:
+            penalty += min(1.0, 1 - rate / TierArgs.rate_min)
+
+    # 同一个词反复出现
+    penalty += repeat_ratio(tokens)
+
+    # 未知字
+    penalty += sum(1 for t in tokens if t in ('<unk>', '<UNK>')) / len(tokens)
+
+    return max(0.0, 1.0 - penalty)
+
+
+def split_windows(tokens: Sequence[str], timestamps: Sequence[float], a: int, b: int, samplerate: int) -> List[tuple]:
+    """
+    把区间 [a, b) 的识别结果切成约 window 秒的窗口，返回 [(token 起, token 止, 采样起, 采样止), ...]
+    优先在字间停顿处切开，没有停顿时到两倍窗口长度强行切开；没有时间戳时整个区间作为一个窗口
+    """
+    n = len(tokens)
+    if not n:
+        return []
+    if len(timestamps) != n:
+        return [(0, n, a, b)]
+
+    cuts = [0]
+    for i in range(1, n):
+        length = timestamps[i] - timestamps[cuts[-1]]
+        pause = timestamps[i] - timestamps[i - 1] >= 0.3
+        if (length >= TierArgs.window and pause) or length >= 2 * TierArgs.window:
+            cuts.append(i)
+
+    def cut_sample(i):
+        # 切在两个字之间，离后一个字的开头不超过 0.15 秒
+        t = max((timestamps[i - 1] + timestamps[i]) / 2, timestamps[i] - 0.15)
+        return a + int(t * samplerate)
+
+    bounds = [a] + [cut_sample(i) for i in cuts[1:]] + [b]
+    return [(i, j, bounds[k], bounds[k + 1]) for k, (i, j) in enumerate(zip(cuts, cuts[1:] + [n]))]
+
+
+class TierDecoder:
+    def __init__(self, recognizer):
+        self.recognizer = recognizer
+        self.used: Dict[str, float] = {}        # task_id -> 已重新识别的秒数
+        self.total: Dict[str, float] = {}       # task_id -> 已收到的秒数
+        self.seen: Dict[str, float] = {}        # task_id -> 最近一次收到片段的时刻
+
+    def refine(self, task: Task, spans: List[tuple], results: list, samples: np.ndarray) -> List[Tuple[list, list]]:
+        """
+        对置信度低的窗口用慢速模型重新识别
+        spans 与 results（快速模型的识别结果）一一对应，返回每个区间最终的 (tokens, timestamps)，时间相对区间开头
+        """
+        out = [(list(r.tokens), list(r.timestamps)) for r in results]
+        if task.source not in Config.tier_sources:
+            return out
+
+        self.expire()
+        task_id = task.task_id
+        sr = task.samplerate
+        self.seen[task_id] = time.time()
+        total = self.total[task_id] = self.total.get(task_id, 0.0) + len(samples) / sr
+        used = self.used.get(task_id, 0.0)
+
+        # 给各窗口打分，找出置信度低的
+        candidates = []
+        for k, (r, (a, b)) in enumerate(zip(results, spans)):
+            log_probs = getattr(r, 'ys_log_probs', None)
+            if log_probs is not None and len(log_probs) != len(r.tokens):
+                log_probs = None
+            for i, j, wa, wb in split_windows(r.tokens, r.timestamps, a, b, sr):
+                lp = log_probs[i:j] if log_probs is not None else None
+                score = confidence(r.tokens[i:j], r.timestamps[i:j], lp)
+                if score < Config.tier_threshold:
+                    candidates.append((score, k, i, j, wa, wb))
+
+        # 置信度从低到高，在预算内依次重新识别
+        replacements: Dict[int, list] = {}
+        for score, k, i, j, wa, wb in sorted(candidates):
+            seconds = (wb - wa) / sr
+            if used + seconds > Config.tier_budget * total:
+                continue
+            used += seconds
+
+            stream = self.recognizer.create_stream()
+            stream.accept_waveform(sr, samples[wa:wb])
+            self.recognizer.decode_stream(stream)
+            tokens, timestamps = list(stream.result.tokens), list(stream.result.timestamps)
+            if len(timestamps) != len(tokens):
+                timestamps = [seconds * m / len(tokens) for m in range(len(tokens))]
+            offset = (wa - spans[k][0]) / sr
+            replacements.setdefault(k, []).append((i, j, tokens, [t + offset for t in timestamps]))
+
+        # 从后往前替换，前面窗口的 token 下标不受影响
+        # 替换会改变 token 个数，是否带时间戳要在替换前判断一次
+        for k, items in replacements.items():
+            tokens, timestamps = out[k]
+            has_timestamps = len(timestamps) == len(tokens)
+            for i, j, new_tokens, new_timestamps in sorted(items, reverse=True):
+                tokens[i:j] = new_tokens
+                if has_timestamps:
+                    timestamps[i:j] = new_timestamps
+            out[k] = (tokens, timestamps)
+
+        self.used[task_id] = used
+        if task.is_final:
+            self.used.pop(task_id, None)
+            self.total.pop(task_id, None)
+            self.seen.pop(task_id, None)
+            if used:
+                console.print(f'    两级解码：重新识别 {used:.1f}s / {total:.1f}s')
+        return out
+
+    def expire(self):
+        deadline = time.time() - Config.task_expire
+        for task_id in [k for k, t in self.seen.items() if t < deadline]:
+            self.used.pop(task_id, None)
+            self.total.pop(task_id, None)
+            self.seen.pop(task_id)
+
+
+def create_tier() -> Union[None, TierDecoder]:
+    if not Config.tier:
+        return None
+    missing = [v for k, v in TierArgs.kwargs.items() if k in model_keys and v and not Path(v).exists()]
+    if missing:
+        console.print(f'[yellow]未找到两级解码的慢速模型：{missing[0]}，只用快速模型识别')
+        return None
+    try:
+        import sherpa_onnx
+        recognizer = getattr(sherpa_onnx.OfflineRecognizer, TierArgs.factory)(**TierArgs.kwargs)
+        console.print('[green4]两级解码慢速模型载入完成', end='\n\n')
+        return TierDecoder(recognizer)
+    except Exception as e:
+        console.print(f'两级解码慢速模型载入失败：{e}', style='bright_red')
+        return None
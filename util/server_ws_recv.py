@@ -3,8 +3,10 @@ import time
 import base64 
 import asyncio
 import websockets
+from http import HTTPStatus
 from base64 import b64decode
 
+from config import ServerConfig as Config
 from util.server_cosmic import console, Cosmic
 from util.server_classes import Task, Result
 from util.my_status import Status
@@ -20,11 +22,17 @@ class Cache:
         self.frame_num = 0
 
 
+def submit(task: Task, resume_offset: float):
+    # 文件任务先写日志再入队，崩溃后可以恢复；麦克风任务直接入队
+    if task.source == 'file' and Cosmic.journal:
+        task.journaled = True
+        Cosmic.journal.append_segment(task, resume_offset)
+    Cosmic.queue_in.put(task)
+
+
 async def message_handler(websocket, message, cache: Cache):
     """处理得到的音频流数据"""
 
-    queue_in = Cosmic.queue_in
-
     global status_mic
     source = message['source']
     is_final = message['is_final']
@@ -46,6 +54,19 @@ async def message_handler(websocket, message, cache: Cache):
     cache.chunks += data
     cache.frame_num += len(data)
 
+    # 要标注说话人的文件任务，音频同时转发给说话人分离进程
+    if source == 'file' and message.get('diarize') and Cosmic.queue_diarize:
+        if is_start and task_id not in Cosmic.diarizations:
+            Cosmic.diarizations[task_id] = None
+        if task_id in Cosmic.diarizations:
+            Cosmic.diarize_seen[task_id] = time.time()
+            Cosmic.queue_diarize.put(Task(source=source,
+                                          data=data, offset=0,
+                                          task_id=task_id, socket_id=socket_id,
+                                          overlap=0, is_final=is_final,
+                                          time_start=message['time_start'],
+                                          time_submit=time.time()))
+
     if not is_final:
         # 打印消息
         if source == 'mic':
@@ -64,7 +85,21 @@ async def message_handler(websocket, message, cache: Cache):
                         time_start=message['time_start'],
                         time_submit=time.time())
             cache.offset += seg_duration
-            queue_in.put(task)
+            submit(task, cache.offset)
+
+        # 客户端标记了停顿，且缓冲已足够长，就在停顿处提前切分
+        # 与上面一样保留 overlap 长度的尾巴，供下一片段去重
+        pause_threshold = max(Config.pause_seg_min, seg_overlap * 2)
+        if message.get('is_pause') and len(cache.chunks) / 4 / 16000 >= pause_threshold:
+            task = Task(source=message['source'],
+                        data=cache.chunks, offset=cache.offset,
+                        task_id=task_id, socket_id=socket_id,
+                        overlap=seg_overlap, is_final=False,
+                        time_start=message['time_start'],
+                        time_submit=time.time())
+            cache.offset += len(cache.chunks) / 4 / 16000 - seg_overlap
+            cache.chunks = cache.chunks[-4 * 16000 * seg_overlap:]
+            submit(task, cache.offset)
 
     elif is_final:
         # 打印消息
@@ -80,7 +115,7 @@ async def message_handler(websocket, message, cache: Cache):
                     overlap=seg_overlap, is_final=True,
                     time_start=message['time_start'],
                     time_submit=time.time())
-        queue_in.put(task)
+        submit(task, cache.offset + len(cache.chunks) / 4 / 16000)
 
         # 还原缓冲区、偏移时长
         cache.chunks = b''
@@ -88,6 +123,40 @@ async def message_handler(websocket, message, cache: Cache):
         cache.frame_num = 0
 
 
+async def resume_handler(websocket, message, cache: Cache):
+    """客户端重连后询问任务状态，由这个连接接管任务"""
+
+    task_id = message['task_id']
+    job = Cosmic.journal.jobs.get(task_id) if Cosmic.journal else None
+
+    # 告诉客户端从哪里续传；服务端不认识这个任务时，客户端需要从头发送
+    state = {'type': 'state', 'task_id': task_id, 'received': 0.0, 'complete': False}
+    if job:
+        # 说话人分离的音频没有写日志，续传后不再标注说话人
+        Cosmic.diarizations.pop(task_id, None)
+        Cosmic.finals.pop(task_id, None)
+        Cosmic.owners[task_id] = str(websocket.id)
+        state['received'] = job.resume_offset
+        state['complete'] = job.complete
+        cache.chunks = b''
+        cache.offset = job.resume_offset
+        cache.frame_num = int(job.resume_offset * 16000) * 4
+    console.print(f'客户端续传任务：{task_id}，已接收 {state["received"]:.2f}s')
+    await websocket.send(json.dumps(state))
+
+    # 最终结果已经识别好了，直接补发
+    if job and job.result and job.result['is_final']:
+        await websocket.send(json.dumps(job.result))
+        Cosmic.journal.append_done(task_id)
+        Cosmic.owners.pop(task_id, None)
+
+
+async def health_check(path, request_headers):
+    # 路由进程的健康检查，直接返回 200，不升级为 websocket
+    if path == '/health':
+        return HTTPStatus.OK, [], b'ok\n'
+
+
 async def ws_recv(websocket):
     global status_mic
 
@@ -114,7 +183,10 @@ async def ws_recv(websocket):
             message = json.loads(message)
 
             # 处理数据
-            await message_handler(websocket, message, cache)
+            if message.get('type') == 'resume':
+                await resume_handler(websocket, message, cache)
+            else:
+                await message_handler(websocket, message, cache)
 
         console.print("ConnectionClosed...", )
     except websockets.ConnectionClosed:
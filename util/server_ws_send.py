@@ -1,18 +1,116 @@
 import json 
+import time
 import base64 
 import asyncio
 from multiprocessing import Queue
 
+from config import ServerConfig as Config
 from util.server_cosmic import console, Cosmic
-from util.server_classes import Result
+from util.server_classes import Result, Diarization
+from util.server_init_diarizer import assign_speakers
 from util.asyncio_to_thread import to_thread
 from rich import inspect
 
 
+def find_socket(task_id, socket_id):
+    # 获得 socket，任务可能已被重连的客户端接管
+    socket_id = Cosmic.owners.get(task_id, socket_id)
+    return next(
+        (ws for ws in Cosmic.sockets.values() if str(ws.id) == socket_id),
+        None,
+    )
+
+
+def join_speakers(message, diarization: Diarization):
+    # 把说话人分离的结果对齐到字级时间戳
+    message['speakers'] = assign_speakers(message['timestamps'], diarization.segments)
+    message['segments'] = diarization.segments
+    message['speaker_names'] = {str(k): v for k, v in diarization.names.items()}
+
+
+async def send_diarization(diarization: Diarization):
+    task_id = diarization.task_id
+
+    # 进度直接转发给客户端
+    if not diarization.is_final:
+        if task_id in Cosmic.diarizations:
+            Cosmic.diarize_seen[task_id] = time.time()
+        websocket = find_socket(task_id, diarization.socket_id)
+        if websocket:
+            await websocket.send(json.dumps({
+                'task_id': task_id,
+                'type': 'diarize',
+                'progress': diarization.progress,
+                'is_final': False,
+            }))
+        return
+
+    if task_id not in Cosmic.diarizations:
+        return
+    console.print(f'    说话人分离完成，共 {len({s[2] for s in diarization.segments})} 人', end='')
+    console.print(f'，认出：{"、".join(diarization.names.values())}' if diarization.names else '')
+
+    # 识别先完成了，最终结果在等说话人，合并后发出
+    if task_id in Cosmic.finals:
+        result, message, _ = Cosmic.finals.pop(task_id)
+        Cosmic.diarizations.pop(task_id)
+        join_speakers(message, diarization)
+        await send_result(result, message)
+    else:
+        Cosmic.diarizations[task_id] = diarization
+
+
+async def expire_diarizations(abandon: bool = False):
+    """
+    定时调用：等说话人分离超过 diarize_timeout 的最终结果，不标注说话人直接发出；
+    连接断开等原因等不到最终结果的任务，task_expire 秒没有音频或进度就丢弃。
+    说话人分离进程退出时 abandon 为 True，放弃所有等待中的任务
+    """
+    now = time.time()
+    for task_id, (result, message, parked) in list(Cosmic.finals.items()):
+        if abandon or now - parked > Config.diarize_timeout:
+            Cosmic.finals.pop(task_id)
+            Cosmic.diarizations.pop(task_id, None)
+            console.print(f'[yellow]等不到说话人分离的结果，不标注说话人：{task_id}')
+            try:
+                await send_result(result, message)
+            except Exception as e:
+                print(e)
+
+    # 正常完成的任务已从 diarizations 中移除，这里顺便清掉它们的记录
+    for task_id, seen in list(Cosmic.diarize_seen.items()):
+        if task_id not in Cosmic.diarizations or abandon or now - seen > Config.task_expire:
+            Cosmic.diarizations.pop(task_id, None)
+            Cosmic.diarize_seen.pop(task_id)
+
+
+async def send_result(result: Result, message):
+    websocket = find_socket(result.task_id, result.socket_id)
+    if not websocket:
+        return
+
+    # 发送消息
+    await websocket.send(json.dumps(message))
+
+    # 最终结果已送达，任务可以从日志中丢弃
+    if result.is_final:
+        Cosmic.owners.pop(result.task_id, None)
+        if Cosmic.journal and result.task_id in Cosmic.journal.jobs:
+            Cosmic.journal.append_done(result.task_id)
+
+    if result.source == 'mic':
+        console.print(f'识别结果：\n    [green]{result.text}')
+    elif result.source == 'file':
+        console.print(f'    转录进度：{result.duration:.2f}s', end='\r')
+        if result.is_final:
+            console.print('\n    [green]转录完成')
+            if result.time_denoise:
+                console.print(f'    降噪增加延迟：{result.time_denoise:.2f}s')
+
+
 async def ws_send():
 
     queue_out = Cosmic.queue_out
-    sockets = Cosmic.sockets
 
     while True:
         try:
@@ -23,6 +121,15 @@ async def ws_send():
             if result is None:
                 return
 
+            # 识别进程重启、说话人分离进程启动后的就绪通知
+            if result is True:
+                continue
+
+            # 说话人分离的进度和结果
+            if isinstance(result, Diarization):
+                await send_diarization(result)
+                continue
+
             # 构建消息
             message = {
                 'task_id': result.task_id,
@@ -30,32 +137,28 @@ async def ws_send():
                 'time_start': result.time_start,
                 'time_submit': result.time_submit,
                 'time_complete': result.time_complete,
+                'time_denoise': result.time_denoise,
                 'tokens': result.tokens,
                 'timestamps': result.timestamps,
                 'text': result.text,
+                'language': result.language,
+                'skipped': result.skipped,
                 'is_final': result.is_final,
             }
 
-            # 获得 socket
-            websocket = next(
-                (ws for ws in sockets.values() if str(ws.id) == result.socket_id),
-                None,
-            )
-
-            if not websocket:
-                continue
+            # 文件任务的结果写入日志，客户端断开后重连还能取到
+            if result.source == 'file' and Cosmic.journal and result.task_id in Cosmic.journal.jobs:
+                Cosmic.journal.append_result(message, result.offset)
 
-            # 发送消息
-            await websocket.send(json.dumps(message))
+            # 要标注说话人的任务，等说话人分离完成再发最终结果
+            if result.is_final and result.task_id in Cosmic.diarizations:
+                if Cosmic.diarizations[result.task_id] is None:
+                    Cosmic.finals[result.task_id] = (result, message, time.time())
+                    console.print('\n    识别完成，等待说话人分离')
+                    continue
+                join_speakers(message, Cosmic.diarizations.pop(result.task_id))
 
-            if result.source == 'mic':
-                console.print(f'识别结果：\n    [green]{result.text}')
-            elif result.source == 'file':
-                console.print(f'    转录进度：{result.duration:.2f}s', end='\r')
-                if result.is_final:
-                    console.print('\n    [green]转录完成')
+            await send_result(result, message)
 
         except Exception as e:
             print(e)
-
-
@@ -11,6 +11,8 @@
     
     脚本会找到同文件名的 json 文件，从里面得到字级时间戳，再按照 txt 里面的分行，
     生成正确的 srt 字幕
+
+    json 文件中带有说话人编号时，每条字幕前标注说话人
 """
 
 
@@ -101,7 +103,8 @@ def lines_match_words(text_lines: List[str], words: List) -> List[srt.Subtitle]:
     words[0] = {
                 'start': 0.0,
                 'end' : 5.0,
-                'word' : 'good'
+                'word' : 'good',
+                'speaker': '张三',  # 可选，说话人
                 }
     """
     # 空的字幕列表
@@ -132,6 +135,7 @@ def lines_match_words(text_lines: List[str], words: List) -> List[srt.Subtitle]:
             break
 
         # 初始化
+        first = cursor
         temp_text = re.sub('[,.?，。？、\s]', '', line.lower())
         t1 = words[cursor]['start']
         t2 = words[cursor]['end']
@@ -154,9 +158,12 @@ def lines_match_words(text_lines: List[str], words: List) -> List[srt.Subtitle]:
                     break  # 如果 temp 已清空,则代表本条字幕已完
         
 
-        # 新建字幕
+        # 新建字幕，有说话人就以本句第一个字的说话人标注
+        content = line
+        if words[first].get('speaker'):
+            content = f'[{words[first]["speaker"]}] {line}'
         subtitle = srt.Subtitle(index=index,
-                                content=line,
+                                content=content,
                                 start=timedelta(seconds=t1),
                                 end=timedelta(seconds=t2))
         subtitle_list.append(subtitle)
@@ -178,6 +185,13 @@ def get_words(json_file: Path) -> list:
              for (timestamp, token) in zip(json_info['timestamps'], json_info['tokens'])]
     for i in range(len(words) - 1):
         words[i]['end'] = min(words[i]['end'], words[i+1]['start'])
+
+    # 说话人，声纹库认出的用名字，其余用编号
+    if 'speakers' in json_info:
+        names = json_info.get('speaker_names', {})
+        for word, speaker in zip(words, json_info['speakers']):
+            if speaker >= 0:
+                word['speaker'] = names.get(str(speaker), f'说话人{speaker + 1}')
     
     return words
 